@@ -0,0 +1,40 @@
+﻿// Copyright © 2024 Leonov Maksim. All Rights Reserved.
+
+#include "allocation_counter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+    std::atomic<std::size_t> AllocationCount = 0;
+    std::atomic<std::size_t> AllocatedBytes = 0;
+}
+
+namespace bench
+{
+    std::size_t GetAllocationCount() noexcept { return AllocationCount.load(std::memory_order_relaxed); }
+    std::size_t GetAllocatedBytes() noexcept { return AllocatedBytes.load(std::memory_order_relaxed); }
+}
+
+// Aligned and array forms keep their default implementations, which end up here or in their own aligned pair
+void* operator new(const std::size_t size)
+{
+    AllocationCount.fetch_add(1, std::memory_order_relaxed);
+    AllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    void* memory = std::malloc(size > 0 ? size : 1);
+    if (memory == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+void operator delete(void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
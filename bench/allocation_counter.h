@@ -0,0 +1,12 @@
+﻿// Copyright © 2024 Leonov Maksim. All Rights Reserved.
+
+#pragma once
+
+#include <cstddef>
+
+// The benchmark replaces global operator new to count heap allocations, the counters only grow
+namespace bench
+{
+    [[nodiscard]] std::size_t GetAllocationCount() noexcept;
+    [[nodiscard]] std::size_t GetAllocatedBytes() noexcept;
+}
@@ -0,0 +1,1152 @@
+﻿// Copyright © 2024 Leonov Maksim. All Rights Reserved.
+
+#include "allocation_counter.h"
+
+#include <jreflect/class_type_default.h>
+#include <jreflect/database.h>
+#include <jreflect/graph.h>
+#include <jreflect/object_delta.h>
+#include <jreflect/parallel_serialization.h>
+#include <jreflect/serialization.h>
+
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+namespace bench
+{
+    class base_object : public jreflect::class_interface
+    {
+        JREFLECT_CLASS_TYPE(base_object, true)
+    public:
+        jutils::int32 id = 0;
+        jutils::jstring name;
+    };
+    class middle_object : public base_object
+    {
+        JREFLECT_CLASS_TYPE(middle_object, true)
+    public:
+        jutils::int64 timestamp = 0;
+        base_object* owner = nullptr;
+    };
+    class leaf_object : public middle_object
+    {
+        JREFLECT_CLASS_TYPE(leaf_object, true)
+    public:
+        jutils::uint16 flags = 0;
+        jutils::jarray<jutils::int32> values;
+        std::vector<bool> mask;
+    };
+
+    class record_object : public jreflect::class_interface
+    {
+        JREFLECT_CLASS_TYPE(record_object, true)
+    public:
+        jutils::int32 id = 0;
+        jutils::uint32 flags = 0;
+        jutils::int64 timestamp = 0;
+        jutils::uint64 hash = 0;
+        jutils::int16 x = 0;
+        jutils::int16 y = 0;
+        jutils::jstring name;
+        jutils::jarray<jutils::int32> samples;
+    };
+
+    // Large object, mostly trivial fields that collapse into a few blocks
+    class wide_object : public jreflect::class_interface
+    {
+        JREFLECT_CLASS_TYPE(wide_object, true)
+    public:
+        jutils::int64 v00 = 0, v01 = 0, v02 = 0, v03 = 0, v04 = 0, v05 = 0, v06 = 0, v07 = 0, v08 = 0, v09 = 0, v10 = 0, v11 = 0, v12 = 0, v13 = 0, v14 = 0, v15 = 0, v16 = 0, v17 = 0, v18 = 0, v19 = 0, v20 = 0, v21 = 0, v22 = 0, v23 = 0;
+        jutils::int32 c00 = 0, c01 = 0, c02 = 0, c03 = 0, c04 = 0, c05 = 0, c06 = 0, c07 = 0;
+        jutils::jstring name;
+        jutils::jarray<jutils::int32> samples;
+    };
+
+    class graph_node : public jreflect::class_interface
+    {
+        JREFLECT_CLASS_TYPE(graph_node, true)
+    public:
+        jutils::int32 id = 0;
+        graph_node* next = nullptr;
+        jutils::jarray<graph_node*> edges;
+    };
+
+    // Inheritance chain depth_00 <- depth_01 <- ... <- depth_32, each level adds one field
+    class depth_00 : public jreflect::class_interface
+    {
+        JREFLECT_CLASS_TYPE(depth_00, true)
+    public:
+        jutils::int32 level_00 = 0;
+    };
+#define BENCH_DEPTH_CLASS(Index, ParentIndex)       \
+    class depth_##Index : public depth_##ParentIndex\
+    {                                               \
+        JREFLECT_CLASS_TYPE(depth_##Index, true)    \
+    public:                                         \
+        jutils::int32 level_##Index = 0;            \
+    };
+    BENCH_DEPTH_CLASS(01, 00) BENCH_DEPTH_CLASS(02, 01) BENCH_DEPTH_CLASS(03, 02) BENCH_DEPTH_CLASS(04, 03)
+    BENCH_DEPTH_CLASS(05, 04) BENCH_DEPTH_CLASS(06, 05) BENCH_DEPTH_CLASS(07, 06) BENCH_DEPTH_CLASS(08, 07)
+    BENCH_DEPTH_CLASS(09, 08) BENCH_DEPTH_CLASS(10, 09) BENCH_DEPTH_CLASS(11, 10) BENCH_DEPTH_CLASS(12, 11)
+    BENCH_DEPTH_CLASS(13, 12) BENCH_DEPTH_CLASS(14, 13) BENCH_DEPTH_CLASS(15, 14) BENCH_DEPTH_CLASS(16, 15)
+    BENCH_DEPTH_CLASS(17, 16) BENCH_DEPTH_CLASS(18, 17) BENCH_DEPTH_CLASS(19, 18) BENCH_DEPTH_CLASS(20, 19)
+    BENCH_DEPTH_CLASS(21, 20) BENCH_DEPTH_CLASS(22, 21) BENCH_DEPTH_CLASS(23, 22) BENCH_DEPTH_CLASS(24, 23)
+    BENCH_DEPTH_CLASS(25, 24) BENCH_DEPTH_CLASS(26, 25) BENCH_DEPTH_CLASS(27, 26) BENCH_DEPTH_CLASS(28, 27)
+    BENCH_DEPTH_CLASS(29, 28) BENCH_DEPTH_CLASS(30, 29) BENCH_DEPTH_CLASS(31, 30) BENCH_DEPTH_CLASS(32, 31)
+#undef BENCH_DEPTH_CLASS
+
+    // Class types created at runtime, for databases with more classes than can be declared here
+    class generated_class_type final : public jreflect::class_type
+    {
+    public:
+        explicit generated_class_type(const jutils::jstringID& name) : m_Name(name) {}
+
+        [[nodiscard]] virtual jutils::jstringID getName() const override { return m_Name; }
+        [[nodiscard]] virtual jreflect::class_type* getParent() const override { return nullptr; }
+
+    protected:
+
+        virtual void initializeClassType() override
+        {
+            createField<jutils::int32>("id", offsetof(record_object, id));
+            createField<jutils::int64>("timestamp", offsetof(record_object, timestamp));
+            createField<jutils::jstring>("name", offsetof(record_object, name));
+            createField<jutils::jarray<jutils::int32>>("samples", offsetof(record_object, samples));
+        }
+
+    private:
+
+        jutils::jstringID m_Name;
+    };
+}
+
+JREFLECT_INIT_CLASS_TYPE(bench, base_object, JREFLECT_CLASS_FIELD(id), JREFLECT_CLASS_FIELD(name))
+JREFLECT_INIT_CLASS_TYPE(bench, middle_object, JREFLECT_CLASS_FIELD(timestamp), JREFLECT_CLASS_FIELD(owner))
+JREFLECT_INIT_CLASS_TYPE(bench, leaf_object, JREFLECT_CLASS_FIELD(flags), JREFLECT_CLASS_FIELD(values), JREFLECT_CLASS_FIELD(mask))
+JREFLECT_INIT_CLASS_TYPE(bench, record_object,
+    JREFLECT_CLASS_FIELD(id), JREFLECT_CLASS_FIELD(flags), JREFLECT_CLASS_FIELD(timestamp), JREFLECT_CLASS_FIELD(hash),
+    JREFLECT_CLASS_FIELD(x), JREFLECT_CLASS_FIELD(y), JREFLECT_CLASS_FIELD(name), JREFLECT_CLASS_FIELD(samples)
+)
+JREFLECT_INIT_CLASS_TYPE(bench, wide_object,
+    JREFLECT_CLASS_FIELD(v00), JREFLECT_CLASS_FIELD(v01), JREFLECT_CLASS_FIELD(v02), JREFLECT_CLASS_FIELD(v03), JREFLECT_CLASS_FIELD(v04), JREFLECT_CLASS_FIELD(v05),
+    JREFLECT_CLASS_FIELD(v06), JREFLECT_CLASS_FIELD(v07), JREFLECT_CLASS_FIELD(v08), JREFLECT_CLASS_FIELD(v09), JREFLECT_CLASS_FIELD(v10), JREFLECT_CLASS_FIELD(v11),
+    JREFLECT_CLASS_FIELD(v12), JREFLECT_CLASS_FIELD(v13), JREFLECT_CLASS_FIELD(v14), JREFLECT_CLASS_FIELD(v15), JREFLECT_CLASS_FIELD(v16), JREFLECT_CLASS_FIELD(v17),
+    JREFLECT_CLASS_FIELD(v18), JREFLECT_CLASS_FIELD(v19), JREFLECT_CLASS_FIELD(v20), JREFLECT_CLASS_FIELD(v21), JREFLECT_CLASS_FIELD(v22), JREFLECT_CLASS_FIELD(v23),
+    JREFLECT_CLASS_FIELD(c00), JREFLECT_CLASS_FIELD(c01), JREFLECT_CLASS_FIELD(c02), JREFLECT_CLASS_FIELD(c03), JREFLECT_CLASS_FIELD(c04), JREFLECT_CLASS_FIELD(c05),
+    JREFLECT_CLASS_FIELD(c06), JREFLECT_CLASS_FIELD(c07), JREFLECT_CLASS_FIELD(name), JREFLECT_CLASS_FIELD(samples)
+)
+JREFLECT_INIT_CLASS_TYPE(bench, graph_node, JREFLECT_CLASS_FIELD(id), JREFLECT_CLASS_FIELD(next), JREFLECT_CLASS_FIELD(edges))
+#define BENCH_INIT_DEPTH_CLASS(Index) JREFLECT_INIT_CLASS_TYPE(bench, depth_##Index, JREFLECT_CLASS_FIELD(level_##Index))
+BENCH_INIT_DEPTH_CLASS(00) BENCH_INIT_DEPTH_CLASS(01) BENCH_INIT_DEPTH_CLASS(02) BENCH_INIT_DEPTH_CLASS(03) BENCH_INIT_DEPTH_CLASS(04) BENCH_INIT_DEPTH_CLASS(05)
+BENCH_INIT_DEPTH_CLASS(06) BENCH_INIT_DEPTH_CLASS(07) BENCH_INIT_DEPTH_CLASS(08) BENCH_INIT_DEPTH_CLASS(09) BENCH_INIT_DEPTH_CLASS(10) BENCH_INIT_DEPTH_CLASS(11)
+BENCH_INIT_DEPTH_CLASS(12) BENCH_INIT_DEPTH_CLASS(13) BENCH_INIT_DEPTH_CLASS(14) BENCH_INIT_DEPTH_CLASS(15) BENCH_INIT_DEPTH_CLASS(16) BENCH_INIT_DEPTH_CLASS(17)
+BENCH_INIT_DEPTH_CLASS(18) BENCH_INIT_DEPTH_CLASS(19) BENCH_INIT_DEPTH_CLASS(20) BENCH_INIT_DEPTH_CLASS(21) BENCH_INIT_DEPTH_CLASS(22) BENCH_INIT_DEPTH_CLASS(23)
+BENCH_INIT_DEPTH_CLASS(24) BENCH_INIT_DEPTH_CLASS(25) BENCH_INIT_DEPTH_CLASS(26) BENCH_INIT_DEPTH_CLASS(27) BENCH_INIT_DEPTH_CLASS(28) BENCH_INIT_DEPTH_CLASS(29)
+BENCH_INIT_DEPTH_CLASS(30) BENCH_INIT_DEPTH_CLASS(31) BENCH_INIT_DEPTH_CLASS(32)
+#undef BENCH_INIT_DEPTH_CLASS
+
+namespace
+{
+    using namespace bench;
+
+    jreflect::class_type* GetLeafType()
+    {
+        jreflect::class_type* classType = leaf_object::GetClassType();
+        classType->initialize();
+        return classType;
+    }
+
+    void BM_FindClassType(benchmark::State& state)
+    {
+        const jreflect::database* database = jreflect::database::GetInstanse();
+        const jutils::jstringID name = "leaf_object";
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(database->findClassType(name));
+        }
+    }
+    BENCHMARK(BM_FindClassType);
+
+    std::deque<generated_class_type>& GetGeneratedTypes()
+    {
+        static std::deque<generated_class_type> classTypes;
+        return classTypes;
+    }
+    // class_type_registrar only takes a function, the database calls it once per new registrar, so each call hands out the next type
+    jreflect::class_type* GetNextGeneratedType()
+    {
+        static std::size_t nextIndex = 0;
+        return &GetGeneratedTypes()[nextIndex++];
+    }
+    // Registers generated classes until there are at least count of them, types are never removed
+    const std::deque<generated_class_type>& RegisterGeneratedTypes(const std::size_t count)
+    {
+        static std::deque<jreflect::class_type_registrar> registrars;
+        std::deque<generated_class_type>& classTypes = GetGeneratedTypes();
+        while (classTypes.size() < count)
+        {
+            classTypes.emplace_back(jutils::jstringID(("generated_" + std::to_string(classTypes.size())).c_str()));
+            registrars.emplace_back(&GetNextGeneratedType);
+        }
+        benchmark::DoNotOptimize(jreflect::database::GetInstanse());
+        return classTypes;
+    }
+    jutils::jarray<jutils::jstringID> GetGeneratedNames(const std::size_t count)
+    {
+        const std::deque<generated_class_type>& classTypes = RegisterGeneratedTypes(count);
+        jutils::jarray<jutils::jstringID> names;
+        names.reserve(static_cast<jutils::index_type>(count));
+        for (std::size_t index = 0; index < count; index++)
+        {
+            names.add(classTypes[index].getName());
+        }
+        return names;
+    }
+
+    // Cycles through every registered name, so large tables also pay for cache misses
+    void BM_FindClassTypeScaling(benchmark::State& state)
+    {
+        const jutils::jarray<jutils::jstringID> names = GetGeneratedNames(static_cast<std::size_t>(state.range(0)));
+        const jreflect::database* database = jreflect::database::GetInstanse();
+        jutils::index_type index = 0;
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(database->findClassType(names.get(index)));
+            if (++index == names.getSize())
+            {
+                index = 0;
+            }
+        }
+    }
+    BENCHMARK(BM_FindClassTypeScaling)->RangeMultiplier(10)->Range(100, 100000);
+    // The name map that the perfect hash table replaced
+    void BM_FindClassTypeScalingMap(benchmark::State& state)
+    {
+        const jutils::jarray<jutils::jstringID> names = GetGeneratedNames(static_cast<std::size_t>(state.range(0)));
+        const auto& classTypes = jreflect::database::GetInstanse()->getClassTypes();
+        jutils::index_type index = 0;
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(classTypes.find(names.get(index)));
+            if (++index == names.getSize())
+            {
+                index = 0;
+            }
+        }
+    }
+    BENCHMARK(BM_FindClassTypeScalingMap)->RangeMultiplier(10)->Range(100, 100000);
+
+    // Registers another batch of classes and initializes their fields, registration can't be undone so every run adds
+    // new classes. The database copies its previous table, run it on its own to keep earlier benchmarks out of the numbers
+    void BM_RegisterClassTypes(benchmark::State& state)
+    {
+        const std::size_t count = static_cast<std::size_t>(state.range(0));
+        std::size_t registerAllocations = 0, registerBytes = 0, initAllocations = 0, initBytes = 0;
+        for (auto _ : state)
+        {
+            const std::size_t firstIndex = GetGeneratedTypes().size();
+            std::size_t allocations = GetAllocationCount();
+            std::size_t bytes = GetAllocatedBytes();
+            std::deque<generated_class_type>& classTypes = GetGeneratedTypes();
+            RegisterGeneratedTypes(firstIndex + count);
+            registerAllocations += GetAllocationCount() - allocations;
+            registerBytes += GetAllocatedBytes() - bytes;
+
+            allocations = GetAllocationCount();
+            bytes = GetAllocatedBytes();
+            for (std::size_t index = firstIndex; index < classTypes.size(); index++)
+            {
+                classTypes[index].initialize();
+            }
+            initAllocations += GetAllocationCount() - allocations;
+            initBytes += GetAllocatedBytes() - bytes;
+        }
+        const double classCount = static_cast<double>(state.iterations() * count);
+        state.counters["register_allocs"] = static_cast<double>(registerAllocations) / classCount;
+        state.counters["register_bytes"] = static_cast<double>(registerBytes) / classCount;
+        state.counters["init_allocs"] = static_cast<double>(initAllocations) / classCount;
+        state.counters["init_bytes"] = static_cast<double>(initBytes) / classCount;
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+    BENCHMARK(BM_RegisterClassTypes)->Arg(10000)->Iterations(3)->Unit(benchmark::kMillisecond);
+
+    void BM_FindField(benchmark::State& state)
+    {
+        const jreflect::class_type* classType = GetLeafType();
+        const jutils::jstringID name = "timestamp";
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(classType->findField(name));
+        }
+    }
+    BENCHMARK(BM_FindField);
+    void BM_IsDerivedFrom(benchmark::State& state)
+    {
+        benchmark::DoNotOptimize(jreflect::database::GetInstanse());
+        const jreflect::class_type* classType = GetLeafType();
+        const jreflect::class_type* baseType = base_object::GetClassType();
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(classType->isDerivedFrom(baseType));
+        }
+    }
+    BENCHMARK(BM_IsDerivedFrom);
+
+    // Index is the depth below depth_00, every class in it is initialized
+    jutils::jarray<const jreflect::class_type*> GetDepthChain()
+    {
+        benchmark::DoNotOptimize(jreflect::database::GetInstanse());
+        jutils::jarray<const jreflect::class_type*> chain;
+        for (jreflect::class_type* classType = depth_32::GetClassType(); classType != nullptr; classType = classType->getParent())
+        {
+            classType->initialize();
+            chain.add(classType);
+        }
+        std::reverse(chain.begin(), chain.end());
+        return chain;
+    }
+    // What isDerivedFrom() did before the hierarchy ranges, one virtual call per level
+    bool IsDerivedFromParentChain(const jreflect::class_type* classType, const jreflect::class_type* baseType)
+    {
+        for (; classType != nullptr; classType = classType->getParent())
+        {
+            if (classType == baseType)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+    // Checks against the root, the worst case for the parent walk
+    void BM_IsDerivedFromDepth(benchmark::State& state)
+    {
+        const jutils::jarray<const jreflect::class_type*> chain = GetDepthChain();
+        const jreflect::class_type* classType = chain.get(static_cast<jutils::index_type>(state.range(0)));
+        const jreflect::class_type* baseType = chain.get(0);
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(classType->isDerivedFrom(baseType));
+        }
+    }
+    BENCHMARK(BM_IsDerivedFromDepth)->RangeMultiplier(2)->Range(1, 32);
+    void BM_IsDerivedFromDepthParentChain(benchmark::State& state)
+    {
+        const jutils::jarray<const jreflect::class_type*> chain = GetDepthChain();
+        const jreflect::class_type* classType = chain.get(static_cast<jutils::index_type>(state.range(0)));
+        const jreflect::class_type* baseType = chain.get(0);
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(IsDerivedFromParentChain(classType, baseType));
+        }
+    }
+    BENCHMARK(BM_IsDerivedFromDepthParentChain)->RangeMultiplier(2)->Range(1, 32);
+
+    // Looks up the root field from deeper and deeper classes, the per-level walk probes one map per class
+    void BM_FindFieldDepth(benchmark::State& state)
+    {
+        const jutils::jarray<const jreflect::class_type*> chain = GetDepthChain();
+        const jreflect::class_type* classType = chain.get(static_cast<jutils::index_type>(state.range(0)));
+        const jutils::jstringID name = "level_00";
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(classType->findField(name));
+        }
+    }
+    BENCHMARK(BM_FindFieldDepth)->RangeMultiplier(2)->Range(1, 32);
+    // What callers did before the flattened index: the exact class's fields, then each parent's
+    const jreflect::class_field* FindFieldPerLevel(const jreflect::class_type* classType, const jutils::jstringID& name)
+    {
+        for (; classType != nullptr; classType = classType->getParent())
+        {
+            const jreflect::class_field* field = classType->getFields().find(name);
+            if (field != nullptr)
+            {
+                return field;
+            }
+        }
+        return nullptr;
+    }
+    void BM_FindFieldDepthPerLevel(benchmark::State& state)
+    {
+        const jutils::jarray<const jreflect::class_type*> chain = GetDepthChain();
+        const jreflect::class_type* classType = chain.get(static_cast<jutils::index_type>(state.range(0)));
+        const jutils::jstringID name = "level_00";
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(FindFieldPerLevel(classType, name));
+        }
+    }
+    BENCHMARK(BM_FindFieldDepthPerLevel)->RangeMultiplier(2)->Range(1, 32);
+
+    void BM_GetSetPrimitive(benchmark::State& state)
+    {
+        const jreflect::class_field_entry* field = GetLeafType()->findField("timestamp");
+        const auto* fieldValue = field->fieldValue->cast<jreflect::value_type::int64>();
+        leaf_object object;
+        jutils::int64 value = 0;
+        for (auto _ : state)
+        {
+            fieldValue->set(field->getValuePtr(&object), value + 1);
+            fieldValue->get(field->getValuePtr(&object), value);
+            benchmark::DoNotOptimize(value);
+        }
+    }
+    BENCHMARK(BM_GetSetPrimitive);
+
+    void BM_SetObjectPtr(benchmark::State& state)
+    {
+        benchmark::DoNotOptimize(jreflect::database::GetInstanse());
+        const jreflect::class_field_entry* field = GetLeafType()->findField("owner");
+        const auto* fieldValue = field->fieldValue->cast<jreflect::value_type::object_ptr>();
+        leaf_object object;
+        leaf_object owner;
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(fieldValue->set(field->getValuePtr(&object), &owner));
+        }
+    }
+    BENCHMARK(BM_SetObjectPtr);
+
+    void BM_ArrayAddRemove(benchmark::State& state)
+    {
+        const jreflect::class_field_entry* field = GetLeafType()->findField("values");
+        const auto* fieldValue = field->fieldValue->cast<jreflect::value_type::array>();
+        leaf_object object;
+        void* arrayPtr = field->getValuePtr(&object);
+        const auto count = static_cast<jutils::index_type>(state.range(0));
+        for (auto _ : state)
+        {
+            for (jutils::index_type index = 0; index < count; index++)
+            {
+                *static_cast<jutils::int32*>(fieldValue->add(arrayPtr)) = index;
+            }
+            fieldValue->remove(arrayPtr, 0, count);
+        }
+        state.SetItemsProcessed(state.iterations() * count);
+    }
+    BENCHMARK(BM_ArrayAddRemove)->Arg(16)->Arg(1024);
+
+    void BM_ArrayBoolCount(benchmark::State& state)
+    {
+        const jreflect::class_field_entry* field = GetLeafType()->findField("mask");
+        const auto* fieldValue = field->fieldValue->cast<jreflect::value_type::array_bool>();
+        leaf_object object;
+        object.mask.resize(static_cast<std::size_t>(state.range(0)), true);
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(fieldValue->count(field->getValuePtr(&object)));
+        }
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+    BENCHMARK(BM_ArrayBoolCount)->Arg(64)->Arg(65536)->Arg(100000);
+    // Element-wise versions of the word operations, one checked get/set per flag
+    void BM_ArrayBoolCountPerElement(benchmark::State& state)
+    {
+        const jreflect::class_field_entry* field = GetLeafType()->findField("mask");
+        const auto* fieldValue = field->fieldValue->cast<jreflect::value_type::array_bool>();
+        leaf_object object;
+        object.mask.resize(static_cast<std::size_t>(state.range(0)), true);
+        for (auto _ : state)
+        {
+            const void* valuePtr = field->getValuePtr(&object);
+            jutils::index_type count = 0;
+            bool value = false;
+            for (jutils::index_type index = 0; index < fieldValue->getSize(valuePtr); index++)
+            {
+                count += fieldValue->get(valuePtr, index, value) && value ? 1 : 0;
+            }
+            benchmark::DoNotOptimize(count);
+        }
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+    BENCHMARK(BM_ArrayBoolCountPerElement)->Arg(64)->Arg(65536)->Arg(100000);
+    void BM_ArrayBoolGetWords(benchmark::State& state)
+    {
+        const jreflect::class_field_entry* field = GetLeafType()->findField("mask");
+        const auto* fieldValue = field->fieldValue->cast<jreflect::value_type::array_bool>();
+        leaf_object object;
+        object.mask.resize(static_cast<std::size_t>(state.range(0)), true);
+        std::vector<jutils::uint64> words(static_cast<std::size_t>(fieldValue->GetWordCount(static_cast<jutils::index_type>(state.range(0)))));
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(fieldValue->getWords(field->getValuePtr(&object), words.data()));
+        }
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+    BENCHMARK(BM_ArrayBoolGetWords)->Arg(100000);
+    void BM_ArrayBoolGetWordsPerElement(benchmark::State& state)
+    {
+        const jreflect::class_field_entry* field = GetLeafType()->findField("mask");
+        const auto* fieldValue = field->fieldValue->cast<jreflect::value_type::array_bool>();
+        leaf_object object;
+        object.mask.resize(static_cast<std::size_t>(state.range(0)), true);
+        std::vector<jutils::uint64> words(static_cast<std::size_t>(fieldValue->GetWordCount(static_cast<jutils::index_type>(state.range(0)))));
+        for (auto _ : state)
+        {
+            const void* valuePtr = field->getValuePtr(&object);
+            std::fill(words.begin(), words.end(), 0);
+            bool value = false;
+            for (jutils::index_type index = 0; index < fieldValue->getSize(valuePtr); index++)
+            {
+                if (fieldValue->get(valuePtr, index, value) && value)
+                {
+                    words[static_cast<std::size_t>(index / 64)] |= static_cast<jutils::uint64>(1) << (index % 64);
+                }
+            }
+            benchmark::DoNotOptimize(words.data());
+        }
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+    BENCHMARK(BM_ArrayBoolGetWordsPerElement)->Arg(100000);
+    // Alternating mask, so the result keeps changing and every flag is written
+    void BM_ArrayBoolApplyXor(benchmark::State& state)
+    {
+        const jreflect::class_field_entry* field = GetLeafType()->findField("mask");
+        const auto* fieldValue = field->fieldValue->cast<jreflect::value_type::array_bool>();
+        leaf_object object;
+        object.mask.resize(static_cast<std::size_t>(state.range(0)), true);
+        const jutils::index_type wordCount = fieldValue->GetWordCount(static_cast<jutils::index_type>(state.range(0)));
+        const std::vector<jutils::uint64> mask(static_cast<std::size_t>(wordCount), 0x5555555555555555ull);
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(fieldValue->applyXor(field->getValuePtr(&object), mask.data(), wordCount));
+        }
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+    BENCHMARK(BM_ArrayBoolApplyXor)->Arg(100000);
+    void BM_ArrayBoolApplyXorPerElement(benchmark::State& state)
+    {
+        const jreflect::class_field_entry* field = GetLeafType()->findField("mask");
+        const auto* fieldValue = field->fieldValue->cast<jreflect::value_type::array_bool>();
+        leaf_object object;
+        object.mask.resize(static_cast<std::size_t>(state.range(0)), true);
+        for (auto _ : state)
+        {
+            void* valuePtr = field->getValuePtr(&object);
+            bool value = false;
+            for (jutils::index_type index = 0; index < fieldValue->getSize(valuePtr); index++)
+            {
+                if (fieldValue->get(valuePtr, index, value))
+                {
+                    fieldValue->set(valuePtr, index, value != (index % 2 == 0));
+                }
+            }
+            benchmark::DoNotOptimize(valuePtr);
+        }
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+    BENCHMARK(BM_ArrayBoolApplyXorPerElement)->Arg(100000);
+    // Only the last flag is set, the worst case for both
+    void BM_ArrayBoolFindFirstSet(benchmark::State& state)
+    {
+        const jreflect::class_field_entry* field = GetLeafType()->findField("mask");
+        const auto* fieldValue = field->fieldValue->cast<jreflect::value_type::array_bool>();
+        leaf_object object;
+        object.mask.resize(static_cast<std::size_t>(state.range(0)), false);
+        object.mask.back() = true;
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(fieldValue->findFirstSet(field->getValuePtr(&object)));
+        }
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+    BENCHMARK(BM_ArrayBoolFindFirstSet)->Arg(100000);
+    void BM_ArrayBoolFindFirstSetPerElement(benchmark::State& state)
+    {
+        const jreflect::class_field_entry* field = GetLeafType()->findField("mask");
+        const auto* fieldValue = field->fieldValue->cast<jreflect::value_type::array_bool>();
+        leaf_object object;
+        object.mask.resize(static_cast<std::size_t>(state.range(0)), false);
+        object.mask.back() = true;
+        for (auto _ : state)
+        {
+            const void* valuePtr = field->getValuePtr(&object);
+            jutils::index_type firstSet = jutils::index_invalid;
+            bool value = false;
+            for (jutils::index_type index = 0; index < fieldValue->getSize(valuePtr); index++)
+            {
+                if (fieldValue->get(valuePtr, index, value) && value)
+                {
+                    firstSet = index;
+                    break;
+                }
+            }
+            benchmark::DoNotOptimize(firstSet);
+        }
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+    BENCHMARK(BM_ArrayBoolFindFirstSetPerElement)->Arg(100000);
+
+    record_object CreateRecord()
+    {
+        record_object record;
+        record.id = 7;
+        record.flags = 0x55;
+        record.timestamp = 1234567890123;
+        record.hash = 0xDEADBEEFull;
+        record.x = -3;
+        record.y = 4;
+        record.name = "benchmark record";
+        for (jutils::int32 index = 0; index < 32; index++)
+        {
+            record.samples.add(index * 3);
+        }
+        return record;
+    }
+    // What a caller would write without reflection, using the same writer
+    void WriteRecordByHand(jreflect::binary_writer& writer, const record_object& record)
+    {
+        writer.write(record.id);
+        writer.write(record.flags);
+        writer.write(record.timestamp);
+        writer.write(record.hash);
+        writer.write(record.x);
+        writer.write(record.y);
+        writer.write(static_cast<jutils::uint32>(record.name.getSize()));
+        writer.writeBytes(record.name.getString(), static_cast<std::size_t>(record.name.getSize()));
+        writer.write(record.samples.getSize());
+        writer.writeBytes(record.samples.getData(), static_cast<std::size_t>(record.samples.getSize()) * sizeof(jutils::int32));
+    }
+    bool ReadRecordByHand(jreflect::binary_reader& reader, record_object& record, std::string& nameBuffer)
+    {
+        jutils::uint32 nameSize = 0;
+        if (!reader.read(record.id) || !reader.read(record.flags) || !reader.read(record.timestamp) || !reader.read(record.hash)
+            || !reader.read(record.x) || !reader.read(record.y) || !reader.read(nameSize) || (nameSize > reader.getRemainingSize()))
+        {
+            return false;
+        }
+        nameBuffer.resize(nameSize);
+        reader.readBytes(nameBuffer.data(), nameSize);
+        record.name = jutils::jstring(nameBuffer.data(), static_cast<jutils::index_type>(nameSize));
+        jutils::index_type sampleCount = 0;
+        if (!reader.read(sampleCount) || (sampleCount < 0))
+        {
+            return false;
+        }
+        record.samples.resize(sampleCount);
+        return reader.readBytes(record.samples.getData(), static_cast<std::size_t>(sampleCount) * sizeof(jutils::int32));
+    }
+
+    void BM_WriteObject(benchmark::State& state)
+    {
+        const record_object record = CreateRecord();
+        jutils::jarray<jutils::uint8> buffer;
+        for (auto _ : state)
+        {
+            buffer.clear();
+            jreflect::binary_writer writer(buffer);
+            benchmark::DoNotOptimize(writer.writeObject(&record));
+        }
+        state.SetBytesProcessed(state.iterations() * buffer.getSize());
+    }
+    BENCHMARK(BM_WriteObject);
+    void BM_WriteObjectByHand(benchmark::State& state)
+    {
+        const record_object record = CreateRecord();
+        jutils::jarray<jutils::uint8> buffer;
+        for (auto _ : state)
+        {
+            buffer.clear();
+            jreflect::binary_writer writer(buffer);
+            WriteRecordByHand(writer, record);
+            benchmark::DoNotOptimize(buffer.getData());
+        }
+        state.SetBytesProcessed(state.iterations() * buffer.getSize());
+    }
+    BENCHMARK(BM_WriteObjectByHand);
+    void BM_ReadObject(benchmark::State& state)
+    {
+        const record_object source = CreateRecord();
+        jutils::jarray<jutils::uint8> buffer;
+        jreflect::binary_writer writer(buffer);
+        writer.writeObject(&source);
+        record_object record;
+        for (auto _ : state)
+        {
+            jreflect::binary_reader reader(buffer.getData(), static_cast<std::size_t>(buffer.getSize()));
+            benchmark::DoNotOptimize(reader.readObject(&record));
+        }
+        state.SetBytesProcessed(state.iterations() * buffer.getSize());
+    }
+    BENCHMARK(BM_ReadObject);
+    void BM_ReadObjectByHand(benchmark::State& state)
+    {
+        const record_object source = CreateRecord();
+        jutils::jarray<jutils::uint8> buffer;
+        jreflect::binary_writer writer(buffer);
+        WriteRecordByHand(writer, source);
+        record_object record;
+        std::string nameBuffer;
+        for (auto _ : state)
+        {
+            jreflect::binary_reader reader(buffer.getData(), static_cast<std::size_t>(buffer.getSize()));
+            benchmark::DoNotOptimize(ReadRecordByHand(reader, record, nameBuffer));
+        }
+        state.SetBytesProcessed(state.iterations() * buffer.getSize());
+    }
+    BENCHMARK(BM_ReadObjectByHand);
+
+    // Typed access the way field code does it: cast the shared descriptor by its tag, then get and set
+    template<typename T>
+    void BM_ValueGetSet(benchmark::State& state)
+    {
+        const jreflect::value* valueDesc = jreflect::get_value<T>();
+        T storage{};
+        T value{};
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(valueDesc);
+            const auto* typedValue = valueDesc->cast<jreflect::value_type_v<T>>();
+            typedValue->set(&storage, value);
+            typedValue->get(&storage, value);
+            benchmark::DoNotOptimize(value);
+        }
+    }
+    BENCHMARK_TEMPLATE(BM_ValueGetSet, bool);
+    BENCHMARK_TEMPLATE(BM_ValueGetSet, jutils::int8);
+    BENCHMARK_TEMPLATE(BM_ValueGetSet, jutils::uint8);
+    BENCHMARK_TEMPLATE(BM_ValueGetSet, jutils::int16);
+    BENCHMARK_TEMPLATE(BM_ValueGetSet, jutils::uint16);
+    BENCHMARK_TEMPLATE(BM_ValueGetSet, jutils::int32);
+    BENCHMARK_TEMPLATE(BM_ValueGetSet, jutils::uint32);
+    BENCHMARK_TEMPLATE(BM_ValueGetSet, jutils::int64);
+    BENCHMARK_TEMPLATE(BM_ValueGetSet, jutils::uint64);
+    BENCHMARK_TEMPLATE(BM_ValueGetSet, jutils::jstring);
+    void BM_ValueGetSetObject(benchmark::State& state)
+    {
+        const jreflect::value* valueDesc = jreflect::get_value<base_object>();
+        base_object storage;
+        base_object value;
+        value.id = 3;
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(valueDesc);
+            const auto* typedValue = valueDesc->cast<jreflect::value_type::object>();
+            typedValue->set(&storage, value);
+            const jreflect::class_interface* object = nullptr;
+            typedValue->get(&storage, object);
+            benchmark::DoNotOptimize(object);
+        }
+    }
+    BENCHMARK(BM_ValueGetSetObject);
+    void BM_ValueGetSetObjectPtr(benchmark::State& state)
+    {
+        const jreflect::value* valueDesc = jreflect::get_value<base_object*>();
+        base_object* storage = nullptr;
+        leaf_object target;
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(valueDesc);
+            const auto* typedValue = valueDesc->cast<jreflect::value_type::object_ptr>();
+            typedValue->set(&storage, &target);
+            jreflect::class_interface* object = nullptr;
+            typedValue->get(&storage, object);
+            benchmark::DoNotOptimize(object);
+        }
+    }
+    BENCHMARK(BM_ValueGetSetObjectPtr);
+    void BM_ValueGetSetArray(benchmark::State& state)
+    {
+        const jreflect::value* valueDesc = jreflect::get_value<jutils::jarray<jutils::int32>>();
+        jutils::jarray<jutils::int32> storage;
+        storage.resize(16);
+        jutils::int32 value = 0;
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(valueDesc);
+            const auto* typedValue = valueDesc->cast<jreflect::value_type::array>();
+            *static_cast<jutils::int32*>(typedValue->get(&storage, 5)) = value + 1;
+            value = *static_cast<const jutils::int32*>(typedValue->get(static_cast<const void*>(&storage), 5));
+            benchmark::DoNotOptimize(value);
+        }
+    }
+    BENCHMARK(BM_ValueGetSetArray);
+    void BM_ValueGetSetArrayBool(benchmark::State& state)
+    {
+        const jreflect::value* valueDesc = jreflect::get_value<std::vector<bool>>();
+        std::vector<bool> storage(64);
+        bool value = false;
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(valueDesc);
+            const auto* typedValue = valueDesc->cast<jreflect::value_type::array_bool>();
+            typedValue->set(&storage, 5, !value);
+            typedValue->get(&storage, 5, value);
+            benchmark::DoNotOptimize(value);
+        }
+    }
+    BENCHMARK(BM_ValueGetSetArrayBool);
+    // The tag compare in cast() against the dynamic_cast it replaced
+    void BM_ValueCast(benchmark::State& state)
+    {
+        const jreflect::value* valueDesc = jreflect::get_value<jutils::int32>();
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(valueDesc);
+            benchmark::DoNotOptimize(valueDesc->cast<jreflect::value_type::int32>());
+        }
+    }
+    BENCHMARK(BM_ValueCast);
+    void BM_ValueDynamicCast(benchmark::State& state)
+    {
+        const jreflect::value* valueDesc = jreflect::get_value<jutils::int32>();
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(valueDesc);
+            benchmark::DoNotOptimize(dynamic_cast<const jreflect::value_int32*>(valueDesc));
+        }
+    }
+    BENCHMARK(BM_ValueDynamicCast);
+
+    wide_object CreateWideObject()
+    {
+        wide_object::GetClassType()->initialize();
+        wide_object object;
+        object.v00 = 1;
+        object.v23 = 2;
+        object.c07 = 3;
+        object.name = "wide object";
+        for (jutils::int32 index = 0; index < 64; index++)
+        {
+            object.samples.add(index);
+        }
+        return object;
+    }
+    // What the operations did before field blocks, one value dispatch per field
+    bool CopyObjectPerField(jreflect::class_interface& dst, const jreflect::class_interface& src)
+    {
+        for (const auto& field : src.getClassType()->getFieldTable())
+        {
+            if (!jreflect::copy_value(field.fieldValue, field.getValuePtr(&dst), field.getValuePtr(&src)))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+    bool EqualsObjectPerField(const jreflect::class_interface& object1, const jreflect::class_interface& object2)
+    {
+        for (const auto& field : object1.getClassType()->getFieldTable())
+        {
+            if (!jreflect::equals_value(field.fieldValue, field.getValuePtr(&object1), field.getValuePtr(&object2)))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+    jutils::uint64 HashObjectPerField(const jreflect::class_interface& object)
+    {
+        jutils::uint64 hash = 0;
+        for (const auto& field : object.getClassType()->getFieldTable())
+        {
+            hash = jreflect::hash_value(field.fieldValue, field.getValuePtr(&object), hash);
+        }
+        return hash;
+    }
+
+    void BM_CopyObject(benchmark::State& state)
+    {
+        const wide_object source = CreateWideObject();
+        wide_object object;
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(jreflect::copy_object(object, source));
+        }
+    }
+    BENCHMARK(BM_CopyObject);
+    void BM_CopyObjectPerField(benchmark::State& state)
+    {
+        const wide_object source = CreateWideObject();
+        wide_object object;
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(CopyObjectPerField(object, source));
+        }
+    }
+    BENCHMARK(BM_CopyObjectPerField);
+    void BM_EqualsObject(benchmark::State& state)
+    {
+        const wide_object object1 = CreateWideObject();
+        const wide_object object2 = CreateWideObject();
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(jreflect::equals_object(object1, object2));
+        }
+    }
+    BENCHMARK(BM_EqualsObject);
+    void BM_EqualsObjectPerField(benchmark::State& state)
+    {
+        const wide_object object1 = CreateWideObject();
+        const wide_object object2 = CreateWideObject();
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(EqualsObjectPerField(object1, object2));
+        }
+    }
+    BENCHMARK(BM_EqualsObjectPerField);
+    void BM_HashObject(benchmark::State& state)
+    {
+        const wide_object object = CreateWideObject();
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(jreflect::hash_object(object));
+        }
+    }
+    BENCHMARK(BM_HashObject);
+    void BM_HashObjectPerField(benchmark::State& state)
+    {
+        const wide_object object = CreateWideObject();
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(HashObjectPerField(object));
+        }
+    }
+    BENCHMARK(BM_HashObjectPerField);
+
+    // Changes the first percent of the fields in the field table, the string and the array come last
+    void MutateWideObject(wide_object& object, const jutils::int64 percent)
+    {
+        const auto& fields = wide_object::GetClassType()->getFieldTable();
+        const jutils::index_type count = static_cast<jutils::index_type>(fields.getSize() * percent / 100);
+        for (jutils::index_type index = 0; index < count; index++)
+        {
+            const jreflect::class_field_entry& field = fields.get(index);
+            void* valuePtr = field.getValuePtr(&object);
+            switch (field.fieldValue->getType())
+            {
+            case jreflect::value_type::int64: *static_cast<jutils::int64*>(valuePtr) += 1; break;
+            case jreflect::value_type::int32: *static_cast<jutils::int32*>(valuePtr) += 1; break;
+            case jreflect::value_type::string: object.name = "changed wide object"; break;
+            case jreflect::value_type::array: object.samples.get(0) += 1; break;
+            default: ;
+            }
+        }
+    }
+    // Writes the delta between two states and applies it to a copy of the first one
+    void BM_ObjectDelta(benchmark::State& state)
+    {
+        const wide_object base = CreateWideObject();
+        wide_object current = CreateWideObject();
+        MutateWideObject(current, state.range(0));
+        wide_object object = CreateWideObject();
+        jutils::jarray<jutils::uint8> buffer;
+        for (auto _ : state)
+        {
+            buffer.clear();
+            jreflect::binary_writer writer(buffer);
+            jreflect::write_object_delta(writer, base, current);
+            jreflect::binary_reader reader(buffer.getData(), static_cast<std::size_t>(buffer.getSize()));
+            benchmark::DoNotOptimize(jreflect::read_object_delta(reader, object));
+        }
+        state.counters["delta_bytes"] = static_cast<double>(buffer.getSize());
+    }
+    BENCHMARK(BM_ObjectDelta)->Arg(0)->Arg(5)->Arg(25)->Arg(100);
+    // Resending the whole object
+    void BM_ObjectDeltaFullObject(benchmark::State& state)
+    {
+        const wide_object current = CreateWideObject();
+        wide_object object;
+        jutils::jarray<jutils::uint8> buffer;
+        for (auto _ : state)
+        {
+            buffer.clear();
+            jreflect::binary_writer writer(buffer);
+            writer.writeObject(&current);
+            jreflect::binary_reader reader(buffer.getData(), static_cast<std::size_t>(buffer.getSize()));
+            benchmark::DoNotOptimize(reader.readObject(&object));
+        }
+        state.counters["delta_bytes"] = static_cast<double>(buffer.getSize());
+    }
+    BENCHMARK(BM_ObjectDeltaFullObject);
+
+    const jreflect::class_field_entry* GetRecordField(const char* name)
+    {
+        jreflect::class_type* classType = record_object::GetClassType();
+        classType->initialize();
+        return classType->findField(name);
+    }
+    void BM_GatherValues(benchmark::State& state)
+    {
+        const jreflect::class_field_entry* field = GetRecordField("timestamp");
+        const std::vector<record_object> records(static_cast<std::size_t>(state.range(0)));
+        std::vector<jutils::int64> values(records.size());
+        for (auto _ : state)
+        {
+            field->gatherValues(&records.front(), sizeof(record_object), static_cast<jutils::index_type>(records.size()), values.data());
+            benchmark::DoNotOptimize(values.data());
+        }
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+    BENCHMARK(BM_GatherValues)->Arg(64)->Arg(4096);
+    // The way a caller reads one field from many objects without the batch API
+    void BM_GatherValuesPerObject(benchmark::State& state)
+    {
+        const jreflect::class_field_entry* field = GetRecordField("timestamp");
+        const std::vector<record_object> records(static_cast<std::size_t>(state.range(0)));
+        std::vector<jutils::int64> values(records.size());
+        for (auto _ : state)
+        {
+            const auto* fieldValue = field->fieldValue->cast<jreflect::value_type::int64>();
+            for (std::size_t index = 0; index < records.size(); index++)
+            {
+                fieldValue->get(field->getValuePtr(&records[index]), values[index]);
+            }
+            benchmark::DoNotOptimize(values.data());
+        }
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+    BENCHMARK(BM_GatherValuesPerObject)->Arg(64)->Arg(4096);
+    void BM_ScatterValues(benchmark::State& state)
+    {
+        const jreflect::class_field_entry* field = GetRecordField("timestamp");
+        std::vector<record_object> records(static_cast<std::size_t>(state.range(0)));
+        const std::vector<jutils::int64> values(records.size(), 5);
+        for (auto _ : state)
+        {
+            field->scatterValues(&records.front(), sizeof(record_object), static_cast<jutils::index_type>(records.size()), values.data());
+            benchmark::DoNotOptimize(records.data());
+        }
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+    BENCHMARK(BM_ScatterValues)->Arg(64)->Arg(4096);
+    void BM_ScatterValuesPerObject(benchmark::State& state)
+    {
+        const jreflect::class_field_entry* field = GetRecordField("timestamp");
+        std::vector<record_object> records(static_cast<std::size_t>(state.range(0)));
+        const std::vector<jutils::int64> values(records.size(), 5);
+        for (auto _ : state)
+        {
+            const auto* fieldValue = field->fieldValue->cast<jreflect::value_type::int64>();
+            for (std::size_t index = 0; index < records.size(); index++)
+            {
+                fieldValue->set(field->modifyValuePtr(&records[index]), values[index]);
+            }
+            benchmark::DoNotOptimize(records.data());
+        }
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+    BENCHMARK(BM_ScatterValuesPerObject)->Arg(64)->Arg(4096);
+
+    // Powers of two up to the core count, and at least up to 4 so the threading overhead shows on small machines
+    void ThreadCountArguments(benchmark::internal::Benchmark* benchmark)
+    {
+        const int maxThreadCount = std::max(static_cast<int>(std::thread::hardware_concurrency()), 4);
+        for (int threadCount = 1; threadCount <= maxThreadCount; threadCount *= 2)
+        {
+            benchmark->Arg(threadCount);
+        }
+    }
+
+    constexpr jutils::int32 GraphNodeCount = 1 << 20;
+    // Chain through next, every node also points to three others, built once and shared by the graph benchmarks
+    const std::unique_ptr<graph_node[]>& GetGraph()
+    {
+        static const std::unique_ptr<graph_node[]> nodes = []()
+        {
+            auto graphNodes = std::make_unique<graph_node[]>(GraphNodeCount);
+            for (jutils::int32 index = 0; index < GraphNodeCount; index++)
+            {
+                graph_node& node = graphNodes[index];
+                node.id = index;
+                node.next = index + 1 < GraphNodeCount ? &graphNodes[index + 1] : nullptr;
+                for (jutils::int32 edge = 1; edge <= 3; edge++)
+                {
+                    node.edges.add(&graphNodes[static_cast<jutils::int32>((static_cast<jutils::int64>(index) * 7919 + edge * 104729) % GraphNodeCount)]);
+                }
+            }
+            graph_node::GetClassType()->initialize();
+            return graphNodes;
+        }();
+        return nodes;
+    }
+    void BM_WalkObjectGraph(benchmark::State& state)
+    {
+        jreflect::class_interface* const roots[] = { &GetGraph()[0] };
+        for (auto _ : state)
+        {
+            jreflect::object_visited_set visited(GraphNodeCount);
+            benchmark::DoNotOptimize(jreflect::walk_object_graph(roots, [](jreflect::class_interface*) {}, &visited));
+        }
+        state.SetItemsProcessed(state.iterations() * GraphNodeCount);
+    }
+    BENCHMARK(BM_WalkObjectGraph)->Unit(benchmark::kMillisecond);
+    void BM_WalkObjectGraphParallel(benchmark::State& state)
+    {
+        jreflect::class_interface* const roots[] = { &GetGraph()[0] };
+        const auto threadCount = static_cast<jutils::uint32>(state.range(0));
+        for (auto _ : state)
+        {
+            jreflect::object_visited_set visited(GraphNodeCount);
+            benchmark::DoNotOptimize(jreflect::walk_object_graph_parallel(roots, [](jreflect::class_interface*) {}, threadCount, &visited));
+        }
+        state.SetItemsProcessed(state.iterations() * GraphNodeCount);
+    }
+    BENCHMARK(BM_WalkObjectGraphParallel)->Apply(ThreadCountArguments)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+    constexpr jutils::int32 SavedRecordCount = 200000;
+    struct saved_records
+    {
+        std::unique_ptr<record_object[]> records;
+        jutils::jarray<jreflect::class_interface*> objects;
+    };
+    const saved_records& GetSavedRecords()
+    {
+        static const saved_records savedRecords = []()
+        {
+            saved_records result;
+            result.records = std::make_unique<record_object[]>(SavedRecordCount);
+            result.objects.reserve(SavedRecordCount);
+            for (jutils::int32 index = 0; index < SavedRecordCount; index++)
+            {
+                record_object& record = result.records[index];
+                record = CreateRecord();
+                record.id = index;
+                result.objects.add(&record);
+            }
+            return result;
+        }();
+        return savedRecords;
+    }
+    void BM_WriteObjectsParallel(benchmark::State& state)
+    {
+        const saved_records& savedRecords = GetSavedRecords();
+        const auto threadCount = static_cast<jutils::uint32>(state.range(0));
+        jutils::jarray<jutils::uint8> buffer;
+        for (auto _ : state)
+        {
+            buffer.clear();
+            benchmark::DoNotOptimize(jreflect::write_objects_parallel(savedRecords.objects, buffer, threadCount));
+        }
+        state.SetItemsProcessed(state.iterations() * SavedRecordCount);
+        state.SetBytesProcessed(state.iterations() * buffer.getSize());
+    }
+    BENCHMARK(BM_WriteObjectsParallel)->Apply(ThreadCountArguments)->UseRealTime()->Unit(benchmark::kMillisecond);
+    void BM_ReadObjectsParallel(benchmark::State& state)
+    {
+        const saved_records& savedRecords = GetSavedRecords();
+        const auto threadCount = static_cast<jutils::uint32>(state.range(0));
+        jutils::jarray<jutils::uint8> buffer;
+        jreflect::write_objects_parallel(savedRecords.objects, buffer, threadCount);
+        auto records = std::make_unique<record_object[]>(SavedRecordCount);
+        jutils::jarray<jreflect::class_interface*> objects;
+        objects.reserve(SavedRecordCount);
+        for (jutils::int32 index = 0; index < SavedRecordCount; index++)
+        {
+            objects.add(&records[index]);
+        }
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(jreflect::read_objects_parallel(buffer.getData(), static_cast<std::size_t>(buffer.getSize()), objects, threadCount));
+        }
+        state.SetItemsProcessed(state.iterations() * SavedRecordCount);
+        state.SetBytesProcessed(state.iterations() * buffer.getSize());
+    }
+    BENCHMARK(BM_ReadObjectsParallel)->Apply(ThreadCountArguments)->UseRealTime()->Unit(benchmark::kMillisecond);
+}
@@ -2,7 +2,18 @@
 
 #pragma once
 
+#include "instrumentation.h"
+#include "object_allocator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
 #include <cassert>
+#include <cstring>
+#include <mutex>
+#include <span>
+#include <tuple>
+#include <vector>
 
 #include <jutils/jmap.h>
 #include <jutils/jstringID.h>
@@ -43,6 +54,24 @@ namespace jreflect
         }
         return "NONE";
     }
+    [[nodiscard]] constexpr std::size_t value_type_size(const value_type type)
+    {
+        switch (type)
+        {
+        case value_type::boolean: return sizeof(bool);
+        case value_type::int8:    return sizeof(jutils::int8);
+        case value_type::uint8:   return sizeof(jutils::uint8);
+        case value_type::int16:   return sizeof(jutils::int16);
+        case value_type::uint16:  return sizeof(jutils::uint16);
+        case value_type::int32:   return sizeof(jutils::int32);
+        case value_type::uint32:  return sizeof(jutils::uint32);
+        case value_type::int64:   return sizeof(jutils::int64);
+        case value_type::uint64:  return sizeof(jutils::uint64);
+        default: ;
+        }
+        return 0;
+    }
+    [[nodiscard]] constexpr bool is_trivial_value_type(const value_type type) { return value_type_size(type) > 0; }
 
     template<value_type Type>
     struct value_type_info
@@ -52,14 +81,31 @@ namespace jreflect
     template<typename T>
     struct value_info : std::integral_constant<value_type, value_type::none>
     {
-        static jreflect::value* create() { return nullptr; }
+        static jreflect::value* get() { return nullptr; }
+        [[deprecated("Use get(), descriptors are shared")]] static jreflect::value* create() { return nullptr; }
     };
     template<value_type Type>
     using value_t = typename value_type_info<Type>::type;
     template<typename T>
     static constexpr value_type value_type_v = value_info<T>::value;
+    // Descriptors are stateless, one static instance is shared by every field of the same C++ type
+    template<typename T>
+    [[nodiscard]] jreflect::value* get_value() { return value_info<T>::get(); }
+    // Old owning API, kept for existing callers: returns a new descriptor that the caller deletes
+#if defined(_MSC_VER)
+    #pragma warning(push)
+    #pragma warning(disable: 4996)
+#else
+    #pragma GCC diagnostic push
+    #pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+#endif
     template<typename T>
-    [[nodiscard]] jreflect::value* create_value() { return value_info<T>::create(); }
+    [[deprecated("Use get_value(), descriptors are shared")]] [[nodiscard]] jreflect::value* create_value() { return value_info<T>::create(); }
+#if defined(_MSC_VER)
+    #pragma warning(pop)
+#else
+    #pragma GCC diagnostic pop
+#endif
     
     class value
     {
@@ -82,7 +128,7 @@ namespace jreflect
             {
                 return nullptr;
             }
-            return Type == getType() ? dynamic_cast<const value_t<Type>*>(this) : nullptr;
+            return Type == getType() ? static_cast<const value_t<Type>*>(this) : nullptr;
         }
 
     private:
@@ -92,6 +138,58 @@ namespace jreflect
 
     
 
+    class dirty_fields
+    {
+    public:
+        dirty_fields() = default;
+
+        [[nodiscard]] bool isEmpty() const
+        {
+            return std::all_of(m_Bits.begin(), m_Bits.end(), [](const jutils::uint64 word) { return word == 0; });
+        }
+        [[nodiscard]] bool isDirty(const jutils::index_type fieldIndex) const
+        {
+            return (fieldIndex >= 0) && (fieldIndex / 64 < m_Bits.getSize()) && (((m_Bits.get(fieldIndex / 64) >> (fieldIndex % 64)) & 1) != 0);
+        }
+
+        void mark(const jutils::index_type fieldIndex)
+        {
+            if (fieldIndex < 0)
+            {
+                return;
+            }
+            if (fieldIndex / 64 >= m_Bits.getSize())
+            {
+                m_Bits.resize(fieldIndex / 64 + 1);
+            }
+            m_Bits.get(fieldIndex / 64) |= static_cast<jutils::uint64>(1) << (fieldIndex % 64);
+        }
+        void unmark(const jutils::index_type fieldIndex)
+        {
+            if ((fieldIndex >= 0) && (fieldIndex / 64 < m_Bits.getSize()))
+            {
+                m_Bits.get(fieldIndex / 64) &= ~(static_cast<jutils::uint64>(1) << (fieldIndex % 64));
+            }
+        }
+        void clear() { std::fill(m_Bits.begin(), m_Bits.end(), 0); }
+
+        template<typename F>
+        void forEach(F&& func) const
+        {
+            for (jutils::index_type wordIndex = 0; wordIndex < m_Bits.getSize(); wordIndex++)
+            {
+                for (jutils::uint64 word = m_Bits.get(wordIndex); word != 0; word &= word - 1)
+                {
+                    func(static_cast<jutils::index_type>(wordIndex * 64 + std::countr_zero(word)));
+                }
+            }
+        }
+
+    private:
+
+        jutils::jarray<jutils::uint64> m_Bits;
+    };
+
     class class_interface
     {
     public:
@@ -107,6 +205,9 @@ namespace jreflect
         class_interface& operator=(class_interface&&) noexcept = default;
 
         [[nodiscard]] virtual class_type* getClassType() const = 0;
+
+        [[nodiscard]] virtual dirty_fields* getDirtyFields() { return nullptr; }
+        [[nodiscard]] virtual const dirty_fields* getDirtyFields() const { return nullptr; }
     };
 
 
@@ -145,43 +246,142 @@ namespace jreflect
     constexpr bool has_class_type_v = class_type_info<T>::has_class_type;
     template<typename T>
     [[nodiscard]] auto* get_class_type() { return class_type_info<T>::get_class_type(); }
+    // Classes declared with JREFLECT_CLASS_DIRTY_FIELDS() (and classes derived from them)
+    template<typename T>
+    constexpr bool has_dirty_fields_v = requires { requires jutils::remove_cvref_t<T>::HasDirtyFields; };
 
 
 
-    class class_field
+    // The batch access of class_field and class_field_entry, both only forward their type, offset and index
+    namespace field_batch_internal
     {
-    public:
-        class_field(value* fieldValue, const jutils::jstringID& name, const std::size_t offset)
-            : m_Value(fieldValue), m_Name(name), m_Offset(offset)
-        {}
-        class_field(const class_field&) = delete;
-        class_field(class_field&& otherField) noexcept
-            : m_Value(otherField.m_Value)
-            , m_Name(otherField.m_Name)
-            , m_Offset(otherField.m_Offset)
+        // Objects share one class, so the dirty fields are found at the same offset in each of them
+        inline std::ptrdiff_t GetDirtyFieldsOffset(class_interface* object)
         {
-            otherField.m_Value = nullptr;
+            dirty_fields* dirtyFields = object->getDirtyFields();
+            return dirtyFields != nullptr ? reinterpret_cast<jutils::uint8*>(dirtyFields) - reinterpret_cast<jutils::uint8*>(object) : -1;
         }
-        ~class_field()
+        inline void MarkDirty(class_interface* object, const std::ptrdiff_t dirtyFieldsOffset, const jutils::index_type fieldIndex)
         {
-            delete m_Value;
-            m_Value = nullptr;
+            reinterpret_cast<dirty_fields*>(reinterpret_cast<jutils::uint8*>(object) + dirtyFieldsOffset)->mark(fieldIndex);
         }
 
-        class_field& operator=(const class_field&) = delete;
-        class_field& operator=(class_field&& otherField) noexcept
+        // Null objects are skipped, their output values are left as they were
+        template<typename T>
+        bool GatherValues(const value_type fieldType, const std::size_t offset, const std::span<const class_interface* const> objects,
+            T* outValues)
+        {
+            static_assert(is_trivial_value_type(value_type_v<T>));
+            if (fieldType != value_type_v<T>)
+            {
+                return false;
+            }
+            for (std::size_t index = 0; index < objects.size(); index++)
+            {
+                if (objects[index] != nullptr)
+                {
+                    std::memcpy(outValues + index, reinterpret_cast<const jutils::uint8*>(objects[index]) + offset, sizeof(T));
+                }
+            }
+            return true;
+        }
+        // Objects must be of one class, dirty tracking is resolved once on the first of them. Null objects are skipped
+        template<typename T>
+        bool ScatterValues(const value_type fieldType, const std::size_t offset, const jutils::index_type fieldIndex,
+            const std::span<class_interface* const> objects, const T* values)
+        {
+            static_assert(is_trivial_value_type(value_type_v<T>));
+            if (fieldType != value_type_v<T>)
+            {
+                return false;
+            }
+            const auto firstObject = std::find_if(objects.begin(), objects.end(), [](const class_interface* object) { return object != nullptr; });
+            if (firstObject == objects.end())
+            {
+                return true;
+            }
+            const std::ptrdiff_t dirtyFieldsOffset = GetDirtyFieldsOffset(*firstObject);
+            for (std::size_t index = static_cast<std::size_t>(firstObject - objects.begin()); index < objects.size(); index++)
+            {
+                class_interface* object = objects[index];
+                if (object == nullptr)
+                {
+                    continue;
+                }
+                assert(object->getClassType() == (*firstObject)->getClassType());
+                std::memcpy(reinterpret_cast<jutils::uint8*>(object) + offset, values + index, sizeof(T));
+                if (dirtyFieldsOffset >= 0)
+                {
+                    MarkDirty(object, dirtyFieldsOffset, fieldIndex);
+                }
+            }
+            return true;
+        }
+        template<typename T>
+        bool GatherValues(const value_type fieldType, const std::size_t offset, const class_interface* firstObject, const std::size_t stride,
+            const jutils::index_type count, T* outValues)
         {
-            delete m_Value;
-            m_Value = otherField.m_Value;
-            m_Name = otherField.m_Name;
-            m_Offset = otherField.m_Offset;
-            otherField.m_Value = nullptr;
-            return *this;
+            static_assert(is_trivial_value_type(value_type_v<T>));
+            if ((fieldType != value_type_v<T>) || ((firstObject == nullptr) && (count > 0)))
+            {
+                return false;
+            }
+            // Two values per step: at -O3 GCC vectorizes the one-value loop by spilling pairs through the stack, which stalls on store forwarding
+            const jutils::uint8* data = reinterpret_cast<const jutils::uint8*>(firstObject) + offset;
+            jutils::index_type index = 0;
+            for (; index + 1 < count; index += 2, data += 2 * stride)
+            {
+                T value1, value2;
+                std::memcpy(&value1, data, sizeof(T));
+                std::memcpy(&value2, data + stride, sizeof(T));
+                outValues[index] = value1;
+                outValues[index + 1] = value2;
+            }
+            if (index < count)
+            {
+                std::memcpy(outValues + index, data, sizeof(T));
+            }
+            return true;
+        }
+        template<typename T>
+        bool ScatterValues(const value_type fieldType, const std::size_t offset, const jutils::index_type fieldIndex,
+            class_interface* firstObject, const std::size_t stride, const jutils::index_type count, const T* values)
+        {
+            static_assert(is_trivial_value_type(value_type_v<T>));
+            if ((fieldType != value_type_v<T>) || ((firstObject == nullptr) && (count > 0)))
+            {
+                return false;
+            }
+            if (count <= 0)
+            {
+                return true;
+            }
+            const std::ptrdiff_t dirtyFieldsOffset = GetDirtyFieldsOffset(firstObject);
+            auto* objectData = reinterpret_cast<jutils::uint8*>(firstObject);
+            for (jutils::index_type index = 0; index < count; index++, objectData += stride)
+            {
+                std::memcpy(objectData + offset, values + index, sizeof(T));
+                if (dirtyFieldsOffset >= 0)
+                {
+                    MarkDirty(reinterpret_cast<class_interface*>(objectData), dirtyFieldsOffset, fieldIndex);
+                }
+            }
+            return true;
         }
+    }
+
+    class class_field
+    {
+    public:
+        class_field(value* fieldValue, const jutils::jstringID& name, const std::size_t offset, const jutils::index_type index = jutils::index_invalid,
+            const class_type* classType = nullptr)
+            : m_Value(fieldValue), m_Name(name), m_Offset(offset), m_Index(index), m_ClassType(classType)
+        {}
 
         [[nodiscard]] value* getValue() const { return m_Value; }
         [[nodiscard]] jutils::jstringID getName() const { return m_Name; }
         [[nodiscard]] std::size_t getOffset() const { return m_Offset; }
+        [[nodiscard]] jutils::index_type getIndex() const { return m_Index; }
 
         [[nodiscard]] value_type getValueType() const
         {
@@ -189,60 +389,302 @@ namespace jreflect
         }
         [[nodiscard]] void* getValuePtr(class_interface* object) const
         {
+            JREFLECT_INSTRUMENT(instrumentation_internal::RecordFieldAccess(m_ClassType, m_Index));
             return object != nullptr ? (reinterpret_cast<jutils::uint8*>(object) + getOffset()) : nullptr;
         }
         [[nodiscard]] const void* getValuePtr(const class_interface* object) const
         {
+            JREFLECT_INSTRUMENT(instrumentation_internal::RecordFieldAccess(m_ClassType, m_Index));
             return object != nullptr ? (reinterpret_cast<const jutils::uint8*>(object) + getOffset()) : nullptr;
         }
+        [[nodiscard]] void* modifyValuePtr(class_interface* object) const
+        {
+            dirty_fields* dirtyFields = object != nullptr ? object->getDirtyFields() : nullptr;
+            if (dirtyFields != nullptr)
+            {
+                dirtyFields->mark(m_Index);
+            }
+            return getValuePtr(object);
+        }
+
+        template<typename T>
+        bool gatherValues(const std::span<const class_interface* const> objects, T* outValues) const
+        {
+            return field_batch_internal::GatherValues(getValueType(), m_Offset, objects, outValues);
+        }
+        template<typename T>
+        bool gatherValues(const class_interface* firstObject, const std::size_t stride, const jutils::index_type count, T* outValues) const
+        {
+            return field_batch_internal::GatherValues(getValueType(), m_Offset, firstObject, stride, count, outValues);
+        }
+        template<typename T>
+        bool scatterValues(const std::span<class_interface* const> objects, const T* values) const
+        {
+            return field_batch_internal::ScatterValues(getValueType(), m_Offset, m_Index, objects, values);
+        }
+        template<typename T>
+        bool scatterValues(class_interface* firstObject, const std::size_t stride, const jutils::index_type count, const T* values) const
+        {
+            return field_batch_internal::ScatterValues(getValueType(), m_Offset, m_Index, firstObject, stride, count, values);
+        }
 
     private:
 
         value* m_Value = nullptr;
         jutils::jstringID m_Name = jutils::jstringID_NONE;
         std::size_t m_Offset = 0;
+        jutils::index_type m_Index = jutils::index_invalid;
+        const class_type* m_ClassType = nullptr;
+    };
+
+    template<typename T>
+    struct type_id_info
+    {
+        static constexpr jutils::uint8 tag = 0;
+    };
+    template<typename T>
+    [[nodiscard]] constexpr const void* type_id() { return &type_id_info<jutils::remove_cvref_t<T>>::tag; }
+
+    [[nodiscard]] inline std::size_t hash_name(const jutils::jstringID& name) { return std::hash<jutils::jstringID>()(name); }
+
+    struct class_field_entry
+    {
+        std::size_t nameHash = 0;
+        std::size_t offset = 0;
+        value* fieldValue = nullptr;
+        const void* typeID = nullptr;
+        value_type type = value_type::none;
+        jutils::index_type index = jutils::index_invalid;
+        jutils::jstringID name = jutils::jstringID_NONE;
+        // Class whose field table holds this entry
+        const class_type* classType = nullptr;
+
+        [[nodiscard]] void* getValuePtr(class_interface* object) const
+        {
+            JREFLECT_INSTRUMENT(instrumentation_internal::RecordFieldAccess(classType, index));
+            return object != nullptr ? (reinterpret_cast<jutils::uint8*>(object) + offset) : nullptr;
+        }
+        [[nodiscard]] const void* getValuePtr(const class_interface* object) const
+        {
+            JREFLECT_INSTRUMENT(instrumentation_internal::RecordFieldAccess(classType, index));
+            return object != nullptr ? (reinterpret_cast<const jutils::uint8*>(object) + offset) : nullptr;
+        }
+        [[nodiscard]] void* modifyValuePtr(class_interface* object) const
+        {
+            dirty_fields* dirtyFields = object != nullptr ? object->getDirtyFields() : nullptr;
+            if (dirtyFields != nullptr)
+            {
+                dirtyFields->mark(index);
+            }
+            return getValuePtr(object);
+        }
+
+        template<typename T>
+        bool gatherValues(const std::span<const class_interface* const> objects, T* outValues) const
+        {
+            return field_batch_internal::GatherValues(type, offset, objects, outValues);
+        }
+        template<typename T>
+        bool gatherValues(const class_interface* firstObject, const std::size_t stride, const jutils::index_type count, T* outValues) const
+        {
+            return field_batch_internal::GatherValues(type, offset, firstObject, stride, count, outValues);
+        }
+        template<typename T>
+        bool scatterValues(const std::span<class_interface* const> objects, const T* values) const
+        {
+            return field_batch_internal::ScatterValues(type, offset, index, objects, values);
+        }
+        template<typename T>
+        bool scatterValues(class_interface* firstObject, const std::size_t stride, const jutils::index_type count, const T* values) const
+        {
+            return field_batch_internal::ScatterValues(type, offset, index, firstObject, stride, count, values);
+        }
+    };
+
+    template<typename T, typename NameT = jutils::jstringID>
+    struct class_field_info
+    {
+        using type = T;
+
+        NameT name = {};
+        std::size_t offset = 0;
+    };
+
+    template<typename T>
+    struct static_class_info
+    {
+        static constexpr bool valid = false;
+    };
+    template<typename T>
+    constexpr bool has_static_class_info_v = static_class_info<jutils::remove_cvref_t<T>>::valid;
+
+    template<typename T, typename F>
+    constexpr void for_each_field(T& object, F&& func)
+    {
+        using class_t = std::remove_const_t<T>;
+        static_assert(has_class_type_v<class_t>);
+
+        using parent_t = typename class_t::parent_t;
+        if constexpr (has_static_class_info_v<parent_t> && std::is_base_of_v<parent_t, class_t>)
+        {
+            for_each_field(static_cast<std::conditional_t<std::is_const_v<T>, const parent_t, parent_t>&>(object), func);
+        }
+        if constexpr (has_static_class_info_v<class_t>)
+        {
+            using byte_t = std::conditional_t<std::is_const_v<T>, const jutils::uint8, jutils::uint8>;
+            using interface_t = std::conditional_t<std::is_const_v<T>, const class_interface, class_interface>;
+            byte_t* objectData = reinterpret_cast<byte_t*>(static_cast<interface_t*>(&object));
+            std::apply([objectData, &func](const auto&... fieldInfo)
+            {
+                (func(fieldInfo, *reinterpret_cast<std::conditional_t<std::is_const_v<T>,
+                    const typename std::remove_cvref_t<decltype(fieldInfo)>::type,
+                    typename std::remove_cvref_t<decltype(fieldInfo)>::type
+                >*>(objectData + fieldInfo.offset)), ...);
+            }, static_class_info<class_t>::fields);
+        }
+    }
+
+    struct class_field_block
+    {
+        std::size_t offset = 0;
+        std::size_t size = 0;
+        jutils::index_type fieldIndex = jutils::index_invalid;
+        jutils::index_type fieldCount = 0;
+        bool trivial = false;
+    };
+    // Field that can hold references to other objects: object_ptr or an array with pointers or objects inside
+    struct class_pointer_edge
+    {
+        std::size_t offset = 0;
+        const value* fieldValue = nullptr;
     };
 
     class class_type
     {
+        friend class database;
+        friend class snapshot;
+
     public:
         class_type() = default;
         virtual ~class_type() = default;
 
         void initialize()
         {
-            if (!m_Initialized)
+            if (!m_Initialized.load(std::memory_order_acquire))
             {
-                m_Initialized = true;
-                initializeClassType();
+                std::call_once(m_InitializeFlag, [this]()
+                {
+                    initializeClassType();
+                    initFieldIndex();
+                    initFieldBlocks();
+                    initSchemaHash();
+                    initPointerEdges();
+                    JREFLECT_INSTRUMENT(initFieldAccessCounts());
+                    m_Initialized.store(true, std::memory_order_release);
+                });
             }
         }
+        [[nodiscard]] bool isInitialized() const { return m_Initialized.load(std::memory_order_acquire); }
 
         [[nodiscard]] virtual jutils::jstringID getName() const = 0;
         [[nodiscard]] virtual class_type* getParent() const = 0;
 
-        [[nodiscard]] bool isDerivedFrom(const class_type* type) const { return (type != nullptr) && isDerivedFromClass(type); }
+        [[nodiscard]] virtual std::size_t getObjectSize() const { return 0; }
+        [[nodiscard]] virtual std::size_t getObjectAlignment() const { return 0; }
+
+        [[nodiscard]] class_interface* createObject(object_allocator* allocator = nullptr)
+        {
+            const std::size_t objectSize = getObjectSize();
+            if (objectSize == 0)
+            {
+                return nullptr;
+            }
+            object_allocator& objectAllocator = allocator != nullptr ? *allocator : m_ObjectPool;
+            void* memory = objectAllocator.allocate(objectSize, getObjectAlignment());
+            return memory != nullptr ? constructObjectInternal(memory) : nullptr;
+        }
+        // Returns false and leaves the object alone if it wasn't created by this allocator (or the default pool)
+        static bool DestroyObject(class_interface* object, object_allocator* allocator = nullptr)
+        {
+            class_type* classType = object != nullptr ? object->getClassType() : nullptr;
+            return (classType != nullptr) && classType->destroyObject(object, allocator);
+        }
+
+        [[nodiscard]] bool isDerivedFrom(const class_type* type) const
+        {
+            JREFLECT_INSTRUMENT(instrumentation_internal::RecordDerivedCheck(this));
+            if (type == nullptr)
+            {
+                return false;
+            }
+            const jutils::uint64 range = m_HierarchyRange.load(std::memory_order_relaxed);
+            const jutils::uint64 typeRange = type->m_HierarchyRange.load(std::memory_order_relaxed);
+            if ((range != InvalidHierarchyRange) && (typeRange != InvalidHierarchyRange)
+                && ((range >> HierarchyGenerationShift) == (typeRange >> HierarchyGenerationShift)))
+            {
+                const auto typeIndex = static_cast<jutils::uint32>((typeRange >> HierarchyIndexBits) & HierarchyIndexMask);
+                return ((static_cast<jutils::uint32>((range >> HierarchyIndexBits) & HierarchyIndexMask) - typeIndex) & HierarchyIndexMask)
+                     < ((static_cast<jutils::uint32>(typeRange & HierarchyIndexMask) - typeIndex) & HierarchyIndexMask);
+            }
+            return isDerivedFromClass(type);
+        }
         JUTILS_TEMPLATE_CONDITION(has_class_type_v<T>, typename T)
         [[nodiscard]] bool isDerivedFrom() const { return this->isDerivedFrom(class_type_info<T>::get_class_type()); }
 
         [[nodiscard]] const auto& getFields() const { return m_Fields; }
+        [[nodiscard]] const jutils::jarray<class_field_entry>& getFieldTable() const { return m_FieldTable; }
+        [[nodiscard]] const jutils::jarray<class_field_block>& getFieldBlocks() const { return m_FieldBlocks; }
+        // Hash of the name, size and field layout, stable between runs of the same build
+        [[nodiscard]] jutils::uint64 getSchemaHash() const { return m_SchemaHash; }
+        // Nested object fields are flattened, offsets are relative to the object
+        [[nodiscard]] const jutils::jarray<class_pointer_edge>& getPointerEdges() const { return m_PointerEdges; }
+        [[nodiscard]] const class_field_entry* findField(const jutils::jstringID& name) const
+        {
+            JREFLECT_INSTRUMENT(const instrumentation_internal::field_lookup_scope instrumentationScope(this));
+            if (m_FieldIndex.isEmpty())
+            {
+                return nullptr;
+            }
 
-    protected:
+            const std::size_t nameHash = hash_name(name);
+            field_lookup_cache_entry& cacheEntry = GetFieldLookupCacheEntry(this, nameHash);
+            if ((cacheEntry.classType == this) && (cacheEntry.name == name))
+            {
+                return cacheEntry.field;
+            }
 
-        template<typename T>
-        struct create_field_info
-        {
-            using type = T;
+            const std::size_t mask = static_cast<std::size_t>(m_FieldIndex.getSize() - 1);
+            for (std::size_t slot = nameHash & mask; ; slot = (slot + 1) & mask)
+            {
+                const field_index_entry& entry = m_FieldIndex.get(static_cast<jutils::index_type>(slot));
+                if (entry.fieldIndex == jutils::index_invalid)
+                {
+                    return nullptr;
+                }
+                if (entry.nameHash == nameHash)
+                {
+                    const class_field_entry& field = m_FieldTable.get(entry.fieldIndex);
+                    if (field.name == name)
+                    {
+                        cacheEntry = { .classType = this, .name = name, .field = &field };
+                        return &field;
+                    }
+                }
+            }
+        }
 
-            jutils::jstringID name = jutils::jstringID_NONE;
-            std::size_t offset = 0;
-        };
+    protected:
+
+        template<typename T, typename NameT = jutils::jstringID>
+        using create_field_info = class_field_info<T, NameT>;
 
         virtual void initializeClassType() {}
 
-        virtual bool isDerivedFromClass(const class_type* type) const { return false; }
+        virtual bool isDerivedFromClass(const class_type*) const { return false; }
 
-        virtual class_interface* createObjectInternal() const { return nullptr; }
+        virtual class_interface* constructObjectInternal([[maybe_unused]] void* memory) const { return nullptr; }
+        virtual void* destructObjectInternal([[maybe_unused]] class_interface* object) const { return nullptr; }
+        virtual const void* getObjectMemoryInternal([[maybe_unused]] const class_interface* object) const { return nullptr; }
         
         template<typename T>
         void createField(const jutils::jstringID& name, const std::size_t offset)
@@ -253,21 +695,221 @@ namespace jreflect
             }
 
             assert(!m_Fields.contains(name));
+            if (m_Fields.contains(name))
+            {
+                return;
+            }
 
-            value* createdValue = create_value<T>();
-            assert(createdValue != nullptr);
-            if (createdValue == nullptr)
+            value* fieldValue = get_value<T>();
+            assert(fieldValue != nullptr);
+            if (fieldValue == nullptr)
             {
                 return;
             }
 
-            m_Fields.put(name, createdValue, name, offset);
+            const jutils::index_type fieldIndex = m_FieldTable.getSize();
+            m_Fields.put(name, fieldValue, name, offset, fieldIndex, this);
+            m_FieldTable.add({
+                .nameHash = hash_name(name), .offset = offset, .fieldValue = fieldValue, .typeID = type_id<T>(),
+                .type = fieldValue->getType(), .index = fieldIndex, .name = name, .classType = this
+            });
         }
 
     private:
 
+        struct field_index_entry
+        {
+            std::size_t nameHash = 0;
+            jutils::index_type fieldIndex = jutils::index_invalid;
+        };
+        struct field_lookup_cache_entry
+        {
+            const class_type* classType = nullptr;
+            jutils::jstringID name = jutils::jstringID_NONE;
+            const class_field_entry* field = nullptr;
+        };
+
+        static constexpr std::size_t FieldLookupCacheSize = 64;
+
         jutils::jmap<jutils::jstringID, class_field> m_Fields;
-        bool m_Initialized = false;
+        jutils::jarray<class_field_entry> m_FieldTable;
+        jutils::jarray<field_index_entry> m_FieldIndex;
+        jutils::jarray<class_field_block> m_FieldBlocks;
+        jutils::uint64 m_SchemaHash = 0;
+        jutils::jarray<class_pointer_edge> m_PointerEdges;
+        object_pool m_ObjectPool;
+        std::atomic<bool> m_Initialized = false;
+        std::once_flag m_InitializeFlag;
+#if defined(JREFLECT_ENABLE_INSTRUMENTATION)
+        // Owned by the instrumentation registry, created on first use
+        mutable std::atomic<instrumentation_internal::class_counters*> m_InstrumentationCounters = nullptr;
+        // One counter per field table entry
+        std::atomic<jutils::uint64>* m_FieldAccessCounts = nullptr;
+
+        friend instrumentation_internal::class_counters& instrumentation_internal::GetClassCounters(const class_type* classType);
+        friend void instrumentation_internal::RecordFieldAccess(const class_type* classType, jutils::index_type fieldIndex);
+#endif
+
+        static constexpr jutils::uint64 InvalidHierarchyRange = ~static_cast<jutils::uint64>(0);
+        static constexpr jutils::uint32 HierarchyIndexBits = 24;
+        static constexpr jutils::uint32 HierarchyIndexMask = (1u << HierarchyIndexBits) - 1;
+        static constexpr jutils::uint32 HierarchyGenerationShift = HierarchyIndexBits * 2;
+        // Pre-order interval assigned by the database, packed as (generation << 48) | (begin << 24) | end. Ranges of
+        // different database generations are never compared, isDerivedFrom() falls back to the parent chain instead
+        std::atomic<jutils::uint64> m_HierarchyRange = InvalidHierarchyRange;
+
+
+        void setHierarchyRange(const jutils::index_type begin, const jutils::index_type end, const jutils::uint16 generation)
+        {
+            m_HierarchyRange.store(
+                (static_cast<jutils::uint64>(generation) << HierarchyGenerationShift)
+                    | (static_cast<jutils::uint64>(static_cast<jutils::uint32>(begin) & HierarchyIndexMask) << HierarchyIndexBits)
+                    | (static_cast<jutils::uint32>(end) & HierarchyIndexMask),
+                std::memory_order_relaxed
+            );
+        }
+        void clearHierarchyRange() { m_HierarchyRange.store(InvalidHierarchyRange, std::memory_order_relaxed); }
+
+
+        bool destroyObject(class_interface* object, object_allocator* allocator)
+        {
+            // A foreign pointer on the pool's free list would be handed out again while still in use
+            object_allocator& objectAllocator = allocator != nullptr ? *allocator : m_ObjectPool;
+            const void* objectMemory = getObjectMemoryInternal(object);
+            if ((objectMemory == nullptr) || !objectAllocator.owns(objectMemory))
+            {
+                return false;
+            }
+            objectAllocator.deallocate(destructObjectInternal(object), getObjectSize(), getObjectAlignment());
+            return true;
+        }
+
+        // Direct-mapped per-thread cache of resolved (class, name) pairs, fields never move after initialization
+        static field_lookup_cache_entry& GetFieldLookupCacheEntry(const class_type* classType, const std::size_t nameHash)
+        {
+            thread_local field_lookup_cache_entry cache[FieldLookupCacheSize];
+            return cache[(nameHash ^ (reinterpret_cast<std::uintptr_t>(classType) >> 4)) & (FieldLookupCacheSize - 1)];
+        }
+
+        // Open-addressed table with linear probing, at most half full so every probe sequence ends on an empty slot
+        void initFieldIndex()
+        {
+            m_FieldIndex.clear();
+            if (m_FieldTable.isEmpty())
+            {
+                return;
+            }
+
+            const auto slotCount = static_cast<jutils::index_type>(std::bit_ceil(static_cast<std::size_t>(m_FieldTable.getSize()) * 2));
+            const std::size_t mask = static_cast<std::size_t>(slotCount - 1);
+            m_FieldIndex.resize(slotCount);
+            for (jutils::index_type index = 0; index < m_FieldTable.getSize(); index++)
+            {
+                const std::size_t nameHash = m_FieldTable.get(index).nameHash;
+                std::size_t slot = nameHash & mask;
+                while (m_FieldIndex.get(static_cast<jutils::index_type>(slot)).fieldIndex != jutils::index_invalid)
+                {
+                    slot = (slot + 1) & mask;
+                }
+                m_FieldIndex.get(static_cast<jutils::index_type>(slot)) = { .nameHash = nameHash, .fieldIndex = index };
+            }
+        }
+        void initFieldBlocks()
+        {
+            jutils::jarray<jutils::index_type> fieldsByOffset;
+            fieldsByOffset.reserve(m_FieldTable.getSize());
+            for (jutils::index_type index = 0; index < m_FieldTable.getSize(); index++)
+            {
+                fieldsByOffset.add(index);
+            }
+            std::stable_sort(fieldsByOffset.begin(), fieldsByOffset.end(), [this](const jutils::index_type index1, const jutils::index_type index2) {
+                return m_FieldTable.get(index1).offset < m_FieldTable.get(index2).offset;
+            });
+
+            m_FieldBlocks.clear();
+            for (const auto& fieldIndex : fieldsByOffset)
+            {
+                const class_field_entry& field = m_FieldTable.get(fieldIndex);
+                const std::size_t fieldSize = value_type_size(field.type);
+                if (fieldSize > 0)
+                {
+                    if (!m_FieldBlocks.isEmpty())
+                    {
+                        class_field_block& lastBlock = m_FieldBlocks.get(m_FieldBlocks.getSize() - 1);
+                        if (lastBlock.trivial && (lastBlock.offset + lastBlock.size == field.offset))
+                        {
+                            lastBlock.size += fieldSize;
+                            lastBlock.fieldCount++;
+                            continue;
+                        }
+                    }
+                    m_FieldBlocks.add({ .offset = field.offset, .size = fieldSize, .fieldIndex = fieldIndex, .fieldCount = 1, .trivial = true });
+                }
+                else
+                {
+                    m_FieldBlocks.add({ .offset = field.offset, .size = 0, .fieldIndex = fieldIndex, .fieldCount = 1, .trivial = false });
+                }
+            }
+        }
+
+        static jutils::uint64 HashSchemaBytes(jutils::uint64 hash, const void* data, const std::size_t size)
+        {
+            const auto* bytes = static_cast<const jutils::uint8*>(data);
+            for (std::size_t index = 0; index < size; index++)
+            {
+                hash = (hash ^ bytes[index]) * 0x100000001B3ull;
+            }
+            return hash;
+        }
+        static jutils::uint64 HashSchemaName(const jutils::uint64 hash, const jutils::jstringID& name)
+        {
+            const jutils::jstring& str = name.toString();
+            return HashSchemaBytes(hash, str.getString(), static_cast<std::size_t>(str.getSize()));
+        }
+        template<typename T>
+        static jutils::uint64 HashSchemaValue(const jutils::uint64 hash, const T& value)
+        {
+            return HashSchemaBytes(hash, &value, sizeof(T));
+        }
+        void initSchemaHash();
+        void initPointerEdges();
+#if defined(JREFLECT_ENABLE_INSTRUMENTATION)
+        void initFieldAccessCounts()
+        {
+            m_FieldAccessCounts = instrumentation_internal::CreateFieldAccessCounts(
+                instrumentation_internal::GetClassCounters(this), m_FieldTable.getSize()
+            );
+        }
+#endif
+    };
+
+    // Emitted by JREFLECT_INIT_CLASS_TYPE, static instances form an intrusive list that needs no allocation. New registrars
+    // are prepended, so the database can add the ones created after it was built
+    class class_type_registrar
+    {
+    public:
+        using get_class_type_function = class_type* (*)();
+
+        explicit class_type_registrar(const get_class_type_function getClassType) noexcept
+            : m_GetClassType(getClassType), m_Next(Head.load(std::memory_order_relaxed))
+        {
+            Head.store(this, std::memory_order_release);
+        }
+        class_type_registrar(const class_type_registrar&) = delete;
+
+        class_type_registrar& operator=(const class_type_registrar&) = delete;
+
+        [[nodiscard]] static const class_type_registrar* GetFirst() noexcept { return Head.load(std::memory_order_acquire); }
+
+        [[nodiscard]] class_type* getClassType() const { return m_GetClassType(); }
+        [[nodiscard]] const class_type_registrar* getNext() const noexcept { return m_Next; }
+
+    private:
+
+        inline static constinit std::atomic<const class_type_registrar*> Head = nullptr;
+
+        get_class_type_function m_GetClassType = nullptr;
+        const class_type_registrar* m_Next = nullptr;
     };
 
 
@@ -280,12 +922,14 @@ namespace jreflect
         virtual ~value_##Enum() override = default;                                             \
         bool get(const void* valuePtr, Type& outValue) const                                    \
         {                                                                                       \
+            JREFLECT_INSTRUMENT(instrumentation_internal::RecordValueGet(getType()));       \
             if (valuePtr == nullptr) return false;                                              \
             outValue = *static_cast<const Type*>(valuePtr);                                     \
             return true;                                                                        \
         }                                                                                       \
         bool set(void* valuePtr, const Type& value) const                                       \
         {                                                                                       \
+            JREFLECT_INSTRUMENT(instrumentation_internal::RecordValueSet(getType()));       \
             if (valuePtr == nullptr) return false;                                              \
             *static_cast<Type*>(valuePtr) = value;                                              \
             return true;                                                                        \
@@ -294,7 +938,9 @@ namespace jreflect
     template<> struct value_type_info<value_type::Enum> { using type = value_##Enum; };         \
     template<> struct value_info<Type> : std::integral_constant<value_type, value_type::Enum>   \
     {                                                                                           \
-        static jreflect::value* create() { return new value_type_info<value>::type(); }         \
+        static jreflect::value* get() { static value_##Enum descriptor; return &descriptor; }   \
+        [[deprecated("Use get(), descriptors are shared")]]                                     \
+        static jreflect::value* create() { return new value_##Enum(); }                         \
     };
 
     JREFLECT_HELPER_DECLARE_PRIMITIVE_VALUE(boolean,            bool);
@@ -339,6 +985,7 @@ namespace jreflect
         }
         bool get(const void* valuePtr, class_interface& outValue) const
         {
+            JREFLECT_INSTRUMENT(instrumentation_internal::RecordValueGet(getType()));
             if ((valuePtr == nullptr) || (outValue.getClassType() != m_ObjectType))
             {
                 return false;
@@ -352,6 +999,7 @@ namespace jreflect
         }
         bool set(void* valuePtr, const class_interface& v) const
         {
+            JREFLECT_INSTRUMENT(instrumentation_internal::RecordValueSet(getType()));
             if ((valuePtr == nullptr) || (v.getClassType() != m_ObjectType))
             {
                 return false;
@@ -360,6 +1008,7 @@ namespace jreflect
         }
         bool set(void* valuePtr, class_interface&& v) const
         {
+            JREFLECT_INSTRUMENT(instrumentation_internal::RecordValueSet(getType()));
             if ((valuePtr == nullptr) || (v.getClassType() != m_ObjectType))
             {
                 return false;
@@ -388,7 +1037,7 @@ namespace jreflect
         {
             if constexpr (std::is_copy_assignable_v<T>)
             {
-                dynamic_cast<T&>(dst) = dynamic_cast<const T&>(src);
+                static_cast<T&>(dst) = static_cast<const T&>(src);
                 return true;
             }
             return false;
@@ -397,7 +1046,7 @@ namespace jreflect
         {
             if constexpr (std::is_move_assignable_v<T>)
             {
-                dynamic_cast<T&>(dst) = std::move(dynamic_cast<T&&>(src));
+                static_cast<T&>(dst) = std::move(static_cast<T&>(src));
                 return true;
             }
             return copyAssign(dst, src);
@@ -407,7 +1056,8 @@ namespace jreflect
     JUTILS_TEMPLATE_CONDITION((has_class_type_v<T>), typename T)
     struct value_info<T> : std::integral_constant<value_type, value_type::object>
     {
-        static jreflect::value* create() { return new value_object_impl<T>(); }
+        static jreflect::value* get() { static value_object_impl<T> descriptor; return &descriptor; }
+        [[deprecated("Use get(), descriptors are shared")]] static jreflect::value* create() { return new value_object_impl<T>(); }
     };
 
     class value_object_ptr : public value
@@ -420,9 +1070,11 @@ namespace jreflect
         virtual ~value_object_ptr() override = default;
 
         [[nodiscard]] class_type* getObjectType() const { return m_ObjectType; }
+        [[nodiscard]] virtual bool isRawPointer() const { return false; }
 
         bool get(void* valuePtr, class_interface*& outValue) const
         {
+            JREFLECT_INSTRUMENT(instrumentation_internal::RecordValueGet(getType()));
             if (valuePtr == nullptr)
             {
                 return false;
@@ -433,6 +1085,7 @@ namespace jreflect
 
         bool set(void* valuePtr, class_interface* v) const
         {
+            JREFLECT_INSTRUMENT(instrumentation_internal::RecordValueSet(getType()));
             if (valuePtr == nullptr)
             {
                 return false;
@@ -483,6 +1136,8 @@ namespace jreflect
             : value_object_ptr(get_class_type<type>())
         {}
 
+        [[nodiscard]] virtual bool isRawPointer() const override { return std::is_same_v<ptr_type, type*>; }
+
     protected:
 
         virtual class_interface* getObjectPtr(void* valuePtr) const override
@@ -492,14 +1147,15 @@ namespace jreflect
         }
         virtual void setObjectPtr(void* valuePtr, class_interface* v) const override
         {
-            *static_cast<ptr_type*>(valuePtr) = dynamic_cast<type*>(v);
+            *static_cast<ptr_type*>(valuePtr) = static_cast<type*>(v);
         }
     };
     template<> struct value_type_info<value_type::object_ptr> { using type = value_object_ptr; };
     JUTILS_TEMPLATE_CONDITION((value_object_ptr_impl<T>::valid), typename T)
     struct value_info<T> : std::integral_constant<value_type, value_type::object_ptr>
     {
-        static jreflect::value* create() { return new value_object_ptr_impl<T>(); }
+        static jreflect::value* get() { static value_object_ptr_impl<T> descriptor; return &descriptor; }
+        [[deprecated("Use get(), descriptors are shared")]] static jreflect::value* create() { return new value_object_ptr_impl<T>(); }
     };
 
     class value_array_bool : public value
@@ -514,6 +1170,7 @@ namespace jreflect
 
         bool get(const void* valuePtr, const jutils::index_type index, bool& outValue) const
         {
+            JREFLECT_INSTRUMENT(instrumentation_internal::RecordValueGet(getType()));
             auto* valueArray = valuePtr != nullptr ? GetArray(valuePtr) : nullptr;
             if ((valueArray == nullptr) || (index < 0) || (index >= valueArray->size()))
             {
@@ -524,6 +1181,7 @@ namespace jreflect
         }
         bool set(void* valuePtr, const jutils::index_type index, const bool newValue) const
         {
+            JREFLECT_INSTRUMENT(instrumentation_internal::RecordValueSet(getType()));
             auto* valueArray = valuePtr != nullptr ? GetArray(valuePtr) : nullptr;
             if ((valueArray == nullptr) || (index < 0) || (index >= valueArray->size()))
             {
@@ -540,7 +1198,8 @@ namespace jreflect
             {
                 return false;
             }
-            valueArray->emplace(std::next(valueArray->begin(), jutils::math::min(index, valueArray->size())), newValue);
+            const auto size = static_cast<jutils::index_type>(valueArray->size());
+            valueArray->emplace(std::next(valueArray->begin(), (index >= 0) && (index < size) ? index : size), newValue);
             return true;
         }
         void remove(void* valuePtr, const jutils::index_type index) const
@@ -560,15 +1219,231 @@ namespace jreflect
             }
         }
 
+        [[nodiscard]] static constexpr jutils::index_type GetWordCount(const jutils::index_type bitCount) { return (bitCount + 63) / 64; }
+
+        // Packs bit i into word i / 64 at bit i % 64, outWords must hold GetWordCount(getSize()) words
+        bool getWords(const void* valuePtr, jutils::uint64* outWords) const
+        {
+            const auto* valueArray = valuePtr != nullptr ? GetArray(valuePtr) : nullptr;
+            if (valueArray == nullptr)
+            {
+                return false;
+            }
+            const auto size = static_cast<jutils::index_type>(valueArray->size());
+            const jutils::index_type wordCount = GetWordCount(size);
+            const jutils::uint64* words = GetWords(*valueArray);
+            for (jutils::index_type wordIndex = 0; wordIndex < wordCount; wordIndex++)
+            {
+                outWords[wordIndex] = words != nullptr ? words[wordIndex] : PackWord(*valueArray, wordIndex);
+            }
+            if (wordCount > 0)
+            {
+                outWords[wordCount - 1] &= GetLastWordMask(size);
+            }
+            return true;
+        }
+        bool setWords(void* valuePtr, const jutils::uint64* words, const jutils::index_type bitCount) const
+        {
+            auto* valueArray = valuePtr != nullptr ? GetArray(valuePtr) : nullptr;
+            if ((valueArray == nullptr) || (bitCount < 0) || ((words == nullptr) && (bitCount > 0)))
+            {
+                return false;
+            }
+            valueArray->assign(static_cast<std::size_t>(bitCount), false);
+            jutils::uint64* arrayWords = GetWords(*valueArray);
+            for (jutils::index_type wordIndex = 0; wordIndex < GetWordCount(bitCount); wordIndex++)
+            {
+                const jutils::uint64 word = words[wordIndex] & GetWordMask(wordIndex, bitCount);
+                if (arrayWords != nullptr)
+                {
+                    arrayWords[wordIndex] = word;
+                }
+                else
+                {
+                    UnpackWord(*valueArray, wordIndex, word);
+                }
+            }
+            return true;
+        }
+
+        [[nodiscard]] jutils::index_type count(const void* valuePtr) const
+        {
+            const auto* valueArray = valuePtr != nullptr ? GetArray(valuePtr) : nullptr;
+            if (valueArray == nullptr)
+            {
+                return 0;
+            }
+            const auto size = static_cast<jutils::index_type>(valueArray->size());
+            const jutils::index_type wordCount = GetWordCount(size);
+            if (wordCount == 0)
+            {
+                return 0;
+            }
+            // Only the last word needs the mask
+            const jutils::uint64* words = GetWords(*valueArray);
+            jutils::index_type result = CountBits(GetMaskedWord(*valueArray, wordCount - 1, size));
+            if (words != nullptr)
+            {
+                for (jutils::index_type wordIndex = 0; wordIndex < wordCount - 1; wordIndex++)
+                {
+                    result += CountBits(words[wordIndex]);
+                }
+                return result;
+            }
+            for (jutils::index_type wordIndex = 0; wordIndex < wordCount - 1; wordIndex++)
+            {
+                result += CountBits(PackWord(*valueArray, wordIndex));
+            }
+            return result;
+        }
+        [[nodiscard]] jutils::index_type findFirstSet(const void* valuePtr, const jutils::index_type startIndex = 0) const
+        {
+            return findFirst(valuePtr, startIndex, false);
+        }
+        [[nodiscard]] jutils::index_type findFirstClear(const void* valuePtr, const jutils::index_type startIndex = 0) const
+        {
+            return findFirst(valuePtr, startIndex, true);
+        }
+
+        // Bits not covered by the mask are left unchanged
+        bool applyAnd(void* valuePtr, const jutils::uint64* mask, const jutils::index_type maskWordCount) const
+        {
+            return applyMask(valuePtr, mask, maskWordCount, [](const jutils::uint64 word, const jutils::uint64 maskWord) { return word & maskWord; });
+        }
+        bool applyOr(void* valuePtr, const jutils::uint64* mask, const jutils::index_type maskWordCount) const
+        {
+            return applyMask(valuePtr, mask, maskWordCount, [](const jutils::uint64 word, const jutils::uint64 maskWord) { return word | maskWord; });
+        }
+        bool applyXor(void* valuePtr, const jutils::uint64* mask, const jutils::index_type maskWordCount) const
+        {
+            return applyMask(valuePtr, mask, maskWordCount, [](const jutils::uint64 word, const jutils::uint64 maskWord) { return word ^ maskWord; });
+        }
+
     private:
 
         static std::vector<bool>* GetArray(void* valuePtr) { return static_cast<std::vector<bool>*>(valuePtr); }
         static const std::vector<bool>* GetArray(const void* valuePtr) { return static_cast<const std::vector<bool>*>(valuePtr); }
+
+        // Direct access to the storage words is only done with libstdc++, whose layout is known. Other standard libraries
+        // (libc++, MSVC) and builds with JREFLECT_DISABLE_VECTOR_BOOL_WORDS pack the bits one by one
+        static jutils::uint64* GetWords([[maybe_unused]] std::vector<bool>& valueArray)
+        {
+#if defined(__GLIBCXX__) && !defined(JREFLECT_DISABLE_VECTOR_BOOL_WORDS)
+            if constexpr (std::is_same_v<std::_Bit_type, jutils::uint64>)
+            {
+                return reinterpret_cast<jutils::uint64*>(valueArray.begin()._M_p);
+            }
+#endif
+            return nullptr;
+        }
+        static const jutils::uint64* GetWords(const std::vector<bool>& valueArray)
+        {
+            return GetWords(const_cast<std::vector<bool>&>(valueArray));
+        }
+        static jutils::uint64 GetLastWordMask(const jutils::index_type bitCount)
+        {
+            return bitCount % 64 != 0 ? (static_cast<jutils::uint64>(1) << (bitCount % 64)) - 1 : ~static_cast<jutils::uint64>(0);
+        }
+        static jutils::uint64 GetWordMask(const jutils::index_type wordIndex, const jutils::index_type bitCount)
+        {
+            return wordIndex == GetWordCount(bitCount) - 1 ? GetLastWordMask(bitCount) : ~static_cast<jutils::uint64>(0);
+        }
+        static jutils::uint64 PackWord(const std::vector<bool>& valueArray, const jutils::index_type wordIndex)
+        {
+            const std::size_t first = static_cast<std::size_t>(wordIndex) * 64;
+            const std::size_t last = jutils::math::min(first + 64, valueArray.size());
+            jutils::uint64 word = 0;
+            for (std::size_t index = first; index < last; index++)
+            {
+                word |= static_cast<jutils::uint64>(valueArray[index]) << (index - first);
+            }
+            return word;
+        }
+        static void UnpackWord(std::vector<bool>& valueArray, const jutils::index_type wordIndex, const jutils::uint64 word)
+        {
+            const std::size_t first = static_cast<std::size_t>(wordIndex) * 64;
+            const std::size_t last = jutils::math::min(first + 64, valueArray.size());
+            for (std::size_t index = first; index < last; index++)
+            {
+                valueArray[index] = ((word >> (index - first)) & 1) != 0;
+            }
+        }
+        // x86 builds without POPCNT compile std::popcount to a libgcc call, the bit trick is about three times faster there
+        static jutils::index_type CountBits(jutils::uint64 word)
+        {
+#if (defined(__x86_64__) || defined(__i386__)) && !defined(__POPCNT__)
+            word -= (word >> 1) & 0x5555555555555555ull;
+            word = (word & 0x3333333333333333ull) + ((word >> 2) & 0x3333333333333333ull);
+            word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+            return static_cast<jutils::index_type>((word * 0x0101010101010101ull) >> 56);
+#else
+            return std::popcount(word);
+#endif
+        }
+        static jutils::uint64 GetMaskedWord(const std::vector<bool>& valueArray, const jutils::index_type wordIndex, const jutils::index_type size)
+        {
+            const jutils::uint64* words = GetWords(valueArray);
+            const jutils::uint64 word = words != nullptr ? words[wordIndex] : PackWord(valueArray, wordIndex);
+            return word & GetWordMask(wordIndex, size);
+        }
+
+        jutils::index_type findFirst(const void* valuePtr, const jutils::index_type startIndex, const bool clearBit) const
+        {
+            const auto* valueArray = valuePtr != nullptr ? GetArray(valuePtr) : nullptr;
+            if ((valueArray == nullptr) || (startIndex < 0))
+            {
+                return jutils::index_invalid;
+            }
+            const auto size = static_cast<jutils::index_type>(valueArray->size());
+            for (jutils::index_type wordIndex = startIndex / 64; wordIndex < GetWordCount(size); wordIndex++)
+            {
+                jutils::uint64 word = GetMaskedWord(*valueArray, wordIndex, size);
+                if (clearBit)
+                {
+                    word = ~word & GetWordMask(wordIndex, size);
+                }
+                if (wordIndex == startIndex / 64)
+                {
+                    word &= ~static_cast<jutils::uint64>(0) << (startIndex % 64);
+                }
+                if (word != 0)
+                {
+                    return wordIndex * 64 + std::countr_zero(word);
+                }
+            }
+            return jutils::index_invalid;
+        }
+        template<typename F>
+        bool applyMask(void* valuePtr, const jutils::uint64* mask, const jutils::index_type maskWordCount, F&& operation) const
+        {
+            auto* valueArray = valuePtr != nullptr ? GetArray(valuePtr) : nullptr;
+            if ((valueArray == nullptr) || (maskWordCount < 0) || ((mask == nullptr) && (maskWordCount > 0)))
+            {
+                return false;
+            }
+            const auto size = static_cast<jutils::index_type>(valueArray->size());
+            const jutils::index_type wordCount = jutils::math::min(GetWordCount(size), maskWordCount);
+            jutils::uint64* words = GetWords(*valueArray);
+            for (jutils::index_type wordIndex = 0; wordIndex < wordCount; wordIndex++)
+            {
+                if (words != nullptr)
+                {
+                    // Bits past the end of the array stay clear, the storage may expose them later
+                    words[wordIndex] = operation(words[wordIndex], mask[wordIndex]) & GetWordMask(wordIndex, size);
+                }
+                else
+                {
+                    UnpackWord(*valueArray, wordIndex, operation(PackWord(*valueArray, wordIndex), mask[wordIndex]));
+                }
+            }
+            return true;
+        }
     };
     template<> struct value_type_info<value_type::array_bool> { using type = value_array_bool; };
     template<> struct value_info<std::vector<bool>> : std::integral_constant<value_type, value_type::array_bool>
     {
-        static jreflect::value* create() { return new value_array_bool(); }
+        static jreflect::value* get() { static value_array_bool descriptor; return &descriptor; }
+        [[deprecated("Use get(), descriptors are shared")]] static jreflect::value* create() { return new value_array_bool(); }
     };
 
     class value_array : public value
@@ -590,6 +1465,17 @@ namespace jreflect
         virtual void remove(void* valuePtr, jutils::index_type index) const = 0;
         virtual void clear(void* valuePtr) const = 0;
 
+        virtual void reserve(void* valuePtr, jutils::index_type capacity) const = 0;
+        virtual void resize(void* valuePtr, jutils::index_type size) const = 0;
+        // Inserts default elements, returns the first of them
+        virtual void* insert(void* valuePtr, jutils::index_type index, jutils::index_type count) const = 0;
+        virtual void remove(void* valuePtr, jutils::index_type index, jutils::index_type count) const = 0;
+
+        [[nodiscard]] virtual std::size_t getElementStride() const = 0;
+        // Contiguous storage, only for trivially copyable elements (nullptr otherwise)
+        [[nodiscard]] virtual void* getData(void* valuePtr) const = 0;
+        [[nodiscard]] virtual const void* getData(const void* valuePtr) const = 0;
+
     private:
 
         value* m_ElementValue = nullptr;
@@ -598,7 +1484,7 @@ namespace jreflect
     class value_array_impl : public value_array
     {
     public:
-        value_array_impl() : value_array(create_value<T>()) {}
+        value_array_impl() : value_array(get_value<T>()) {}
 
         virtual jutils::index_type getSize(const void* valuePtr) const override
         {
@@ -643,6 +1529,77 @@ namespace jreflect
             }
         }
 
+        virtual void reserve(void* valuePtr, const jutils::index_type capacity) const override
+        {
+            if ((valuePtr != nullptr) && (capacity > 0))
+            {
+                GetArray(valuePtr)->reserve(capacity);
+            }
+        }
+        virtual void resize(void* valuePtr, const jutils::index_type size) const override
+        {
+            if ((valuePtr != nullptr) && (size >= 0))
+            {
+                GetArray(valuePtr)->resize(size);
+            }
+        }
+        virtual void* insert(void* valuePtr, const jutils::index_type index, const jutils::index_type count) const override
+        {
+            if ((valuePtr == nullptr) || (count < 0))
+            {
+                return nullptr;
+            }
+            auto* valueArray = GetArray(valuePtr);
+            const jutils::index_type size = valueArray->getSize();
+            if ((index < 0) || (index > size))
+            {
+                return nullptr;
+            }
+            if (count == 0)
+            {
+                return index < size ? &valueArray->get(index) : nullptr;
+            }
+            // New elements are default constructed at the end and rotated into place, T only has to be movable
+            valueArray->resize(size + count);
+            T* data = valueArray->getData();
+            std::rotate(data + index, data + size, data + size + count);
+            return data + index;
+        }
+        virtual void remove(void* valuePtr, const jutils::index_type index, const jutils::index_type count) const override
+        {
+            if ((valuePtr == nullptr) || (count <= 0))
+            {
+                return;
+            }
+            auto* valueArray = GetArray(valuePtr);
+            const jutils::index_type size = valueArray->getSize();
+            if ((index < 0) || (index > size - count))
+            {
+                return;
+            }
+            T* data = valueArray->getData();
+            std::move(data + index + count, data + size, data + index);
+            valueArray->resize(size - count);
+        }
+
+        [[nodiscard]] virtual std::size_t getElementStride() const override { return sizeof(T); }
+        [[nodiscard]] virtual void* getData(void* valuePtr) const override
+        {
+            if constexpr (std::is_trivially_copyable_v<T>)
+            {
+                return valuePtr != nullptr ? GetArray(valuePtr)->getData() : nullptr;
+            }
+            return nullptr;
+        }
+        [[nodiscard]] virtual const void* getData(const void* valuePtr) const override
+        {
+            if constexpr (std::is_trivially_copyable_v<T>)
+            {
+                return valuePtr != nullptr ? GetArray(valuePtr)->getData() : nullptr;
+            }
+            return nullptr;
+        }
+
     private:
 
         static jutils::jarray<T>* GetArray(void* valuePtr) { return static_cast<jutils::jarray<T>*>(valuePtr); }
@@ -652,8 +1609,109 @@ namespace jreflect
     JUTILS_TEMPLATE_CONDITION((!std::is_same_v<T, bool> && (value_info<T>::value != value_type::none)), typename T)
     struct value_info<jutils::jarray<T>> : std::integral_constant<value_type, value_type::array>
     {
-        static jreflect::value* create() { return new value_array_impl<T>(); }
+        static jreflect::value* get() { static value_array_impl<T> descriptor; return &descriptor; }
+        [[deprecated("Use get(), descriptors are shared")]] static jreflect::value* create() { return new value_array_impl<T>(); }
     };
+
+    inline void class_type::initSchemaHash()
+    {
+        jutils::uint64 hash = HashSchemaName(0xCBF29CE484222325ull, getName());
+        hash = HashSchemaValue(hash, static_cast<jutils::uint64>(getObjectSize()));
+        for (const auto& field : m_FieldTable)
+        {
+            hash = HashSchemaName(hash, field.name);
+            hash = HashSchemaValue(hash, static_cast<jutils::uint64>(field.offset));
+            hash = HashSchemaValue(hash, static_cast<jutils::uint8>(field.type));
+
+            const value* fieldValue = field.fieldValue;
+            if (field.type == value_type::object)
+            {
+                class_type* objectType = fieldValue->cast<value_type::object>()->getObjectType();
+                objectType->initialize();
+                hash = HashSchemaValue(hash, objectType->getSchemaHash());
+                continue;
+            }
+            if (field.type == value_type::array)
+            {
+                fieldValue = fieldValue->cast<value_type::array>()->getElementValue();
+                hash = HashSchemaValue(hash, static_cast<jutils::uint8>(fieldValue->getType()));
+            }
+            if (fieldValue->getType() == value_type::object)
+            {
+                hash = HashSchemaName(hash, fieldValue->cast<value_type::object>()->getObjectType()->getName());
+            }
+            else if (fieldValue->getType() == value_type::object_ptr)
+            {
+                hash = HashSchemaName(hash, fieldValue->cast<value_type::object_ptr>()->getObjectType()->getName());
+            }
+        }
+        m_SchemaHash = hash;
+    }
+#if defined(JREFLECT_ENABLE_INSTRUMENTATION)
+    inline instrumentation_internal::class_counters& instrumentation_internal::GetClassCounters(const class_type* classType)
+    {
+        class_counters* counters = classType->m_InstrumentationCounters.load(std::memory_order_acquire);
+        if (counters == nullptr)
+        {
+            const std::lock_guard lock(RegistryMutex);
+            counters = classType->m_InstrumentationCounters.load(std::memory_order_relaxed);
+            if (counters == nullptr)
+            {
+                counters = CreateClassCounters(classType);
+                classType->m_InstrumentationCounters.store(counters, std::memory_order_release);
+            }
+        }
+        return *counters;
+    }
+    inline void instrumentation_internal::RecordFieldAccess(const class_type* classType, const jutils::index_type fieldIndex)
+    {
+        if ((classType != nullptr) && (classType->m_FieldAccessCounts != nullptr) && (fieldIndex >= 0))
+        {
+            classType->m_FieldAccessCounts[fieldIndex].fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+#endif
+    inline void class_type::initPointerEdges()
+    {
+        m_PointerEdges.clear();
+        for (const auto& field : m_FieldTable)
+        {
+            switch (field.type)
+            {
+            case value_type::object_ptr:
+                m_PointerEdges.add({ .offset = field.offset, .fieldValue = field.fieldValue });
+                break;
+
+            case value_type::object:
+                {
+                    class_type* objectType = field.fieldValue->cast<value_type::object>()->getObjectType();
+                    objectType->initialize();
+                    for (const auto& edge : objectType->getPointerEdges())
+                    {
+                        m_PointerEdges.add({ .offset = field.offset + edge.offset, .fieldValue = edge.fieldValue });
+                    }
+                }
+                break;
+
+            case value_type::array:
+                {
+                    // Element classes are not initialized here, arrays may hold objects of this class
+                    const value* elementValue = field.fieldValue->cast<value_type::array>()->getElementValue();
+                    while (elementValue->getType() == value_type::array)
+                    {
+                        elementValue = elementValue->cast<value_type::array>()->getElementValue();
+                    }
+                    if ((elementValue->getType() == value_type::object_ptr) || (elementValue->getType() == value_type::object))
+                    {
+                        m_PointerEdges.add({ .offset = field.offset, .fieldValue = field.fieldValue });
+                    }
+                }
+                break;
+
+            default: ;
+            }
+        }
+    }
 }
 
 JUTILS_STRING_FORMATTER_CONSTEXPR(jreflect::value_type, jreflect::value_type_to_string);
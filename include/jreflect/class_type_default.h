@@ -6,9 +6,9 @@
 
 #include <jutils/marco_wrap.h>
 
-#define JREFLECT_CLASS_FIELD_NAMED(Field, FieldName)            \
-(jreflect::class_type::create_field_info<decltype(type::Field)>{\
-    .name = (FieldName), .offset = offsetof(type, Field)        \
+#define JREFLECT_CLASS_FIELD_NAMED(Field, FieldName)                                        \
+(jreflect::class_field_info<decltype(type::Field), std::decay_t<decltype(FieldName)>>{      \
+    .name = (FieldName), .offset = offsetof(type, Field)                                    \
 })
 #define JREFLECT_CLASS_FIELD(Field) JREFLECT_CLASS_FIELD_NAMED(Field, #Field)
 
@@ -25,6 +25,8 @@ public:
         [[nodiscard]] virtual jutils::jstringID getName() const override { return GetName(); }                      \
         [[nodiscard]] static auto* GetParent() { return jreflect::class_type_info<parent_t>::get_class_type(); }    \
         [[nodiscard]] virtual jreflect::class_type* getParent() const override { return GetParent(); }              \
+        [[nodiscard]] virtual std::size_t getObjectSize() const override { return sizeof(type); }                   \
+        [[nodiscard]] virtual std::size_t getObjectAlignment() const override { return alignof(type); }             \
     protected:                                                                                                      \
         __VA_OPT__(virtual void initializeClassType() override {                                                    \
             parent_t::class_type_t::initializeClassType();                                                          \
@@ -32,19 +34,58 @@ public:
         })                                                                                                          \
         virtual bool isDerivedFromClass(const jreflect::class_type* classType) const override                       \
             { return (type::GetClassType() == classType) || parent_t::class_type_t::isDerivedFromClass(classType); }\
-        virtual class_interface* createObjectInternal() const override { return new type(); }                       \
+        virtual jreflect::class_interface* constructObjectInternal(void* memory) const override                     \
+            { return ::new (memory) type(); }                                                                       \
+        virtual void* destructObjectInternal(jreflect::class_interface* object) const override                      \
+            { auto* typedObject = static_cast<type*>(object); typedObject->~type(); return typedObject; }           \
+        virtual const void* getObjectMemoryInternal(const jreflect::class_interface* object) const override         \
+            { return static_cast<const type*>(object); }                                                            \
     private:                                                                                                        \
+        static jreflect::class_type_registrar Registrar;                                                            \
         __VA_OPT__(void initFields_##ClassName();)                                                                  \
     };                                                                                                              \
+    friend struct jreflect::static_class_info<ClassName>;                                                           \
     using class_type_t = class_type_##ClassName;                                                                    \
     [[nodiscard]] static class_type_t* GetClassType()  { static class_type_t classType; return &classType; }        \
     [[nodiscard]] virtual jreflect::class_type* getClassType() const override { return GetClassType(); }
     
+// Leaves the class in the public section, like JREFLECT_CLASS_TYPE.
+// Fields are marked by field_ref::modify()/set(), modifyValuePtr(), scatterValues(), read_object_delta() and json_reader.
+// getValuePtr() doesn't mark anything, a value_*::set() on its pointer or a plain member write goes unnoticed
+#define JREFLECT_CLASS_DIRTY_FIELDS()                                                                               \
+private:                                                                                                            \
+    jreflect::dirty_fields m_DirtyFields;                                                                           \
+public:                                                                                                             \
+    static constexpr bool HasDirtyFields = true;                                                                    \
+    [[nodiscard]] virtual jreflect::dirty_fields* getDirtyFields() override { return &m_DirtyFields; }              \
+    [[nodiscard]] virtual const jreflect::dirty_fields* getDirtyFields() const override { return &m_DirtyFields; }
+
 #define JREFLECT_HELPER_INIT_CLASS_FIELD(Info) {                                \
     auto createInfo = Info;                                                     \
     createField<decltype(createInfo)::type>(createInfo.name, createInfo.offset);\
 }
+#define JREFLECT_HELPER_REGISTER_CLASS_TYPE(Namespace, ClassName)                   \
+jreflect::class_type_registrar Namespace::ClassName::class_type_t::Registrar(       \
+    []() -> jreflect::class_type* { return Namespace::ClassName::GetClassType(); }  \
+);
 #define JREFLECT_INIT_CLASS_TYPE(Namespace, ClassName, ...)                     \
+JREFLECT_HELPER_REGISTER_CLASS_TYPE(Namespace, ClassName)                       \
 __VA_OPT__(void Namespace::ClassName::class_type_t::initFields_##ClassName() {  \
     JUTILS_WRAP(JREFLECT_HELPER_INIT_CLASS_FIELD, __VA_ARGS__)                  \
-})
\ No newline at end of file
+})
+
+#define JREFLECT_STATIC_CLASS_TYPE(Namespace, ClassName, ...)               \
+template<> struct jreflect::static_class_info<Namespace::ClassName>         \
+{                                                                           \
+    using type = Namespace::ClassName;                                      \
+    static constexpr bool valid = true;                                     \
+    static constexpr auto fields = std::make_tuple(__VA_ARGS__);            \
+};
+#define JREFLECT_INIT_STATIC_CLASS_TYPE(Namespace, ClassName)                               \
+JREFLECT_HELPER_REGISTER_CLASS_TYPE(Namespace, ClassName)                                   \
+void Namespace::ClassName::class_type_t::initFields_##ClassName() {                         \
+    std::apply([this](const auto&... createInfo) {                                          \
+        (createField<typename std::remove_cvref_t<decltype(createInfo)>::type>(             \
+            createInfo.name, createInfo.offset), ...);                                      \
+    }, jreflect::static_class_info<Namespace::ClassName>::fields);                          \
+}
@@ -4,59 +4,367 @@
 
 #include "class_type.h"
 
+#include <atomic>
+#include <memory>
+#include <mutex>
+
 namespace jreflect
 {
-    jutils::jarray<jreflect::class_type*> get_all_class_types();
-
     class database
     {
     private:
         database() { initDatabase(); }
-        ~database() = default;
+        ~database() { clearDatabase(); }
 
     public:
         
         static void CreateInstance() noexcept
         {
-            if (Instance == nullptr)
+            if (Instance.load(std::memory_order_acquire) == nullptr)
             {
-                Instance = new database();
+                const std::lock_guard lock(InstanceMutex);
+                if (Instance.load(std::memory_order_relaxed) == nullptr)
+                {
+                    Instance.store(new database(), std::memory_order_release);
+                }
             }
         }
+        // Classes registered after the database was built (later static initializers or libraries loaded at runtime)
+        // are added here. The class table is rebuilt on the side and swapped in, lookups on other threads keep using
+        // the previous one
         [[nodiscard]] static database* GetInstanse() noexcept
         {
-            CreateInstance();
-            return Instance;
+            database* instance = Instance.load(std::memory_order_acquire);
+            if (instance == nullptr)
+            {
+                CreateInstance();
+                instance = Instance.load(std::memory_order_acquire);
+            }
+            else if (instance->getTable()->firstRegistrar != class_type_registrar::GetFirst())
+            {
+                const std::lock_guard lock(InstanceMutex);
+                instance->updateDatabase();
+            }
+            return instance;
         }
         static void ClearInstance() noexcept
         {
-            if (Instance != nullptr)
+            const std::lock_guard lock(InstanceMutex);
+            delete Instance.exchange(nullptr, std::memory_order_acq_rel);
+        }
+
+        [[nodiscard]] const auto& getClassTypes() const { return getTable()->classTypes; }
+        // Classes left out of the database because another registered class has the same name
+        [[nodiscard]] const jutils::jarray<class_type*>& getNameConflicts() const { return getTable()->nameConflicts; }
+        [[nodiscard]] class_interface* createObject(const jutils::jstringID& name, object_allocator* allocator = nullptr) const
+        {
+            class_type* classType = findClassType(name);
+            return classType != nullptr ? classType->createObject(allocator) : nullptr;
+        }
+        static bool DestroyObject(class_interface* object, object_allocator* allocator = nullptr)
+        {
+            return class_type::DestroyObject(object, allocator);
+        }
+        [[nodiscard]] jutils::uint64 getSchemaHash(const jutils::jstringID& name) const
+        {
+            class_type* classType = findClassType(name);
+            if (classType == nullptr)
             {
-                delete Instance;
-                Instance = nullptr;
+                return 0;
             }
+            classType->initialize();
+            return classType->getSchemaHash();
         }
 
-        [[nodiscard]] const auto& getClassTypes() const { return m_ClassTypes; }
+        [[nodiscard]] class_type* findClassType(const jutils::jstringID& name) const
+        {
+            JREFLECT_INSTRUMENT(const instrumentation_timer instrumentationTimer);
+            const class_table* table = getTable();
+            class_type* classType = nullptr;
+            if (table->lookupSlots.isEmpty())
+            {
+                class_type* const* classTypePtr = table->classTypes.find(name);
+                classType = classTypePtr != nullptr ? *classTypePtr : nullptr;
+            }
+            else
+            {
+                const std::size_t nameHash = hash_name(name);
+                const jutils::uint32 seed = table->lookupSeeds.get(GetLookupBucket(nameHash, table->lookupSeeds.getSize()));
+                const lookup_slot& slot = table->lookupSlots.get(GetLookupSlot(nameHash, seed, table->lookupSlots.getSize()));
+                classType = slot.name == name ? slot.classType : nullptr;
+            }
+            JREFLECT_INSTRUMENT(instrumentation_internal::RecordClassLookup(classType, instrumentationTimer));
+            return classType;
+        }
 
     private:
 
-        inline static database* Instance = nullptr;
+        inline static std::atomic<database*> Instance = nullptr;
+        inline static std::mutex InstanceMutex;
+
+        struct lookup_slot
+        {
+            jutils::jstringID name = jutils::jstringID_NONE;
+            class_type* classType = nullptr;
+        };
+
+        static constexpr jutils::uint32 MaxLookupSeed = 1 << 16;
+        static constexpr jutils::uint16 MaxHierarchyGeneration = 0xFFFE;
+
+        // Immutable once published, readers never lock
+        struct class_table
+        {
+            jutils::jmap<jutils::jstringID, jreflect::class_type*> classTypes;
+            // Perfect hash over classTypes (hash and displace): each bucket seed gives collision-free slots
+            jutils::jarray<jutils::uint32> lookupSeeds;
+            jutils::jarray<lookup_slot> lookupSlots;
+            jutils::jarray<class_type*> nameConflicts;
+            // Registrar list head the table was built from
+            const class_type_registrar* firstRegistrar = nullptr;
+            jutils::uint16 generation = 0;
+            // Replaced tables stay alive until the database is destroyed, another thread may still be reading them
+            std::unique_ptr<const class_table> previous;
+        };
+
+        std::atomic<const class_table*> m_Table = nullptr;
 
-        jutils::jmap<jutils::jstringID, jreflect::class_type*> m_ClassTypes;
 
+        [[nodiscard]] const class_table* getTable() const { return m_Table.load(std::memory_order_acquire); }
 
         void initDatabase()
         {
-            const auto classTypes = jreflect::get_all_class_types();
-            for (const auto& classType : classTypes)
+            m_Table.store(new class_table(), std::memory_order_release);
+            updateDatabase();
+        }
+        void updateDatabase()
+        {
+            const class_table* lastTable = m_Table.load(std::memory_order_relaxed);
+            const class_type_registrar* firstRegistrar = class_type_registrar::GetFirst();
+            if (firstRegistrar == lastTable->firstRegistrar)
             {
+                return;
+            }
+
+            auto table = std::make_unique<class_table>();
+            table->classTypes = lastTable->classTypes;
+            table->nameConflicts = lastTable->nameConflicts;
+            table->firstRegistrar = firstRegistrar;
+            table->generation = lastTable->generation < MaxHierarchyGeneration ? lastTable->generation + 1 : 0;
+            for (const class_type_registrar* registrar = firstRegistrar; registrar != lastTable->firstRegistrar; registrar = registrar->getNext())
+            {
+                class_type* classType = registrar->getClassType();
                 assert(classType != nullptr);
                 if (classType != nullptr)
                 {
-                    m_ClassTypes.add(classType->getName(), classType);
+                    AddClassType(*table, classType);
+                }
+            }
+
+            InitHierarchy(*table);
+            InitLookupTable(*table);
+            table->previous.reset(lastTable);
+            m_Table.store(table.release(), std::memory_order_release);
+        }
+        void clearDatabase()
+        {
+            const class_table* table = m_Table.exchange(nullptr, std::memory_order_acq_rel);
+            if (table != nullptr)
+            {
+                for (const auto& [name, classType] : table->classTypes)
+                {
+                    classType->clearHierarchyRange();
+                }
+                delete table;
+            }
+        }
+
+        // Classes are looked up by their short name, classes from different namespaces with the same name would
+        // silently replace each other. None of them is kept, so a name never resolves to the wrong class
+        static void AddClassType(class_table& table, class_type* classType)
+        {
+            const jutils::jstringID name = classType->getName();
+            class_type* const* registeredType = table.classTypes.find(name);
+            if (registeredType == nullptr)
+            {
+                const bool conflicting = std::find_if(table.nameConflicts.begin(), table.nameConflicts.end(), [&name](const class_type* conflict) {
+                    return conflict->getName() == name;
+                }) != table.nameConflicts.end();
+                if (!conflicting)
+                {
+                    table.classTypes.add(name, classType);
+                    return;
+                }
+            }
+            else if (*registeredType != classType)
+            {
+                table.nameConflicts.add(*registeredType);
+                (*registeredType)->clearHierarchyRange();
+                table.classTypes.remove(name);
+            }
+            else
+            {
+                return;
+            }
+            table.nameConflicts.add(classType);
+        }
+
+        static jutils::uint64 MixHash(jutils::uint64 hash)
+        {
+            hash ^= hash >> 33;
+            hash *= 0xFF51AFD7ED558CCDull;
+            hash ^= hash >> 33;
+            hash *= 0xC4CEB9FE1A85EC53ull;
+            hash ^= hash >> 33;
+            return hash;
+        }
+        static jutils::index_type GetLookupBucket(const std::size_t nameHash, const jutils::index_type bucketCount)
+        {
+            return static_cast<jutils::index_type>(MixHash(nameHash) % static_cast<jutils::uint64>(bucketCount));
+        }
+        static jutils::index_type GetLookupSlot(const std::size_t nameHash, const jutils::uint32 seed, const jutils::index_type slotCount)
+        {
+            return static_cast<jutils::index_type>(
+                MixHash(nameHash ^ (static_cast<jutils::uint64>(seed + 1) * 0x9E3779B97F4A7C15ull)) % static_cast<jutils::uint64>(slotCount)
+            );
+        }
+
+        static void InitLookupTable(class_table& table)
+        {
+            const jutils::index_type count = table.classTypes.getSize();
+            if (count == 0)
+            {
+                return;
+            }
+
+            jutils::jarray<lookup_slot> entries;
+            jutils::jarray<std::size_t> entryHashes;
+            entries.reserve(count);
+            entryHashes.reserve(count);
+            for (const auto& [name, classType] : table.classTypes)
+            {
+                entries.add({ .name = name, .classType = classType });
+                entryHashes.add(hash_name(name));
+            }
+
+            const jutils::index_type bucketCount = jutils::math::max(count / 4, 1);
+            const jutils::index_type slotCount = count + count / 4;
+            jutils::jarray<jutils::jarray<jutils::index_type>> buckets;
+            buckets.resize(bucketCount);
+            for (jutils::index_type index = 0; index < count; index++)
+            {
+                buckets.get(GetLookupBucket(entryHashes.get(index), bucketCount)).add(index);
+            }
+            jutils::jarray<jutils::index_type> bucketOrder;
+            bucketOrder.reserve(bucketCount);
+            for (jutils::index_type index = 0; index < bucketCount; index++)
+            {
+                bucketOrder.add(index);
+            }
+            std::stable_sort(bucketOrder.begin(), bucketOrder.end(), [&buckets](const jutils::index_type index1, const jutils::index_type index2) {
+                return buckets.get(index1).getSize() > buckets.get(index2).getSize();
+            });
+
+            jutils::jarray<jutils::uint32> seeds;
+            jutils::jarray<lookup_slot> slots;
+            jutils::jarray<jutils::index_type> bucketSlots;
+            seeds.resize(bucketCount);
+            slots.resize(slotCount);
+            for (const auto& bucketIndex : bucketOrder)
+            {
+                const auto& bucket = buckets.get(bucketIndex);
+                if (bucket.isEmpty())
+                {
+                    break;
+                }
+
+                bool placed = false;
+                for (jutils::uint32 seed = 0; !placed && (seed < MaxLookupSeed); seed++)
+                {
+                    bucketSlots.clear();
+                    placed = true;
+                    for (const auto& entryIndex : bucket)
+                    {
+                        const jutils::index_type slotIndex = GetLookupSlot(entryHashes.get(entryIndex), seed, slotCount);
+                        if ((slots.get(slotIndex).classType != nullptr) ||
+                            (std::find(bucketSlots.begin(), bucketSlots.end(), slotIndex) != bucketSlots.end()))
+                        {
+                            placed = false;
+                            break;
+                        }
+                        bucketSlots.add(slotIndex);
+                    }
+                    if (placed)
+                    {
+                        seeds.get(bucketIndex) = seed;
+                        for (jutils::index_type index = 0; index < bucket.getSize(); index++)
+                        {
+                            slots.get(bucketSlots.get(index)) = entries.get(bucket.get(index));
+                        }
+                    }
+                }
+                if (!placed)
+                {
+                    // Identical name hashes can't be separated, findClassType() falls back to classTypes
+                    return;
+                }
+            }
+
+            table.lookupSeeds = std::move(seeds);
+            table.lookupSlots = std::move(slots);
+        }
+
+        static void InitHierarchy(const class_table& table)
+        {
+            jutils::jmap<const class_type*, jutils::jarray<class_type*>> children;
+            jutils::jarray<class_type*> roots;
+            for (const auto& [name, classType] : table.classTypes)
+            {
+                // Unregistered parents (e.g. fieldless classes without JREFLECT_INIT_CLASS_TYPE) are skipped, otherwise
+                // the class would become a root and lose its registered ancestors
+                const class_type* parent = classType->getParent();
+                while ((parent != nullptr) && !IsRegistered(table, parent))
+                {
+                    parent = parent->getParent();
+                }
+                if (parent != nullptr)
+                {
+                    auto* parentChildren = children.find(parent);
+                    if (parentChildren == nullptr)
+                    {
+                        parentChildren = &children.put(parent);
+                    }
+                    parentChildren->add(classType);
+                }
+                else
+                {
+                    roots.add(classType);
+                }
+            }
+
+            jutils::index_type index = 0;
+            for (const auto& classType : roots)
+            {
+                AssignHierarchyIndex(classType, children, table.generation, index);
+            }
+        }
+        [[nodiscard]] static bool IsRegistered(const class_table& table, const class_type* classType)
+        {
+            class_type* const* registeredType = table.classTypes.find(classType->getName());
+            return (registeredType != nullptr) && (*registeredType == classType);
+        }
+        static void AssignHierarchyIndex(class_type* classType, const jutils::jmap<const class_type*, jutils::jarray<class_type*>>& children,
+            const jutils::uint16 generation, jutils::index_type& index)
+        {
+            const jutils::index_type hierarchyIndex = index++;
+            const auto* childTypes = children.find(classType);
+            if (childTypes != nullptr)
+            {
+                for (const auto& childType : *childTypes)
+                {
+                    AssignHierarchyIndex(childType, children, generation, index);
                 }
             }
+            classType->setHierarchyRange(hierarchyIndex, index, generation);
         }
     };
 }
@@ -0,0 +1,86 @@
+﻿// Copyright © 2024 Leonov Maksim. All Rights Reserved.
+
+#pragma once
+
+#include "class_type.h"
+
+namespace jreflect
+{
+    template<typename Class, typename T>
+    class field_ref
+    {
+        static_assert(has_class_type_v<Class>);
+        static_assert(value_type_v<T> != value_type::none);
+
+    public:
+        using class_t = Class;
+        using type = T;
+
+        field_ref() = default;
+        explicit field_ref(const jutils::jstringID& name) { bind(name); }
+
+        bool bind(const jutils::jstringID& name)
+        {
+            m_Offset = InvalidOffset;
+            m_FieldIndex = jutils::index_invalid;
+
+            class_type* classType = get_class_type<Class>();
+            if (classType == nullptr)
+            {
+                return false;
+            }
+            classType->initialize();
+
+            const class_field_entry* field = classType->findField(name);
+            if ((field == nullptr) || (field->typeID != type_id<T>()))
+            {
+                return false;
+            }
+            m_Offset = field->offset;
+            m_FieldIndex = field->index;
+            return true;
+        }
+
+        [[nodiscard]] bool isValid() const { return m_Offset != InvalidOffset; }
+        [[nodiscard]] std::size_t getOffset() const { return m_Offset; }
+        [[nodiscard]] jutils::index_type getFieldIndex() const { return m_FieldIndex; }
+
+        [[nodiscard]] T& get(Class& object) const
+        {
+            assert(isValid());
+            return *reinterpret_cast<T*>(reinterpret_cast<jutils::uint8*>(static_cast<class_interface*>(&object)) + m_Offset);
+        }
+        [[nodiscard]] const T& get(const Class& object) const
+        {
+            assert(isValid());
+            return *reinterpret_cast<const T*>(reinterpret_cast<const jutils::uint8*>(static_cast<const class_interface*>(&object)) + m_Offset);
+        }
+        // Dirty tracking is resolved from Class at compile time, final classes without JREFLECT_CLASS_DIRTY_FIELDS() pay nothing.
+        // Otherwise the object is asked at runtime, a derived class may have added the tracking
+        [[nodiscard]] T& modify(Class& object) const
+        {
+            if constexpr (has_dirty_fields_v<Class>)
+            {
+                object.getDirtyFields()->mark(m_FieldIndex);
+            }
+            else if constexpr (!std::is_final_v<Class>)
+            {
+                dirty_fields* dirtyFields = object.getDirtyFields();
+                if (dirtyFields != nullptr)
+                {
+                    dirtyFields->mark(m_FieldIndex);
+                }
+            }
+            return get(object);
+        }
+        void set(Class& object, const T& value) const { modify(object) = value; }
+        void set(Class& object, T&& value) const { modify(object) = std::move(value); }
+
+    private:
+
+        static constexpr std::size_t InvalidOffset = static_cast<std::size_t>(-1);
+
+        std::size_t m_Offset = InvalidOffset;
+        jutils::index_type m_FieldIndex = jutils::index_invalid;
+    };
+}
@@ -0,0 +1,419 @@
+﻿// Copyright © 2024 Leonov Maksim. All Rights Reserved.
+
+#pragma once
+
+#include "class_type.h"
+
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+
+namespace jreflect
+{
+    // Insert-only pointer set, safe to use from several threads without locks. A full table is sealed and chained to
+    // one twice its size instead of being rehashed, so pass the expected count to keep the chain short
+    class object_visited_set
+    {
+    public:
+        explicit object_visited_set(const std::size_t expectedCount = 0) { reset(expectedCount); }
+        object_visited_set(const object_visited_set&) = delete;
+
+        object_visited_set& operator=(const object_visited_set&) = delete;
+
+        [[nodiscard]] std::size_t getSize() const
+        {
+            std::size_t size = 0;
+            for (const table* currentTable = m_Table.get(); currentTable != nullptr; currentTable = currentTable->findNext())
+            {
+                size += currentTable->getSize();
+            }
+            return size;
+        }
+
+        bool insert(const class_interface* object)
+        {
+            if (object == nullptr)
+            {
+                return false;
+            }
+            const auto key = reinterpret_cast<std::uintptr_t>(object);
+            for (table* currentTable = m_Table.get(); ; currentTable = currentTable->getNext())
+            {
+                switch (currentTable->insert(key))
+                {
+                case insert_result::inserted: return true;
+                case insert_result::found:    return false;
+                case insert_result::sealed:   break;
+                }
+            }
+        }
+        [[nodiscard]] bool contains(const class_interface* object) const
+        {
+            if (object == nullptr)
+            {
+                return false;
+            }
+            const auto key = reinterpret_cast<std::uintptr_t>(object);
+            for (const table* currentTable = m_Table.get(); currentTable != nullptr; currentTable = currentTable->findNext())
+            {
+                if (currentTable->contains(key))
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // Not thread-safe, must not run concurrently with insert() or contains()
+        void reset(const std::size_t expectedCount = 0)
+        {
+            m_Table = std::make_unique<table>(std::bit_ceil(jutils::math::max(expectedCount * 2, MinCapacity)));
+        }
+
+    private:
+
+        static constexpr std::size_t MinCapacity = 64;
+
+        enum class insert_result : jutils::uint8 { inserted, found, sealed };
+
+        class table
+        {
+        public:
+            explicit table(const std::size_t capacity)
+                : m_Slots(std::make_unique<std::atomic<std::uintptr_t>[]>(capacity)), m_Capacity(capacity)
+            {}
+            ~table() { delete m_Next.load(std::memory_order_relaxed); }
+
+            [[nodiscard]] std::size_t getSize() const
+            {
+                // Exact once inserts have finished
+                const std::size_t settledCount = m_Settled.load(std::memory_order_acquire);
+                const std::size_t cancelledCount = m_Cancelled.load(std::memory_order_relaxed);
+                return settledCount > cancelledCount ? settledCount - cancelledCount : 0;
+            }
+            [[nodiscard]] const table* findNext() const { return m_Next.load(std::memory_order_acquire); }
+            table* getNext()
+            {
+                table* next = m_Next.load(std::memory_order_acquire);
+                if (next == nullptr)
+                {
+                    auto newTable = std::make_unique<table>(m_Capacity * 2);
+                    if (m_Next.compare_exchange_strong(next, newTable.get(), std::memory_order_acq_rel))
+                    {
+                        next = newTable.release();
+                    }
+                }
+                return next;
+            }
+
+            // A new key reserves one of the first Capacity / 2 places before claiming a slot, finding a key writes nothing.
+            // Inserts with the same key race for the same first empty slot. Once the reservations run out, an insert waits
+            // for the reserved ones to finish before deciding the key isn't here, which happens once per table
+            insert_result insert(const std::uintptr_t key)
+            {
+                const std::size_t maxSize = m_Capacity / 2;
+                const std::size_t mask = m_Capacity - 1;
+                bool reserved = false;
+                bool sealed = false;
+                std::size_t slot = GetSlot(key, mask);
+                for (std::size_t probe = 0; probe < m_Capacity; probe++, slot = (slot + 1) & mask)
+                {
+                    std::uintptr_t slotKey = m_Slots[slot].load(std::memory_order_acquire);
+                    if ((slotKey == 0) && !reserved)
+                    {
+                        if (!sealed)
+                        {
+                            sealed = (m_Reserved.load(std::memory_order_relaxed) >= maxSize)
+                                || (m_Reserved.fetch_add(1, std::memory_order_relaxed) >= maxSize);
+                            reserved = !sealed;
+                        }
+                        if (sealed)
+                        {
+                            while (m_Settled.load(std::memory_order_acquire) < maxSize)
+                            {
+                                std::this_thread::yield();
+                            }
+                            slotKey = m_Slots[slot].load(std::memory_order_acquire);
+                            if (slotKey == 0)
+                            {
+                                return insert_result::sealed;
+                            }
+                        }
+                    }
+                    if ((slotKey == 0) && m_Slots[slot].compare_exchange_strong(slotKey, key, std::memory_order_acq_rel))
+                    {
+                        return settle(reserved, insert_result::inserted);
+                    }
+                    if (slotKey == key)
+                    {
+                        return settle(reserved, insert_result::found);
+                    }
+                }
+                return settle(reserved, insert_result::sealed);
+            }
+            [[nodiscard]] bool contains(const std::uintptr_t key) const
+            {
+                const std::size_t mask = m_Capacity - 1;
+                std::size_t slot = GetSlot(key, mask);
+                for (std::size_t probe = 0; probe < m_Capacity; probe++, slot = (slot + 1) & mask)
+                {
+                    const std::uintptr_t slotKey = m_Slots[slot].load(std::memory_order_acquire);
+                    if (slotKey == key)
+                    {
+                        return true;
+                    }
+                    if (slotKey == 0)
+                    {
+                        return false;
+                    }
+                }
+                return false;
+            }
+
+        private:
+
+            std::unique_ptr<std::atomic<std::uintptr_t>[]> m_Slots;
+            std::size_t m_Capacity = 0;
+            std::atomic<std::size_t> m_Reserved = 0;
+            std::atomic<std::size_t> m_Settled = 0;
+            std::atomic<std::size_t> m_Cancelled = 0;
+            std::atomic<table*> m_Next = nullptr;
+
+
+            insert_result settle(const bool reserved, const insert_result result)
+            {
+                if (reserved)
+                {
+                    if (result != insert_result::inserted)
+                    {
+                        m_Cancelled.fetch_add(1, std::memory_order_relaxed);
+                    }
+                    m_Settled.fetch_add(1, std::memory_order_release);
+                }
+                return result;
+            }
+        };
+
+        std::unique_ptr<table> m_Table;
+
+
+        static std::size_t GetSlot(const std::uintptr_t key, const std::size_t mask)
+        {
+            return static_cast<std::size_t>((static_cast<jutils::uint64>(key >> 4) * 0x9E3779B97F4A7C15ull) >> 24) & mask;
+        }
+    };
+
+    namespace graph_internal
+    {
+        template<typename F>
+        void ForEachReference(class_interface* object, class_type* classType, F& func);
+
+        template<typename F>
+        void ForEachArrayReference(const value_array* arrayValue, void* arrayPtr, F& func)
+        {
+            const value* elementValue = arrayValue->getElementValue();
+            const jutils::index_type size = arrayValue->getSize(arrayPtr);
+            for (jutils::index_type index = 0; index < size; index++)
+            {
+                void* elementPtr = arrayValue->get(arrayPtr, index);
+                switch (elementValue->getType())
+                {
+                case value_type::object_ptr:
+                    {
+                        class_interface* target = nullptr;
+                        elementValue->cast<value_type::object_ptr>()->get(elementPtr, target);
+                        if (target != nullptr)
+                        {
+                            func(target);
+                        }
+                    }
+                    break;
+
+                case value_type::object:
+                    ForEachReference(static_cast<class_interface*>(elementPtr), elementValue->cast<value_type::object>()->getObjectType(), func);
+                    break;
+
+                case value_type::array:
+                    ForEachArrayReference(elementValue->cast<value_type::array>(), elementPtr, func);
+                    break;
+
+                default: ;
+                }
+            }
+        }
+        template<typename F>
+        void ForEachReference(class_interface* object, class_type* classType, F& func)
+        {
+            if ((object == nullptr) || (classType == nullptr))
+            {
+                return;
+            }
+            classType->initialize();
+
+            auto* objectData = reinterpret_cast<jutils::uint8*>(object);
+            for (const auto& edge : classType->getPointerEdges())
+            {
+                if (edge.fieldValue->getType() == value_type::object_ptr)
+                {
+                    class_interface* target = nullptr;
+                    edge.fieldValue->cast<value_type::object_ptr>()->get(objectData + edge.offset, target);
+                    if (target != nullptr)
+                    {
+                        func(target);
+                    }
+                }
+                else
+                {
+                    ForEachArrayReference(edge.fieldValue->cast<value_type::array>(), objectData + edge.offset, func);
+                }
+            }
+        }
+
+        struct work_queue
+        {
+            std::mutex mutex;
+            jutils::jarray<class_interface*> objects;
+        };
+    }
+
+    // Calls func for every non-null object referenced by the object's object_ptr fields, including ones inside
+    // nested objects and arrays
+    template<typename F>
+    void for_each_object_reference(class_interface* object, F&& func)
+    {
+        if (object != nullptr)
+        {
+            graph_internal::ForEachReference(object, object->getClassType(), func);
+        }
+    }
+
+    // Visits every object reachable from the roots exactly once, returns the number of visited objects
+    template<typename F>
+    std::size_t walk_object_graph(const std::span<class_interface* const> roots, F&& visitor, object_visited_set* visited = nullptr)
+    {
+        object_visited_set localVisited;
+        object_visited_set& visitedSet = visited != nullptr ? *visited : localVisited;
+        const std::size_t initialSize = visitedSet.getSize();
+
+        jutils::jarray<class_interface*> stack;
+        for (const auto& root : roots)
+        {
+            if (visitedSet.insert(root))
+            {
+                stack.add(root);
+            }
+        }
+        const auto pushReference = [&visitedSet, &stack](class_interface* target) {
+            if (visitedSet.insert(target))
+            {
+                stack.add(target);
+            }
+        };
+        while (!stack.isEmpty())
+        {
+            class_interface* object = stack.get(stack.getSize() - 1);
+            stack.removeAt(stack.getSize() - 1);
+            visitor(object);
+            graph_internal::ForEachReference(object, object->getClassType(), pushReference);
+        }
+        return visitedSet.getSize() - initialSize;
+    }
+
+    // Same as walk_object_graph() but spread over threads with work stealing, visitor is called concurrently
+    template<typename F>
+    std::size_t walk_object_graph_parallel(const std::span<class_interface* const> roots, F&& visitor, jutils::uint32 threadCount = 0,
+        object_visited_set* visited = nullptr)
+    {
+        if (threadCount == 0)
+        {
+            threadCount = jutils::math::max(std::thread::hardware_concurrency(), 1u);
+        }
+        if (threadCount == 1)
+        {
+            return walk_object_graph(roots, visitor, visited);
+        }
+
+        object_visited_set localVisited(roots.size());
+        object_visited_set& visitedSet = visited != nullptr ? *visited : localVisited;
+        const std::size_t initialSize = visitedSet.getSize();
+
+        auto queues = std::make_unique<graph_internal::work_queue[]>(threadCount);
+        std::atomic<std::size_t> pendingCount = 0;
+        jutils::uint32 nextQueue = 0;
+        for (const auto& root : roots)
+        {
+            if (visitedSet.insert(root))
+            {
+                queues[nextQueue].objects.add(root);
+                nextQueue = (nextQueue + 1) % threadCount;
+                pendingCount.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        const auto worker = [&](const jutils::uint32 threadIndex)
+        {
+            graph_internal::work_queue& ownQueue = queues[threadIndex];
+            jutils::jarray<class_interface*> batch;
+            jutils::jarray<class_interface*> references;
+            const auto pushReference = [&visitedSet, &references](class_interface* target) {
+                if (visitedSet.insert(target))
+                {
+                    references.add(target);
+                }
+            };
+            while (pendingCount.load(std::memory_order_acquire) > 0)
+            {
+                batch.clear();
+                for (jutils::uint32 offset = 0; (offset < threadCount) && batch.isEmpty(); offset++)
+                {
+                    // Own queue gives one object, other queues give away half of their objects
+                    graph_internal::work_queue& queue = queues[(threadIndex + offset) % threadCount];
+                    const std::lock_guard lock(queue.mutex);
+                    const jutils::index_type size = queue.objects.getSize();
+                    const jutils::index_type takeCount = offset == 0 ? (size > 0 ? 1 : 0) : (size + 1) / 2;
+                    for (jutils::index_type index = size - takeCount; index < size; index++)
+                    {
+                        batch.add(queue.objects.get(index));
+                    }
+                    queue.objects.resize(size - takeCount);
+                }
+                if (batch.isEmpty())
+                {
+                    std::this_thread::yield();
+                    continue;
+                }
+
+                for (const auto& object : batch)
+                {
+                    references.clear();
+                    visitor(object);
+                    graph_internal::ForEachReference(object, object->getClassType(), pushReference);
+                    if (!references.isEmpty())
+                    {
+                        pendingCount.fetch_add(static_cast<std::size_t>(references.getSize()), std::memory_order_relaxed);
+                        const std::lock_guard lock(ownQueue.mutex);
+                        for (const auto& reference : references)
+                        {
+                            ownQueue.objects.add(reference);
+                        }
+                    }
+                    pendingCount.fetch_sub(1, std::memory_order_release);
+                }
+            }
+        };
+
+        jutils::jarray<std::thread> threads;
+        threads.reserve(static_cast<jutils::index_type>(threadCount - 1));
+        for (jutils::uint32 threadIndex = 1; threadIndex < threadCount; threadIndex++)
+        {
+            threads.addDefault() = std::thread(worker, threadIndex);
+        }
+        worker(0);
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+        return visitedSet.getSize() - initialSize;
+    }
+}
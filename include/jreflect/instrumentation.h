@@ -0,0 +1,279 @@
+﻿// Copyright © 2024 Leonov Maksim. All Rights Reserved.
+
+#pragma once
+
+#if defined(JREFLECT_ENABLE_INSTRUMENTATION)
+    #define JREFLECT_INSTRUMENT(...) __VA_ARGS__
+#else
+    #define JREFLECT_INSTRUMENT(...)
+#endif
+
+#if defined(JREFLECT_ENABLE_INSTRUMENTATION)
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+
+#include <jutils/jmap.h>
+#include <jutils/jstringID.h>
+
+namespace jreflect
+{
+    class class_type;
+    enum class value_type : jutils::uint8;
+
+    struct instrumentation_counter
+    {
+        jutils::uint64 count = 0;
+        jutils::uint64 nanoseconds = 0;
+
+        void add(const instrumentation_counter& counter)
+        {
+            count += counter.count;
+            nanoseconds += counter.nanoseconds;
+        }
+    };
+    struct instrumentation_data
+    {
+        static constexpr std::size_t ValueTypeCount = 16;
+
+        jutils::jmap<const class_type*, instrumentation_counter> classLookups;
+        instrumentation_counter classLookupMisses;
+        jutils::jmap<const class_type*, instrumentation_counter> derivedChecks;
+        jutils::jmap<const class_type*, instrumentation_counter> fieldLookups;
+        // Indexed like class_type::getFieldTable()
+        jutils::jmap<const class_type*, jutils::jarray<instrumentation_counter>> fieldAccesses;
+        instrumentation_counter valueGets[ValueTypeCount];
+        instrumentation_counter valueSets[ValueTypeCount];
+
+        void merge(const instrumentation_data& data)
+        {
+            const auto mergeMap = [](auto& dst, const auto& src) {
+                for (const auto& [key, counter] : src)
+                {
+                    auto* dstCounter = dst.find(key);
+                    (dstCounter != nullptr ? *dstCounter : dst.put(key, instrumentation_counter())).add(counter);
+                }
+            };
+            mergeMap(classLookups, data.classLookups);
+            classLookupMisses.add(data.classLookupMisses);
+            mergeMap(derivedChecks, data.derivedChecks);
+            mergeMap(fieldLookups, data.fieldLookups);
+            for (const auto& [classType, counters] : data.fieldAccesses)
+            {
+                auto* dstCounters = fieldAccesses.find(classType);
+                if (dstCounters == nullptr)
+                {
+                    dstCounters = &fieldAccesses.put(classType);
+                }
+                if (dstCounters->getSize() < counters.getSize())
+                {
+                    dstCounters->resize(counters.getSize());
+                }
+                for (jutils::index_type index = 0; index < counters.getSize(); index++)
+                {
+                    dstCounters->get(index).add(counters.get(index));
+                }
+            }
+            for (std::size_t index = 0; index < ValueTypeCount; index++)
+            {
+                valueGets[index].add(data.valueGets[index]);
+                valueSets[index].add(data.valueSets[index]);
+            }
+        }
+    };
+
+    // Measures only with JREFLECT_ENABLE_INSTRUMENTATION_TIMING, otherwise reports zero
+    class instrumentation_timer
+    {
+    public:
+        instrumentation_timer() = default;
+
+        [[nodiscard]] jutils::uint64 getNanoseconds() const
+        {
+#if defined(JREFLECT_ENABLE_INSTRUMENTATION_TIMING)
+            return static_cast<jutils::uint64>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_Start).count());
+#else
+            return 0;
+#endif
+        }
+
+    private:
+
+#if defined(JREFLECT_ENABLE_INSTRUMENTATION_TIMING)
+        std::chrono::steady_clock::time_point m_Start = std::chrono::steady_clock::now();
+#endif
+    };
+
+    namespace instrumentation_internal
+    {
+        // Every counter is a relaxed atomic, recording never locks, so instrumentation doesn't distort what it measures
+        struct atomic_counter
+        {
+            std::atomic<jutils::uint64> count = 0;
+            std::atomic<jutils::uint64> nanoseconds = 0;
+
+            void add(const jutils::uint64 duration)
+            {
+                count.fetch_add(1, std::memory_order_relaxed);
+                if (duration > 0)
+                {
+                    nanoseconds.fetch_add(duration, std::memory_order_relaxed);
+                }
+            }
+            [[nodiscard]] instrumentation_counter load() const
+            {
+                return { .count = count.load(std::memory_order_relaxed), .nanoseconds = nanoseconds.load(std::memory_order_relaxed) };
+            }
+            void reset()
+            {
+                count.store(0, std::memory_order_relaxed);
+                nanoseconds.store(0, std::memory_order_relaxed);
+            }
+        };
+        // Created on the first record for the class, lives until the program ends
+        struct class_counters
+        {
+            const class_type* classType = nullptr;
+            atomic_counter classLookups;
+            atomic_counter derivedChecks;
+            atomic_counter fieldLookups;
+            // Indexed like class_type::getFieldTable(), allocated by class_type::initialize()
+            jutils::index_type fieldCount = 0;
+            std::unique_ptr<std::atomic<jutils::uint64>[]> fieldAccesses;
+        };
+
+        // Guards the lists below, only taken when a class gets its counters and by collect/reset
+        inline std::mutex RegistryMutex;
+        inline jutils::jarray<std::unique_ptr<class_counters>> ClassCounters;
+        inline atomic_counter ClassLookupMisses;
+        inline atomic_counter ValueGets[instrumentation_data::ValueTypeCount];
+        inline atomic_counter ValueSets[instrumentation_data::ValueTypeCount];
+
+        // Defined in class_type.h, the counters are stored in class_type
+        class_counters& GetClassCounters(const class_type* classType);
+        void RecordFieldAccess(const class_type* classType, jutils::index_type fieldIndex);
+
+        // Called with RegistryMutex locked
+        inline class_counters* CreateClassCounters(const class_type* classType)
+        {
+            std::unique_ptr<class_counters>& counters = ClassCounters.addDefault();
+            counters = std::make_unique<class_counters>();
+            counters->classType = classType;
+            return counters.get();
+        }
+        // Called once by class_type::initialize()
+        inline std::atomic<jutils::uint64>* CreateFieldAccessCounts(class_counters& counters, const jutils::index_type fieldCount)
+        {
+            const std::lock_guard lock(RegistryMutex);
+            counters.fieldAccesses = std::make_unique<std::atomic<jutils::uint64>[]>(static_cast<std::size_t>(fieldCount));
+            counters.fieldCount = fieldCount;
+            return counters.fieldAccesses.get();
+        }
+
+        inline void RecordClassLookup(const class_type* classType, const instrumentation_timer& timer)
+        {
+            (classType != nullptr ? GetClassCounters(classType).classLookups : ClassLookupMisses).add(timer.getNanoseconds());
+        }
+        inline void RecordDerivedCheck(const class_type* classType)
+        {
+            GetClassCounters(classType).derivedChecks.add(0);
+        }
+        inline void RecordFieldLookup(const class_type* classType, const instrumentation_timer& timer)
+        {
+            GetClassCounters(classType).fieldLookups.add(timer.getNanoseconds());
+        }
+        inline void RecordValueAccess(const value_type type, const bool write)
+        {
+            const auto index = static_cast<std::size_t>(type);
+            if (index < instrumentation_data::ValueTypeCount)
+            {
+                (write ? ValueSets : ValueGets)[index].count.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        inline void RecordValueGet(const value_type type) { RecordValueAccess(type, false); }
+        inline void RecordValueSet(const value_type type) { RecordValueAccess(type, true); }
+
+        // Records the lookup with its duration when the scope ends, findField() has several exits
+        class field_lookup_scope
+        {
+        public:
+            explicit field_lookup_scope(const class_type* classType) : m_ClassType(classType) {}
+            field_lookup_scope(const field_lookup_scope&) = delete;
+            ~field_lookup_scope() { RecordFieldLookup(m_ClassType, m_Timer); }
+
+            field_lookup_scope& operator=(const field_lookup_scope&) = delete;
+
+        private:
+
+            const class_type* m_ClassType = nullptr;
+            instrumentation_timer m_Timer;
+        };
+    }
+
+    // Counters are read one by one while other threads keep recording, so a snapshot taken under load isn't atomic as a whole
+    [[nodiscard]] inline instrumentation_data collect_instrumentation()
+    {
+        using namespace instrumentation_internal;
+        const std::lock_guard lock(RegistryMutex);
+        instrumentation_data result;
+        const auto addCounter = [](jutils::jmap<const class_type*, instrumentation_counter>& counters, const class_type* classType,
+            const atomic_counter& counter) {
+            const instrumentation_counter value = counter.load();
+            if (value.count > 0)
+            {
+                counters.put(classType, value);
+            }
+        };
+        for (const auto& counters : ClassCounters)
+        {
+            addCounter(result.classLookups, counters->classType, counters->classLookups);
+            addCounter(result.derivedChecks, counters->classType, counters->derivedChecks);
+            addCounter(result.fieldLookups, counters->classType, counters->fieldLookups);
+
+            jutils::jarray<instrumentation_counter> fieldAccesses;
+            fieldAccesses.resize(counters->fieldCount);
+            bool accessed = false;
+            for (jutils::index_type index = 0; index < counters->fieldCount; index++)
+            {
+                fieldAccesses.get(index).count = counters->fieldAccesses[index].load(std::memory_order_relaxed);
+                accessed |= fieldAccesses.get(index).count > 0;
+            }
+            if (accessed)
+            {
+                result.fieldAccesses.put(counters->classType, std::move(fieldAccesses));
+            }
+        }
+        result.classLookupMisses = ClassLookupMisses.load();
+        for (std::size_t index = 0; index < instrumentation_data::ValueTypeCount; index++)
+        {
+            result.valueGets[index] = ValueGets[index].load();
+            result.valueSets[index] = ValueSets[index].load();
+        }
+        return result;
+    }
+    inline void reset_instrumentation()
+    {
+        using namespace instrumentation_internal;
+        const std::lock_guard lock(RegistryMutex);
+        for (const auto& counters : ClassCounters)
+        {
+            counters->classLookups.reset();
+            counters->derivedChecks.reset();
+            counters->fieldLookups.reset();
+            for (jutils::index_type index = 0; index < counters->fieldCount; index++)
+            {
+                counters->fieldAccesses[index].store(0, std::memory_order_relaxed);
+            }
+        }
+        ClassLookupMisses.reset();
+        for (std::size_t index = 0; index < instrumentation_data::ValueTypeCount; index++)
+        {
+            ValueGets[index].reset();
+            ValueSets[index].reset();
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,167 @@
+﻿// Copyright © 2024 Leonov Maksim. All Rights Reserved.
+
+#pragma once
+
+#include "class_type.h"
+
+#if defined(JREFLECT_ENABLE_INSTRUMENTATION)
+
+#include <string>
+
+namespace jreflect
+{
+    namespace instrumentation_report_internal
+    {
+        struct report_row
+        {
+            std::string name;
+            instrumentation_counter counter;
+        };
+        struct report_section
+        {
+            const char* name = nullptr;
+            jutils::jarray<report_row> rows;
+        };
+
+        inline std::string GetName(const jutils::jstringID& name)
+        {
+            const jutils::jstring& str = name.toString();
+            return std::string(str.getString(), static_cast<std::size_t>(str.getSize()));
+        }
+        inline std::string GetName(const class_type* classType)
+        {
+            return classType != nullptr ? GetName(classType->getName()) : std::string("NONE");
+        }
+
+        inline void SortRows(report_section& section)
+        {
+            std::sort(section.rows.begin(), section.rows.end(), [](const report_row& row1, const report_row& row2) {
+                return row1.counter.count != row2.counter.count ? row1.counter.count > row2.counter.count : row1.name < row2.name;
+            });
+        }
+
+        template<typename KeyT>
+        report_section MakeSection(const char* name, const jutils::jmap<KeyT, instrumentation_counter>& counters)
+        {
+            report_section section{ .name = name, .rows = {} };
+            for (const auto& [key, counter] : counters)
+            {
+                section.rows.add({ .name = GetName(key), .counter = counter });
+            }
+            SortRows(section);
+            return section;
+        }
+        // Rows are named Class.field
+        inline report_section MakeFieldSection(const char* name,
+            const jutils::jmap<const class_type*, jutils::jarray<instrumentation_counter>>& counters)
+        {
+            report_section section{ .name = name, .rows = {} };
+            for (const auto& [classType, fieldCounters] : counters)
+            {
+                const auto& fields = classType->getFieldTable();
+                for (jutils::index_type index = 0; (index < fieldCounters.getSize()) && (index < fields.getSize()); index++)
+                {
+                    if (fieldCounters.get(index).count > 0)
+                    {
+                        section.rows.add({ .name = GetName(classType) + '.' + GetName(fields.get(index).name), .counter = fieldCounters.get(index) });
+                    }
+                }
+            }
+            SortRows(section);
+            return section;
+        }
+        inline report_section MakeValueSection(const char* name, const instrumentation_counter (&counters)[instrumentation_data::ValueTypeCount])
+        {
+            report_section section{ .name = name, .rows = {} };
+            for (std::size_t index = 0; index < instrumentation_data::ValueTypeCount; index++)
+            {
+                if (counters[index].count > 0)
+                {
+                    section.rows.add({ .name = value_type_to_string(static_cast<value_type>(index)), .counter = counters[index] });
+                }
+            }
+            return section;
+        }
+        inline jutils::jarray<report_section> MakeSections(const instrumentation_data& data)
+        {
+            jutils::jarray<report_section> sections;
+            sections.add(MakeSection("classLookups", data.classLookups));
+            if (data.classLookupMisses.count > 0)
+            {
+                sections.get(0).rows.add({ .name = "NONE", .counter = data.classLookupMisses });
+            }
+            sections.add(MakeSection("derivedChecks", data.derivedChecks));
+            sections.add(MakeSection("fieldLookups", data.fieldLookups));
+            sections.add(MakeFieldSection("fieldAccesses", data.fieldAccesses));
+            sections.add(MakeValueSection("valueGets", data.valueGets));
+            sections.add(MakeValueSection("valueSets", data.valueSets));
+            return sections;
+        }
+
+        inline void AppendJsonString(std::string& output, const std::string& str)
+        {
+            output.push_back('"');
+            for (const char c : str)
+            {
+                if ((c == '"') || (c == '\\'))
+                {
+                    output.push_back('\\');
+                }
+                output.push_back(c);
+            }
+            output.push_back('"');
+        }
+    }
+
+    // One block per section, rows sorted by count. Timings are zero unless JREFLECT_ENABLE_INSTRUMENTATION_TIMING is defined
+    inline void write_instrumentation_text(const instrumentation_data& data, std::string& output)
+    {
+        for (const auto& section : instrumentation_report_internal::MakeSections(data))
+        {
+            output.append(section.name).append(":\n");
+            for (const auto& row : section.rows)
+            {
+                output.append("    ").append(row.name).append(": ").append(std::to_string(row.counter.count));
+                if (row.counter.nanoseconds > 0)
+                {
+                    output.append(" (").append(std::to_string(row.counter.nanoseconds)).append(" ns)");
+                }
+                output.push_back('\n');
+            }
+        }
+    }
+    // {"section":{"name":{"count":N,"nanoseconds":N},...},...}, class lookup misses are stored under "NONE"
+    inline void write_instrumentation_json(const instrumentation_data& data, std::string& output)
+    {
+        output.push_back('{');
+        bool firstSection = true;
+        for (const auto& section : instrumentation_report_internal::MakeSections(data))
+        {
+            if (!firstSection)
+            {
+                output.push_back(',');
+            }
+            firstSection = false;
+
+            output.push_back('"');
+            output.append(section.name).append("\":{");
+            bool firstRow = true;
+            for (const auto& row : section.rows)
+            {
+                if (!firstRow)
+                {
+                    output.push_back(',');
+                }
+                firstRow = false;
+
+                instrumentation_report_internal::AppendJsonString(output, row.name);
+                output.append(":{\"count\":").append(std::to_string(row.counter.count))
+                    .append(",\"nanoseconds\":").append(std::to_string(row.counter.nanoseconds)).push_back('}');
+            }
+            output.push_back('}');
+        }
+        output.push_back('}');
+    }
+}
+
+#endif
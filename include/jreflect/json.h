@@ -0,0 +1,596 @@
+﻿// Copyright © 2024 Leonov Maksim. All Rights Reserved.
+
+#pragma once
+
+#include "class_type.h"
+#include "mapped_file.h"
+
+#include <charconv>
+#include <string>
+
+namespace jreflect
+{
+    class json_writer
+    {
+    public:
+        explicit json_writer(std::string& output) : m_Output(output) {}
+        json_writer(const json_writer&) = delete;
+
+        json_writer& operator=(const json_writer&) = delete;
+
+        void setObjectTable(const jutils::jarray<class_interface*>& objects)
+        {
+            m_ObjectIndices.clear();
+            for (jutils::index_type index = 0; index < objects.getSize(); index++)
+            {
+                if (objects.get(index) != nullptr)
+                {
+                    m_ObjectIndices.put(objects.get(index), index);
+                }
+            }
+        }
+
+        bool writeObject(const class_interface* object)
+        {
+            class_type* classType = object != nullptr ? object->getClassType() : nullptr;
+            if (classType == nullptr)
+            {
+                return false;
+            }
+            classType->initialize();
+
+            m_Output.push_back('{');
+            bool firstField = true;
+            for (const auto& field : classType->getFieldTable())
+            {
+                if (!firstField)
+                {
+                    m_Output.push_back(',');
+                }
+                firstField = false;
+
+                const jutils::jstring& fieldName = field.name.toString();
+                writeString(fieldName.getString(), static_cast<std::size_t>(fieldName.getSize()));
+                m_Output.push_back(':');
+                if (!writeValue(field.fieldValue, field.getValuePtr(object)))
+                {
+                    return false;
+                }
+            }
+            m_Output.push_back('}');
+            return true;
+        }
+        bool writeValue(const value* valueDesc, const void* valuePtr)
+        {
+            if ((valueDesc == nullptr) || (valuePtr == nullptr))
+            {
+                return false;
+            }
+
+            switch (valueDesc->getType())
+            {
+            case value_type::boolean: m_Output.append(*static_cast<const bool*>(valuePtr) ? "true" : "false"); return true;
+            case value_type::int8:    writeNumber(*static_cast<const jutils::int8*>(valuePtr));   return true;
+            case value_type::uint8:   writeNumber(*static_cast<const jutils::uint8*>(valuePtr));  return true;
+            case value_type::int16:   writeNumber(*static_cast<const jutils::int16*>(valuePtr));  return true;
+            case value_type::uint16:  writeNumber(*static_cast<const jutils::uint16*>(valuePtr)); return true;
+            case value_type::int32:   writeNumber(*static_cast<const jutils::int32*>(valuePtr));  return true;
+            case value_type::uint32:  writeNumber(*static_cast<const jutils::uint32*>(valuePtr)); return true;
+            case value_type::int64:   writeNumber(*static_cast<const jutils::int64*>(valuePtr));  return true;
+            case value_type::uint64:  writeNumber(*static_cast<const jutils::uint64*>(valuePtr)); return true;
+            case value_type::string:
+                {
+                    const auto& str = *static_cast<const jutils::jstring*>(valuePtr);
+                    writeString(str.getString(), static_cast<std::size_t>(str.getSize()));
+                }
+                return true;
+
+            case value_type::object:
+                {
+                    const class_interface* object = nullptr;
+                    return valueDesc->cast<value_type::object>()->get(valuePtr, object) && writeObject(object);
+                }
+
+            case value_type::object_ptr:
+                {
+                    class_interface* object = nullptr;
+                    valueDesc->cast<value_type::object_ptr>()->get(const_cast<void*>(valuePtr), object);
+                    const jutils::index_type* objectIndex = object != nullptr ? m_ObjectIndices.find(object) : nullptr;
+                    if (objectIndex != nullptr)
+                    {
+                        writeNumber(*objectIndex);
+                    }
+                    else
+                    {
+                        m_Output.append("null");
+                    }
+                }
+                return true;
+
+            case value_type::array:
+                {
+                    const value_array* arrayValue = valueDesc->cast<value_type::array>();
+                    const jutils::index_type size = arrayValue->getSize(valuePtr);
+                    m_Output.push_back('[');
+                    for (jutils::index_type index = 0; index < size; index++)
+                    {
+                        if (index > 0)
+                        {
+                            m_Output.push_back(',');
+                        }
+                        if (!writeValue(arrayValue->getElementValue(), arrayValue->get(valuePtr, index)))
+                        {
+                            return false;
+                        }
+                    }
+                    m_Output.push_back(']');
+                }
+                return true;
+
+            case value_type::array_bool:
+                {
+                    const value_array_bool* arrayValue = valueDesc->cast<value_type::array_bool>();
+                    const jutils::index_type size = arrayValue->getSize(valuePtr);
+                    m_Output.push_back('[');
+                    for (jutils::index_type index = 0; index < size; index++)
+                    {
+                        bool bit = false;
+                        arrayValue->get(valuePtr, index, bit);
+                        m_Output.append(index > 0 ? (bit ? ",true" : ",false") : (bit ? "true" : "false"));
+                    }
+                    m_Output.push_back(']');
+                }
+                return true;
+
+            default: ;
+            }
+            return false;
+        }
+
+    private:
+
+        std::string& m_Output;
+        jutils::jmap<const class_interface*, jutils::index_type> m_ObjectIndices;
+
+
+        template<typename T>
+        void writeNumber(const T number)
+        {
+            char buffer[24];
+            const auto result = std::to_chars(buffer, buffer + sizeof(buffer), number);
+            m_Output.append(buffer, result.ptr);
+        }
+        void writeString(const char* str, const std::size_t size)
+        {
+            static constexpr char hexDigits[] = "0123456789abcdef";
+
+            m_Output.push_back('"');
+            std::size_t runStart = 0;
+            for (std::size_t index = 0; index < size; index++)
+            {
+                const auto symbol = static_cast<unsigned char>(str[index]);
+                if ((symbol >= 0x20) && (symbol != '"') && (symbol != '\\'))
+                {
+                    continue;
+                }
+
+                m_Output.append(str + runStart, index - runStart);
+                runStart = index + 1;
+                switch (symbol)
+                {
+                case '"':  m_Output.append("\\\""); break;
+                case '\\': m_Output.append("\\\\"); break;
+                case '\n': m_Output.append("\\n"); break;
+                case '\r': m_Output.append("\\r"); break;
+                case '\t': m_Output.append("\\t"); break;
+                case '\b': m_Output.append("\\b"); break;
+                case '\f': m_Output.append("\\f"); break;
+                default:
+                    m_Output.append("\\u00");
+                    m_Output.push_back(hexDigits[symbol >> 4]);
+                    m_Output.push_back(hexDigits[symbol & 0xF]);
+                }
+            }
+            m_Output.append(str + runStart, size - runStart);
+            m_Output.push_back('"');
+        }
+    };
+
+    class json_reader
+    {
+    public:
+        json_reader(const char* data, const std::size_t size)
+            : m_Data(data), m_End(data + size)
+        {}
+        explicit json_reader(const mapped_file& file)
+            : json_reader(reinterpret_cast<const char*>(file.getData()), file.getSize())
+        {}
+        json_reader(const json_reader&) = delete;
+
+        json_reader& operator=(const json_reader&) = delete;
+
+        [[nodiscard]] bool isEnd()
+        {
+            skipWhitespace();
+            return m_Data >= m_End;
+        }
+
+        void setObjectTable(const jutils::jarray<class_interface*>& objects) { m_Objects = objects; }
+
+        bool readObject(class_interface* object)
+        {
+            class_type* classType = object != nullptr ? object->getClassType() : nullptr;
+            if ((classType == nullptr) || !consume('{'))
+            {
+                return false;
+            }
+            classType->initialize();
+
+            if (consume('}'))
+            {
+                return true;
+            }
+            do
+            {
+                if (!readString(m_StringBuffer) || !consume(':'))
+                {
+                    return false;
+                }
+                const class_field_entry* field = classType->findField(jutils::jstring(
+                    m_StringBuffer.data(), static_cast<jutils::index_type>(m_StringBuffer.size())
+                ));
+                if (!(field != nullptr ? readValue(field->fieldValue, field->modifyValuePtr(object)) : skipValue()))
+                {
+                    return false;
+                }
+            }
+            while (consume(','));
+            return consume('}');
+        }
+        bool readValue(const value* valueDesc, void* valuePtr)
+        {
+            if ((valueDesc == nullptr) || (valuePtr == nullptr))
+            {
+                return false;
+            }
+
+            switch (valueDesc->getType())
+            {
+            case value_type::boolean: return readBoolean(*static_cast<bool*>(valuePtr));
+            case value_type::int8:    return readNumber(*static_cast<jutils::int8*>(valuePtr));
+            case value_type::uint8:   return readNumber(*static_cast<jutils::uint8*>(valuePtr));
+            case value_type::int16:   return readNumber(*static_cast<jutils::int16*>(valuePtr));
+            case value_type::uint16:  return readNumber(*static_cast<jutils::uint16*>(valuePtr));
+            case value_type::int32:   return readNumber(*static_cast<jutils::int32*>(valuePtr));
+            case value_type::uint32:  return readNumber(*static_cast<jutils::uint32*>(valuePtr));
+            case value_type::int64:   return readNumber(*static_cast<jutils::int64*>(valuePtr));
+            case value_type::uint64:  return readNumber(*static_cast<jutils::uint64*>(valuePtr));
+            case value_type::string:
+                if (!readString(m_StringBuffer))
+                {
+                    return false;
+                }
+                *static_cast<jutils::jstring*>(valuePtr) = jutils::jstring(
+                    m_StringBuffer.data(), static_cast<jutils::index_type>(m_StringBuffer.size())
+                );
+                return true;
+
+            case value_type::object:
+                {
+                    class_interface* object = nullptr;
+                    return valueDesc->cast<value_type::object>()->get(valuePtr, object) && readObject(object);
+                }
+
+            case value_type::object_ptr:
+                {
+                    class_interface* object = nullptr;
+                    if (!consumeLiteral("null"))
+                    {
+                        jutils::index_type objectIndex = jutils::index_invalid;
+                        if (!readNumber(objectIndex))
+                        {
+                            return false;
+                        }
+                        object = m_Objects.isValidIndex(objectIndex) ? m_Objects.get(objectIndex) : nullptr;
+                    }
+                    valueDesc->cast<value_type::object_ptr>()->set(valuePtr, object);
+                }
+                return true;
+
+            case value_type::array:
+                {
+                    const value_array* arrayValue = valueDesc->cast<value_type::array>();
+                    if (!consume('['))
+                    {
+                        return false;
+                    }
+                    arrayValue->clear(valuePtr);
+                    if (consume(']'))
+                    {
+                        return true;
+                    }
+                    do
+                    {
+                        if (!readValue(arrayValue->getElementValue(), arrayValue->add(valuePtr)))
+                        {
+                            return false;
+                        }
+                    }
+                    while (consume(','));
+                    return consume(']');
+                }
+
+            case value_type::array_bool:
+                {
+                    const value_array_bool* arrayValue = valueDesc->cast<value_type::array_bool>();
+                    if (!consume('['))
+                    {
+                        return false;
+                    }
+                    arrayValue->clear(valuePtr);
+                    if (consume(']'))
+                    {
+                        return true;
+                    }
+                    do
+                    {
+                        bool bit = false;
+                        if (!readBoolean(bit))
+                        {
+                            return false;
+                        }
+                        arrayValue->add(valuePtr, jutils::index_invalid, bit);
+                    }
+                    while (consume(','));
+                    return consume(']');
+                }
+
+            default: ;
+            }
+            return false;
+        }
+
+    private:
+
+        static constexpr jutils::int32 MaxSkipDepth = 256;
+
+        const char* m_Data = nullptr;
+        const char* m_End = nullptr;
+
+        jutils::jarray<class_interface*> m_Objects;
+        std::string m_StringBuffer;
+
+
+        void skipWhitespace()
+        {
+            while ((m_Data < m_End) && ((*m_Data == ' ') || (*m_Data == '\n') || (*m_Data == '\r') || (*m_Data == '\t')))
+            {
+                ++m_Data;
+            }
+        }
+        bool consume(const char symbol)
+        {
+            skipWhitespace();
+            if ((m_Data < m_End) && (*m_Data == symbol))
+            {
+                ++m_Data;
+                return true;
+            }
+            return false;
+        }
+        bool consumeLiteral(const std::string_view literal)
+        {
+            skipWhitespace();
+            if ((static_cast<std::size_t>(m_End - m_Data) >= literal.size()) && (std::string_view(m_Data, literal.size()) == literal))
+            {
+                m_Data += literal.size();
+                return true;
+            }
+            return false;
+        }
+
+        bool readBoolean(bool& outValue)
+        {
+            if (consumeLiteral("true"))
+            {
+                outValue = true;
+                return true;
+            }
+            if (consumeLiteral("false"))
+            {
+                outValue = false;
+                return true;
+            }
+            return false;
+        }
+        template<typename T>
+        bool readNumber(T& outValue)
+        {
+            skipWhitespace();
+            const auto result = std::from_chars(m_Data, m_End, outValue);
+            if (result.ec != std::errc())
+            {
+                return false;
+            }
+            m_Data = result.ptr;
+            return true;
+        }
+
+        static jutils::int32 ParseHexDigit(const char symbol)
+        {
+            if ((symbol >= '0') && (symbol <= '9')) return symbol - '0';
+            if ((symbol >= 'a') && (symbol <= 'f')) return symbol - 'a' + 10;
+            if ((symbol >= 'A') && (symbol <= 'F')) return symbol - 'A' + 10;
+            return -1;
+        }
+        bool readCodeUnit(jutils::uint32& outCodeUnit)
+        {
+            if (m_End - m_Data < 4)
+            {
+                return false;
+            }
+            outCodeUnit = 0;
+            for (jutils::int32 index = 0; index < 4; index++)
+            {
+                const jutils::int32 digit = ParseHexDigit(*m_Data++);
+                if (digit < 0)
+                {
+                    return false;
+                }
+                outCodeUnit = (outCodeUnit << 4) | static_cast<jutils::uint32>(digit);
+            }
+            return true;
+        }
+        static void AppendUTF8(std::string& str, const jutils::uint32 codePoint)
+        {
+            if (codePoint < 0x80)
+            {
+                str.push_back(static_cast<char>(codePoint));
+            }
+            else if (codePoint < 0x800)
+            {
+                str.push_back(static_cast<char>(0xC0 | (codePoint >> 6)));
+                str.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+            }
+            else if (codePoint < 0x10000)
+            {
+                str.push_back(static_cast<char>(0xE0 | (codePoint >> 12)));
+                str.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+                str.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+            }
+            else
+            {
+                str.push_back(static_cast<char>(0xF0 | (codePoint >> 18)));
+                str.push_back(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+                str.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+                str.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+            }
+        }
+        bool readString(std::string& outString)
+        {
+            if (!consume('"'))
+            {
+                return false;
+            }
+            outString.clear();
+            while (m_Data < m_End)
+            {
+                const char* runStart = m_Data;
+                while ((m_Data < m_End) && (*m_Data != '"') && (*m_Data != '\\'))
+                {
+                    ++m_Data;
+                }
+                outString.append(runStart, m_Data);
+                if (m_Data >= m_End)
+                {
+                    break;
+                }
+                if (*m_Data++ == '"')
+                {
+                    return true;
+                }
+                if (m_Data >= m_End)
+                {
+                    break;
+                }
+                switch (*m_Data++)
+                {
+                case '"':  outString.push_back('"'); break;
+                case '\\': outString.push_back('\\'); break;
+                case '/':  outString.push_back('/'); break;
+                case 'b':  outString.push_back('\b'); break;
+                case 'f':  outString.push_back('\f'); break;
+                case 'n':  outString.push_back('\n'); break;
+                case 'r':  outString.push_back('\r'); break;
+                case 't':  outString.push_back('\t'); break;
+                case 'u':
+                    {
+                        jutils::uint32 codePoint = 0;
+                        if (!readCodeUnit(codePoint))
+                        {
+                            return false;
+                        }
+                        if ((codePoint >= 0xD800) && (codePoint < 0xDC00))
+                        {
+                            jutils::uint32 lowSurrogate = 0;
+                            if ((m_End - m_Data < 2) || (m_Data[0] != '\\') || (m_Data[1] != 'u'))
+                            {
+                                return false;
+                            }
+                            m_Data += 2;
+                            if (!readCodeUnit(lowSurrogate) || (lowSurrogate < 0xDC00) || (lowSurrogate >= 0xE000))
+                            {
+                                return false;
+                            }
+                            codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (lowSurrogate - 0xDC00);
+                        }
+                        AppendUTF8(outString, codePoint);
+                    }
+                    break;
+                default:
+                    return false;
+                }
+            }
+            return false;
+        }
+
+        bool skipValue(const jutils::int32 depth = 0)
+        {
+            skipWhitespace();
+            if ((m_Data >= m_End) || (depth > MaxSkipDepth))
+            {
+                return false;
+            }
+            switch (*m_Data)
+            {
+            case '"':
+                return readString(m_StringBuffer);
+            case '{':
+                ++m_Data;
+                if (consume('}'))
+                {
+                    return true;
+                }
+                do
+                {
+                    if (!readString(m_StringBuffer) || !consume(':') || !skipValue(depth + 1))
+                    {
+                        return false;
+                    }
+                }
+                while (consume(','));
+                return consume('}');
+            case '[':
+                ++m_Data;
+                if (consume(']'))
+                {
+                    return true;
+                }
+                do
+                {
+                    if (!skipValue(depth + 1))
+                    {
+                        return false;
+                    }
+                }
+                while (consume(','));
+                return consume(']');
+            case 't':
+                return consumeLiteral("true");
+            case 'f':
+                return consumeLiteral("false");
+            case 'n':
+                return consumeLiteral("null");
+            default: ;
+            }
+
+            const char* numberStart = m_Data;
+            while ((m_Data < m_End) && (((*m_Data >= '0') && (*m_Data <= '9')) ||
+                (*m_Data == '-') || (*m_Data == '+') || (*m_Data == '.') || (*m_Data == 'e') || (*m_Data == 'E')))
+            {
+                ++m_Data;
+            }
+            return m_Data != numberStart;
+        }
+    };
+}
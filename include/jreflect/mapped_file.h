@@ -0,0 +1,159 @@
+﻿// Copyright © 2024 Leonov Maksim. All Rights Reserved.
+
+#pragma once
+
+#include "class_type.h"
+
+#if defined(_WIN32)
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #include <Windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace jreflect
+{
+    class mapped_file
+    {
+    public:
+        mapped_file() = default;
+        mapped_file(const mapped_file&) = delete;
+        mapped_file(mapped_file&& otherFile) noexcept
+            : m_Data(otherFile.m_Data), m_Size(otherFile.m_Size)
+#if defined(_WIN32)
+            , m_FileHandle(otherFile.m_FileHandle), m_MappingHandle(otherFile.m_MappingHandle)
+#endif
+        {
+            otherFile.m_Data = nullptr;
+            otherFile.m_Size = 0;
+#if defined(_WIN32)
+            otherFile.m_FileHandle = INVALID_HANDLE_VALUE;
+            otherFile.m_MappingHandle = nullptr;
+#endif
+        }
+        ~mapped_file() { close(); }
+
+        mapped_file& operator=(const mapped_file&) = delete;
+        mapped_file& operator=(mapped_file&& otherFile) noexcept
+        {
+            if (this != &otherFile)
+            {
+                close();
+                std::swap(m_Data, otherFile.m_Data);
+                std::swap(m_Size, otherFile.m_Size);
+#if defined(_WIN32)
+                std::swap(m_FileHandle, otherFile.m_FileHandle);
+                std::swap(m_MappingHandle, otherFile.m_MappingHandle);
+#endif
+            }
+            return *this;
+        }
+
+        [[nodiscard]] bool isOpen() const { return m_Data != nullptr; }
+        [[nodiscard]] const jutils::uint8* getData() const { return m_Data; }
+        [[nodiscard]] jutils::uint8* getData() { return m_Data; }
+        [[nodiscard]] std::size_t getSize() const { return m_Size; }
+
+        // Copy-on-write mappings can be modified in memory without touching the file
+        bool open(const char* path, const bool copyOnWrite = false)
+        {
+            close();
+            if (path == nullptr)
+            {
+                return false;
+            }
+#if defined(_WIN32)
+            m_FileHandle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+            if (m_FileHandle == INVALID_HANDLE_VALUE)
+            {
+                return false;
+            }
+            LARGE_INTEGER fileSize;
+            if (!GetFileSizeEx(m_FileHandle, &fileSize) || (fileSize.QuadPart <= 0))
+            {
+                close();
+                return false;
+            }
+            m_MappingHandle = CreateFileMappingA(m_FileHandle, nullptr, copyOnWrite ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, nullptr);
+            if (m_MappingHandle == nullptr)
+            {
+                close();
+                return false;
+            }
+            m_Data = static_cast<jutils::uint8*>(MapViewOfFile(m_MappingHandle, copyOnWrite ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0));
+            if (m_Data == nullptr)
+            {
+                close();
+                return false;
+            }
+            m_Size = static_cast<std::size_t>(fileSize.QuadPart);
+#else
+            const int fileDescriptor = ::open(path, O_RDONLY);
+            if (fileDescriptor < 0)
+            {
+                return false;
+            }
+            struct stat fileStat{};
+            if ((fstat(fileDescriptor, &fileStat) != 0) || (fileStat.st_size <= 0))
+            {
+                ::close(fileDescriptor);
+                return false;
+            }
+            const auto fileSize = static_cast<std::size_t>(fileStat.st_size);
+            void* data = mmap(nullptr, fileSize, copyOnWrite ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+            ::close(fileDescriptor);
+            if (data == MAP_FAILED)
+            {
+                return false;
+            }
+            madvise(data, fileSize, MADV_SEQUENTIAL);
+            m_Data = static_cast<jutils::uint8*>(data);
+            m_Size = fileSize;
+#endif
+            return true;
+        }
+        void close()
+        {
+#if defined(_WIN32)
+            if (m_Data != nullptr)
+            {
+                UnmapViewOfFile(m_Data);
+            }
+            if (m_MappingHandle != nullptr)
+            {
+                CloseHandle(m_MappingHandle);
+                m_MappingHandle = nullptr;
+            }
+            if (m_FileHandle != INVALID_HANDLE_VALUE)
+            {
+                CloseHandle(m_FileHandle);
+                m_FileHandle = INVALID_HANDLE_VALUE;
+            }
+#else
+            if (m_Data != nullptr)
+            {
+                munmap(m_Data, m_Size);
+            }
+#endif
+            m_Data = nullptr;
+            m_Size = 0;
+        }
+
+    private:
+
+        jutils::uint8* m_Data = nullptr;
+        std::size_t m_Size = 0;
+#if defined(_WIN32)
+        HANDLE m_FileHandle = INVALID_HANDLE_VALUE;
+        HANDLE m_MappingHandle = nullptr;
+#endif
+    };
+}
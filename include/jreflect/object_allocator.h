@@ -0,0 +1,194 @@
+﻿// Copyright © 2024 Leonov Maksim. All Rights Reserved.
+
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <new>
+
+#include <jutils/jarray.h>
+
+namespace jreflect
+{
+    namespace object_allocator_internal
+    {
+        struct memory_chunk
+        {
+            jutils::uint8* memory = nullptr;
+            std::size_t size = 0;
+        };
+    }
+
+    class object_allocator
+    {
+    public:
+        object_allocator() = default;
+        object_allocator(const object_allocator&) = delete;
+        virtual ~object_allocator() = default;
+
+        object_allocator& operator=(const object_allocator&) = delete;
+
+        [[nodiscard]] virtual void* allocate(std::size_t size, std::size_t alignment) = 0;
+        virtual void deallocate(void* memory, std::size_t size, std::size_t alignment) = 0;
+        // Whether memory could have been returned by allocate(), allocators that can't tell accept everything
+        [[nodiscard]] virtual bool owns([[maybe_unused]] const void* memory) const { return true; }
+    };
+
+    class object_pool final : public object_allocator
+    {
+    public:
+        object_pool() = default;
+        virtual ~object_pool() override { clear(); }
+
+        [[nodiscard]] virtual void* allocate(const std::size_t size, const std::size_t alignment) override
+        {
+            const std::lock_guard lock(m_Mutex);
+            if (m_BlockSize == 0)
+            {
+                m_BlockAlignment = jutils::math::max(alignment, alignof(free_block));
+                m_BlockSize = (jutils::math::max(size, sizeof(free_block)) + m_BlockAlignment - 1) / m_BlockAlignment * m_BlockAlignment;
+            }
+            if ((size > m_BlockSize) || (alignment > m_BlockAlignment))
+            {
+                return nullptr;
+            }
+
+            if (m_FreeBlocks == nullptr)
+            {
+                allocateChunk();
+            }
+            free_block* block = m_FreeBlocks;
+            m_FreeBlocks = block->next;
+            return block;
+        }
+        virtual void deallocate(void* memory, std::size_t, std::size_t) override
+        {
+            if (memory != nullptr)
+            {
+                const std::lock_guard lock(m_Mutex);
+                m_FreeBlocks = ::new (memory) free_block{ m_FreeBlocks };
+            }
+        }
+
+        void clear()
+        {
+            const std::lock_guard lock(m_Mutex);
+            for (const auto& chunk : m_Chunks)
+            {
+                ::operator delete(chunk.memory, std::align_val_t(m_BlockAlignment));
+            }
+            m_Chunks.clear();
+            m_FreeBlocks = nullptr;
+            m_ChunkBlockCount = InitialChunkBlockCount;
+        }
+
+        // Only block starts inside the pool's chunks are accepted
+        [[nodiscard]] virtual bool owns(const void* memory) const override
+        {
+            const std::lock_guard lock(m_Mutex);
+            const auto* bytes = static_cast<const jutils::uint8*>(memory);
+            for (const auto& chunk : m_Chunks)
+            {
+                if ((bytes >= chunk.memory) && (bytes < chunk.memory + chunk.size))
+                {
+                    return static_cast<std::size_t>(bytes - chunk.memory) % m_BlockSize == 0;
+                }
+            }
+            return false;
+        }
+
+    private:
+
+        struct free_block
+        {
+            free_block* next = nullptr;
+        };
+
+
+        static constexpr std::size_t InitialChunkBlockCount = 16;
+        static constexpr std::size_t MaxChunkBlockCount = 4096;
+
+        mutable std::mutex m_Mutex;
+        jutils::jarray<object_allocator_internal::memory_chunk> m_Chunks;
+        free_block* m_FreeBlocks = nullptr;
+        std::size_t m_BlockSize = 0;
+        std::size_t m_BlockAlignment = 0;
+        std::size_t m_ChunkBlockCount = InitialChunkBlockCount;
+
+
+        void allocateChunk()
+        {
+            auto* chunk = static_cast<jutils::uint8*>(::operator new(m_BlockSize * m_ChunkBlockCount, std::align_val_t(m_BlockAlignment)));
+            m_Chunks.add({ .memory = chunk, .size = m_BlockSize * m_ChunkBlockCount });
+            for (std::size_t index = m_ChunkBlockCount; index > 0; index--)
+            {
+                m_FreeBlocks = ::new (chunk + (index - 1) * m_BlockSize) free_block{ m_FreeBlocks };
+            }
+            m_ChunkBlockCount = jutils::math::min(m_ChunkBlockCount * 2, MaxChunkBlockCount);
+        }
+    };
+
+    // Bump allocator, memory is released only by reset() or destruction
+    class object_arena final : public object_allocator
+    {
+    public:
+        explicit object_arena(const std::size_t chunkSize = 64 * 1024) : m_ChunkSize(chunkSize) {}
+        virtual ~object_arena() override { reset(); }
+
+        [[nodiscard]] virtual void* allocate(const std::size_t size, const std::size_t alignment) override
+        {
+            jutils::uint8* chunk = !m_Chunks.isEmpty() ? m_Chunks.get(m_Chunks.getSize() - 1).memory : nullptr;
+            if (chunk != nullptr)
+            {
+                const std::size_t offset = m_ChunkOffset + GetAlignmentPadding(chunk + m_ChunkOffset, alignment);
+                if (offset + size <= m_Chunks.get(m_Chunks.getSize() - 1).size)
+                {
+                    m_ChunkOffset = offset + size;
+                    return chunk + offset;
+                }
+            }
+
+            const std::size_t chunkSize = jutils::math::max(m_ChunkSize, size + alignment);
+            chunk = static_cast<jutils::uint8*>(::operator new(chunkSize));
+            m_Chunks.add({ .memory = chunk, .size = chunkSize });
+            const std::size_t offset = GetAlignmentPadding(chunk, alignment);
+            m_ChunkOffset = offset + size;
+            return chunk + offset;
+        }
+        virtual void deallocate(void*, std::size_t, std::size_t) override {}
+        [[nodiscard]] virtual bool owns(const void* memory) const override
+        {
+            const auto* bytes = static_cast<const jutils::uint8*>(memory);
+            for (const auto& chunk : m_Chunks)
+            {
+                if ((bytes >= chunk.memory) && (bytes < chunk.memory + chunk.size))
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void reset()
+        {
+            for (const auto& chunk : m_Chunks)
+            {
+                ::operator delete(chunk.memory);
+            }
+            m_Chunks.clear();
+            m_ChunkOffset = 0;
+        }
+
+    private:
+
+        jutils::jarray<object_allocator_internal::memory_chunk> m_Chunks;
+        std::size_t m_ChunkSize = 0;
+        std::size_t m_ChunkOffset = 0;
+
+
+        static std::size_t GetAlignmentPadding(const void* memory, const std::size_t alignment)
+        {
+            return (alignment - reinterpret_cast<std::uintptr_t>(memory) % alignment) % alignment;
+        }
+    };
+}
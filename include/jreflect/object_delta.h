@@ -0,0 +1,206 @@
+﻿// Copyright © 2024 Leonov Maksim. All Rights Reserved.
+
+#pragma once
+
+#include "object_operations.h"
+#include "serialization.h"
+
+namespace jreflect
+{
+    namespace delta_internal
+    {
+        inline jutils::index_type WriteMask(binary_writer& writer, const jutils::index_type bitCount)
+        {
+            auto& buffer = writer.getBuffer();
+            const jutils::index_type maskOffset = buffer.getSize();
+            const jutils::index_type maskSize = (bitCount + 63) / 64 * static_cast<jutils::index_type>(sizeof(jutils::uint64));
+            buffer.resize(maskOffset + maskSize);
+            std::memset(buffer.getData() + maskOffset, 0, static_cast<std::size_t>(maskSize));
+            return maskOffset;
+        }
+        inline void SetMaskBit(binary_writer& writer, const jutils::index_type maskOffset, const jutils::index_type bitIndex)
+        {
+            jutils::uint8* maskWord = writer.getBuffer().getData() + maskOffset + bitIndex / 64 * static_cast<jutils::index_type>(sizeof(jutils::uint64));
+            jutils::uint64 word;
+            std::memcpy(&word, maskWord, sizeof(word));
+            word |= static_cast<jutils::uint64>(1) << (bitIndex % 64);
+            std::memcpy(maskWord, &word, sizeof(word));
+        }
+        // The mask bounds the bit count by the remaining data, so corrupted sizes are rejected before anything is allocated
+        inline bool ReadMask(binary_reader& reader, const jutils::index_type bitCount, jutils::jarray<jutils::uint64>& outMask)
+        {
+            if (bitCount < 0)
+            {
+                return false;
+            }
+            const std::size_t wordCount = (static_cast<std::size_t>(bitCount) + 63) / 64;
+            if (wordCount > reader.getRemainingSize() / sizeof(jutils::uint64))
+            {
+                return false;
+            }
+            outMask.resize(static_cast<jutils::index_type>(wordCount));
+            return reader.readBytes(outMask.getData(), wordCount * sizeof(jutils::uint64));
+        }
+        [[nodiscard]] inline bool IsMaskBitSet(const jutils::jarray<jutils::uint64>& mask, const jutils::index_type bitIndex)
+        {
+            return ((mask.get(bitIndex / 64) >> (bitIndex % 64)) & 1) != 0;
+        }
+    }
+
+    inline bool write_object_delta(binary_writer& writer, const class_interface& base, const class_interface& current);
+    inline bool read_object_delta(binary_reader& reader, class_interface& object);
+
+    inline bool write_value_delta(binary_writer& writer, const value* valueDesc, const void* baseValue, const void* currentValue)
+    {
+        if ((valueDesc == nullptr) || (baseValue == nullptr) || (currentValue == nullptr))
+        {
+            return false;
+        }
+
+        switch (valueDesc->getType())
+        {
+        case value_type::object:
+            {
+                const value_object* objectValue = valueDesc->cast<value_type::object>();
+                const class_interface* baseObject = nullptr;
+                const class_interface* currentObject = nullptr;
+                return objectValue->get(baseValue, baseObject) && objectValue->get(currentValue, currentObject)
+                    && write_object_delta(writer, *baseObject, *currentObject);
+            }
+
+        case value_type::array:
+            {
+                const value_array* arrayValue = valueDesc->cast<value_type::array>();
+                const value* elementValue = arrayValue->getElementValue();
+                const jutils::index_type baseSize = arrayValue->getSize(baseValue);
+                const jutils::index_type currentSize = arrayValue->getSize(currentValue);
+                writer.write(currentSize);
+                const jutils::index_type maskOffset = delta_internal::WriteMask(writer, currentSize);
+                for (jutils::index_type index = 0; index < currentSize; index++)
+                {
+                    const void* currentElement = arrayValue->get(currentValue, index);
+                    if ((index < baseSize) && equals_value(elementValue, arrayValue->get(baseValue, index), currentElement))
+                    {
+                        continue;
+                    }
+                    delta_internal::SetMaskBit(writer, maskOffset, index);
+                    if (!writer.writeValue(elementValue, currentElement))
+                    {
+                        return false;
+                    }
+                }
+            }
+            return true;
+
+        default: ;
+        }
+        return writer.writeValue(valueDesc, currentValue);
+    }
+    inline bool read_value_delta(binary_reader& reader, const value* valueDesc, void* valuePtr)
+    {
+        if ((valueDesc == nullptr) || (valuePtr == nullptr))
+        {
+            return false;
+        }
+
+        switch (valueDesc->getType())
+        {
+        case value_type::object:
+            {
+                class_interface* object = nullptr;
+                return valueDesc->cast<value_type::object>()->get(valuePtr, object) && read_object_delta(reader, *object);
+            }
+
+        case value_type::array:
+            {
+                const value_array* arrayValue = valueDesc->cast<value_type::array>();
+                jutils::index_type size = 0;
+                jutils::jarray<jutils::uint64> mask;
+                if (!reader.read(size) || (size < 0) || !delta_internal::ReadMask(reader, size, mask))
+                {
+                    return false;
+                }
+                for (jutils::index_type currentSize = arrayValue->getSize(valuePtr); currentSize > size; currentSize--)
+                {
+                    arrayValue->remove(valuePtr, currentSize - 1);
+                }
+                for (jutils::index_type currentSize = arrayValue->getSize(valuePtr); currentSize < size; currentSize++)
+                {
+                    arrayValue->add(valuePtr);
+                }
+                for (jutils::index_type index = 0; index < size; index++)
+                {
+                    if (delta_internal::IsMaskBitSet(mask, index) && !reader.readValue(arrayValue->getElementValue(), arrayValue->get(valuePtr, index)))
+                    {
+                        return false;
+                    }
+                }
+            }
+            return true;
+
+        default: ;
+        }
+        return reader.readValue(valueDesc, valuePtr);
+    }
+
+    // Delta layout: field count, bitmask of changed fields (by field table index), packed values of the changed fields
+    inline bool write_object_delta(binary_writer& writer, const class_interface& base, const class_interface& current)
+    {
+        class_type* classType = current.getClassType();
+        if ((classType == nullptr) || (base.getClassType() != classType))
+        {
+            return false;
+        }
+        classType->initialize();
+
+        const auto& fields = classType->getFieldTable();
+        const jutils::index_type fieldCount = fields.getSize();
+        writer.write(fieldCount);
+        const jutils::index_type maskOffset = delta_internal::WriteMask(writer, fieldCount);
+        for (jutils::index_type fieldIndex = 0; fieldIndex < fieldCount; fieldIndex++)
+        {
+            const class_field_entry& field = fields.get(fieldIndex);
+            const void* baseValue = field.getValuePtr(&base);
+            const void* currentValue = field.getValuePtr(&current);
+            if (equals_value(field.fieldValue, baseValue, currentValue))
+            {
+                continue;
+            }
+            delta_internal::SetMaskBit(writer, maskOffset, fieldIndex);
+            if (!write_value_delta(writer, field.fieldValue, baseValue, currentValue))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+    inline bool read_object_delta(binary_reader& reader, class_interface& object)
+    {
+        class_type* classType = object.getClassType();
+        if (classType == nullptr)
+        {
+            return false;
+        }
+        classType->initialize();
+
+        const auto& fields = classType->getFieldTable();
+        jutils::index_type fieldCount = 0;
+        jutils::jarray<jutils::uint64> mask;
+        if (!reader.read(fieldCount) || (fieldCount != fields.getSize()) || !delta_internal::ReadMask(reader, fieldCount, mask))
+        {
+            return false;
+        }
+        for (jutils::index_type fieldIndex = 0; fieldIndex < fieldCount; fieldIndex++)
+        {
+            if (delta_internal::IsMaskBitSet(mask, fieldIndex))
+            {
+                const class_field_entry& field = fields.get(fieldIndex);
+                if (!read_value_delta(reader, field.fieldValue, field.modifyValuePtr(&object)))
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+}
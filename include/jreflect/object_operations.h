@@ -0,0 +1,340 @@
+﻿// Copyright © 2024 Leonov Maksim. All Rights Reserved.
+
+#pragma once
+
+#include "class_type.h"
+
+#include <cstring>
+
+namespace jreflect
+{
+    [[nodiscard]] constexpr jutils::uint64 hash_mix(jutils::uint64 hash)
+    {
+        hash ^= hash >> 32;
+        hash *= 0xD6E8FEB86659FD93ull;
+        hash ^= hash >> 32;
+        hash *= 0xD6E8FEB86659FD93ull;
+        hash ^= hash >> 32;
+        return hash;
+    }
+    [[nodiscard]] inline jutils::uint64 hash_bytes(const void* data, const std::size_t size, jutils::uint64 seed)
+    {
+        constexpr jutils::uint64 prime = 0x9E3779B97F4A7C15ull;
+
+        const auto* bytes = static_cast<const jutils::uint8*>(data);
+        jutils::uint64 hash = seed ^ (size * prime);
+        std::size_t offset = 0;
+        for (; offset + sizeof(jutils::uint64) <= size; offset += sizeof(jutils::uint64))
+        {
+            jutils::uint64 word;
+            std::memcpy(&word, bytes + offset, sizeof(word));
+            hash = (hash ^ hash_mix(word)) * prime;
+        }
+        if (offset < size)
+        {
+            jutils::uint64 word = 0;
+            std::memcpy(&word, bytes + offset, size - offset);
+            hash = (hash ^ hash_mix(word)) * prime;
+        }
+        return hash_mix(hash);
+    }
+
+    inline bool copy_object(class_interface& dst, const class_interface& src);
+    [[nodiscard]] inline bool equals_object(const class_interface& object1, const class_interface& object2);
+    [[nodiscard]] inline jutils::uint64 hash_object(const class_interface& object, jutils::uint64 seed = 0);
+
+    inline bool copy_value(const value* valueDesc, void* dst, const void* src)
+    {
+        if ((valueDesc == nullptr) || (dst == nullptr) || (src == nullptr))
+        {
+            return false;
+        }
+        if (dst == src)
+        {
+            return true;
+        }
+
+        const value_type type = valueDesc->getType();
+        if (is_trivial_value_type(type))
+        {
+            std::memcpy(dst, src, value_type_size(type));
+            return true;
+        }
+        switch (type)
+        {
+        case value_type::string:
+            *static_cast<jutils::jstring*>(dst) = *static_cast<const jutils::jstring*>(src);
+            return true;
+
+        case value_type::object:
+            {
+                const value_object* objectValue = valueDesc->cast<value_type::object>();
+                class_interface* dstObject = nullptr;
+                const class_interface* srcObject = nullptr;
+                return objectValue->get(dst, dstObject) && objectValue->get(src, srcObject) && copy_object(*dstObject, *srcObject);
+            }
+
+        case value_type::object_ptr:
+            {
+                const value_object_ptr* objectPtrValue = valueDesc->cast<value_type::object_ptr>();
+                class_interface* srcObject = nullptr;
+                return objectPtrValue->get(const_cast<void*>(src), srcObject) && objectPtrValue->set(dst, srcObject);
+            }
+
+        case value_type::array:
+            {
+                const value_array* arrayValue = valueDesc->cast<value_type::array>();
+                const jutils::index_type size = arrayValue->getSize(src);
+                const std::size_t elementSize = value_type_size(arrayValue->getElementValue()->getType());
+                if (elementSize > 0)
+                {
+                    arrayValue->resize(dst, size);
+                    void* dstData = arrayValue->getData(dst);
+                    const void* srcData = arrayValue->getData(src);
+                    if ((dstData != nullptr) && (srcData != nullptr))
+                    {
+                        std::memcpy(dstData, srcData, static_cast<std::size_t>(size) * elementSize);
+                        return true;
+                    }
+                }
+                arrayValue->clear(dst);
+                for (jutils::index_type index = 0; index < size; index++)
+                {
+                    if (!copy_value(arrayValue->getElementValue(), arrayValue->add(dst), arrayValue->get(src, index)))
+                    {
+                        return false;
+                    }
+                }
+            }
+            return true;
+
+        case value_type::array_bool:
+            *static_cast<std::vector<bool>*>(dst) = *static_cast<const std::vector<bool>*>(src);
+            return true;
+
+        default: ;
+        }
+        return false;
+    }
+    [[nodiscard]] inline bool equals_value(const value* valueDesc, const void* value1, const void* value2)
+    {
+        if ((valueDesc == nullptr) || (value1 == nullptr) || (value2 == nullptr))
+        {
+            return false;
+        }
+        if (value1 == value2)
+        {
+            return true;
+        }
+
+        const value_type type = valueDesc->getType();
+        if (is_trivial_value_type(type))
+        {
+            return std::memcmp(value1, value2, value_type_size(type)) == 0;
+        }
+        switch (type)
+        {
+        case value_type::string:
+            return *static_cast<const jutils::jstring*>(value1) == *static_cast<const jutils::jstring*>(value2);
+
+        case value_type::object:
+            {
+                const value_object* objectValue = valueDesc->cast<value_type::object>();
+                const class_interface* object1 = nullptr;
+                const class_interface* object2 = nullptr;
+                return objectValue->get(value1, object1) && objectValue->get(value2, object2) && equals_object(*object1, *object2);
+            }
+
+        case value_type::object_ptr:
+            {
+                const value_object_ptr* objectPtrValue = valueDesc->cast<value_type::object_ptr>();
+                class_interface* object1 = nullptr;
+                class_interface* object2 = nullptr;
+                return objectPtrValue->get(const_cast<void*>(value1), object1) && objectPtrValue->get(const_cast<void*>(value2), object2)
+                    && (object1 == object2);
+            }
+
+        case value_type::array:
+            {
+                const value_array* arrayValue = valueDesc->cast<value_type::array>();
+                const jutils::index_type size = arrayValue->getSize(value1);
+                if (size != arrayValue->getSize(value2))
+                {
+                    return false;
+                }
+                // Primitive elements are compared in one pass over the storage, like copy_value()
+                const std::size_t elementSize = value_type_size(arrayValue->getElementValue()->getType());
+                const void* data1 = elementSize > 0 ? arrayValue->getData(value1) : nullptr;
+                const void* data2 = elementSize > 0 ? arrayValue->getData(value2) : nullptr;
+                if ((data1 != nullptr) && (data2 != nullptr))
+                {
+                    return std::memcmp(data1, data2, static_cast<std::size_t>(size) * elementSize) == 0;
+                }
+                for (jutils::index_type index = 0; index < size; index++)
+                {
+                    if (!equals_value(arrayValue->getElementValue(), arrayValue->get(value1, index), arrayValue->get(value2, index)))
+                    {
+                        return false;
+                    }
+                }
+            }
+            return true;
+
+        case value_type::array_bool:
+            return *static_cast<const std::vector<bool>*>(value1) == *static_cast<const std::vector<bool>*>(value2);
+
+        default: ;
+        }
+        return false;
+    }
+    [[nodiscard]] inline jutils::uint64 hash_value(const value* valueDesc, const void* valuePtr, const jutils::uint64 seed = 0)
+    {
+        if ((valueDesc == nullptr) || (valuePtr == nullptr))
+        {
+            return seed;
+        }
+
+        const value_type type = valueDesc->getType();
+        if (is_trivial_value_type(type))
+        {
+            return hash_bytes(valuePtr, value_type_size(type), seed);
+        }
+        switch (type)
+        {
+        case value_type::string:
+            {
+                const auto& str = *static_cast<const jutils::jstring*>(valuePtr);
+                return hash_bytes(str.getString(), static_cast<std::size_t>(str.getSize()), seed);
+            }
+
+        case value_type::object:
+            {
+                const class_interface* object = nullptr;
+                return valueDesc->cast<value_type::object>()->get(valuePtr, object) ? hash_object(*object, seed) : seed;
+            }
+
+        case value_type::object_ptr:
+            {
+                class_interface* object = nullptr;
+                valueDesc->cast<value_type::object_ptr>()->get(const_cast<void*>(valuePtr), object);
+                return hash_bytes(&object, sizeof(object), seed);
+            }
+
+        case value_type::array:
+            {
+                const value_array* arrayValue = valueDesc->cast<value_type::array>();
+                const jutils::index_type size = arrayValue->getSize(valuePtr);
+                jutils::uint64 hash = hash_bytes(&size, sizeof(size), seed);
+                const std::size_t elementSize = value_type_size(arrayValue->getElementValue()->getType());
+                const void* data = elementSize > 0 ? arrayValue->getData(valuePtr) : nullptr;
+                if (data != nullptr)
+                {
+                    return hash_bytes(data, static_cast<std::size_t>(size) * elementSize, hash);
+                }
+                for (jutils::index_type index = 0; index < size; index++)
+                {
+                    hash = hash_value(arrayValue->getElementValue(), arrayValue->get(valuePtr, index), hash);
+                }
+                return hash;
+            }
+
+        case value_type::array_bool:
+            {
+                const auto& bits = *static_cast<const std::vector<bool>*>(valuePtr);
+                return hash_mix(seed ^ static_cast<jutils::uint64>(std::hash<std::vector<bool>>()(bits)) ^ bits.size());
+            }
+
+        default: ;
+        }
+        return seed;
+    }
+
+    inline bool copy_object(class_interface& dst, const class_interface& src)
+    {
+        class_type* classType = src.getClassType();
+        if ((classType == nullptr) || (dst.getClassType() != classType))
+        {
+            return false;
+        }
+        if (&dst == &src)
+        {
+            return true;
+        }
+        classType->initialize();
+
+        auto* dstData = reinterpret_cast<jutils::uint8*>(&dst);
+        const auto* srcData = reinterpret_cast<const jutils::uint8*>(&src);
+        const auto& fields = classType->getFieldTable();
+        for (const auto& block : classType->getFieldBlocks())
+        {
+            if (block.trivial)
+            {
+                std::memcpy(dstData + block.offset, srcData + block.offset, block.size);
+            }
+            else if (!copy_value(fields.get(block.fieldIndex).fieldValue, dstData + block.offset, srcData + block.offset))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+    [[nodiscard]] inline class_interface* clone_object(const class_interface& src, object_allocator* allocator = nullptr)
+    {
+        class_type* classType = src.getClassType();
+        class_interface* object = classType != nullptr ? classType->createObject(allocator) : nullptr;
+        if ((object != nullptr) && !copy_object(*object, src))
+        {
+            class_type::DestroyObject(object, allocator);
+            return nullptr;
+        }
+        return object;
+    }
+    [[nodiscard]] inline bool equals_object(const class_interface& object1, const class_interface& object2)
+    {
+        class_type* classType = object1.getClassType();
+        if ((classType == nullptr) || (object2.getClassType() != classType))
+        {
+            return false;
+        }
+        if (&object1 == &object2)
+        {
+            return true;
+        }
+        classType->initialize();
+
+        const auto* data1 = reinterpret_cast<const jutils::uint8*>(&object1);
+        const auto* data2 = reinterpret_cast<const jutils::uint8*>(&object2);
+        const auto& fields = classType->getFieldTable();
+        for (const auto& block : classType->getFieldBlocks())
+        {
+            const bool equals = block.trivial
+                ? std::memcmp(data1 + block.offset, data2 + block.offset, block.size) == 0
+                : equals_value(fields.get(block.fieldIndex).fieldValue, data1 + block.offset, data2 + block.offset);
+            if (!equals)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+    [[nodiscard]] inline jutils::uint64 hash_object(const class_interface& object, const jutils::uint64 seed)
+    {
+        class_type* classType = object.getClassType();
+        if (classType == nullptr)
+        {
+            return seed;
+        }
+        classType->initialize();
+
+        const auto* data = reinterpret_cast<const jutils::uint8*>(&object);
+        const auto& fields = classType->getFieldTable();
+        jutils::uint64 hash = seed;
+        for (const auto& block : classType->getFieldBlocks())
+        {
+            hash = block.trivial
+                ? hash_bytes(data + block.offset, block.size, hash)
+                : hash_value(fields.get(block.fieldIndex).fieldValue, data + block.offset, hash);
+        }
+        return hash;
+    }
+}
@@ -0,0 +1,214 @@
+﻿// Copyright © 2024 Leonov Maksim. All Rights Reserved.
+
+#pragma once
+
+#include "serialization.h"
+
+#include <atomic>
+#include <memory>
+#include <thread>
+
+namespace jreflect
+{
+    namespace parallel_serialization_internal
+    {
+        struct chunk_info
+        {
+            jutils::index_type firstObject = 0;
+            jutils::index_type objectCount = 0;
+            jutils::uint64 size = 0;
+        };
+
+        constexpr jutils::index_type ChunksPerThread = 4;
+
+        [[nodiscard]] inline jutils::uint32 GetThreadCount(const jutils::uint32 threadCount)
+        {
+            return threadCount != 0 ? threadCount : jutils::math::max(std::thread::hardware_concurrency(), 1u);
+        }
+        // Threads beyond the chunk count would only start and exit
+        [[nodiscard]] inline jutils::uint32 GetWorkerCount(const jutils::uint32 threadCount, const jutils::index_type chunkCount)
+        {
+            return jutils::math::min(threadCount, static_cast<jutils::uint32>(jutils::math::max(chunkCount, 1)));
+        }
+
+        // The object index map is only read for pointer fields, building it is a serial step that costs more than writing
+        [[nodiscard]] inline bool HasPointerFields(const std::span<class_interface* const> objects)
+        {
+            const class_type* lastClassType = nullptr;
+            for (const class_interface* object : objects)
+            {
+                class_type* classType = object != nullptr ? object->getClassType() : nullptr;
+                if ((classType == nullptr) || (classType == lastClassType))
+                {
+                    continue;
+                }
+                lastClassType = classType;
+                classType->initialize();
+                if (!classType->getPointerEdges().isEmpty())
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        template<typename F>
+        void RunWorkers(const jutils::uint32 threadCount, const F& worker)
+        {
+            jutils::jarray<std::thread> threads;
+            threads.reserve(static_cast<jutils::index_type>(threadCount - 1));
+            for (jutils::uint32 threadIndex = 1; threadIndex < threadCount; threadIndex++)
+            {
+                threads.addDefault() = std::thread(worker);
+            }
+            worker();
+            for (auto& thread : threads)
+            {
+                thread.join();
+            }
+        }
+    }
+
+    // Layout: object count, chunk count, chunk table (first object, object count, byte size), chunk data.
+    // Chunks are written independently, object_ptr fields are stored as indices into the objects span
+    inline bool write_objects_parallel(const std::span<class_interface* const> objects, jutils::jarray<jutils::uint8>& outBuffer,
+        jutils::uint32 threadCount = 0)
+    {
+        using namespace parallel_serialization_internal;
+
+        threadCount = GetThreadCount(threadCount);
+        const auto objectCount = static_cast<jutils::index_type>(objects.size());
+        const jutils::index_type chunkCount = jutils::math::min(
+            jutils::math::max(static_cast<jutils::index_type>(threadCount) * ChunksPerThread, 1), jutils::math::max(objectCount, 1)
+        );
+        const jutils::index_type chunkObjectCount = (objectCount + chunkCount - 1) / chunkCount;
+
+        jutils::jmap<const class_interface*, jutils::index_type> objectIndices;
+        if (HasPointerFields(objects))
+        {
+            for (jutils::index_type index = 0; index < objectCount; index++)
+            {
+                if (objects[static_cast<std::size_t>(index)] != nullptr)
+                {
+                    objectIndices.put(objects[static_cast<std::size_t>(index)], index);
+                }
+            }
+        }
+
+        auto chunkBuffers = std::make_unique<jutils::jarray<jutils::uint8>[]>(static_cast<std::size_t>(chunkCount));
+        std::atomic<jutils::index_type> nextChunk = 0;
+        std::atomic<bool> failed = false;
+        RunWorkers(GetWorkerCount(threadCount, chunkCount), [&]()
+        {
+            for (jutils::index_type chunkIndex = nextChunk.fetch_add(1); (chunkIndex < chunkCount) && !failed.load(std::memory_order_relaxed);
+                chunkIndex = nextChunk.fetch_add(1))
+            {
+                binary_writer writer(chunkBuffers[static_cast<std::size_t>(chunkIndex)]);
+                writer.setObjectIndexTable(objectIndices);
+                const jutils::index_type lastObject = jutils::math::min((chunkIndex + 1) * chunkObjectCount, objectCount);
+                for (jutils::index_type index = chunkIndex * chunkObjectCount; index < lastObject; index++)
+                {
+                    if (!writer.writeObject(objects[static_cast<std::size_t>(index)]))
+                    {
+                        failed.store(true, std::memory_order_relaxed);
+                        break;
+                    }
+                }
+            }
+        });
+        if (failed.load())
+        {
+            return false;
+        }
+
+        binary_writer writer(outBuffer);
+        writer.write(objectCount);
+        writer.write(chunkCount);
+        for (jutils::index_type chunkIndex = 0; chunkIndex < chunkCount; chunkIndex++)
+        {
+            const jutils::index_type firstObject = jutils::math::min(chunkIndex * chunkObjectCount, objectCount);
+            writer.write(chunk_info{
+                .firstObject = firstObject,
+                .objectCount = jutils::math::min(firstObject + chunkObjectCount, objectCount) - firstObject,
+                .size = static_cast<jutils::uint64>(chunkBuffers[static_cast<std::size_t>(chunkIndex)].getSize())
+            });
+        }
+        for (jutils::index_type chunkIndex = 0; chunkIndex < chunkCount; chunkIndex++)
+        {
+            const auto& chunkBuffer = chunkBuffers[static_cast<std::size_t>(chunkIndex)];
+            writer.writeBytes(chunkBuffer.getData(), static_cast<std::size_t>(chunkBuffer.getSize()));
+        }
+        return true;
+    }
+
+    // Objects must already exist and match the saved order, they are restored in parallel chunk by chunk
+    inline bool read_objects_parallel(const void* data, const std::size_t size, const std::span<class_interface* const> objects,
+        jutils::uint32 threadCount = 0)
+    {
+        using namespace parallel_serialization_internal;
+
+        binary_reader reader(data, size);
+        jutils::index_type objectCount = 0;
+        jutils::index_type chunkCount = 0;
+        if (!reader.read(objectCount) || (objectCount != static_cast<jutils::index_type>(objects.size())) || !reader.read(chunkCount)
+            || (chunkCount < 0) || (static_cast<std::size_t>(chunkCount) > reader.getRemainingSize() / sizeof(chunk_info)))
+        {
+            return false;
+        }
+
+        jutils::jarray<chunk_info> chunks;
+        jutils::jarray<std::size_t> chunkOffsets;
+        chunks.resize(chunkCount);
+        chunkOffsets.resize(chunkCount);
+        if (!reader.readBytes(chunks.getData(), static_cast<std::size_t>(chunkCount) * sizeof(chunk_info)))
+        {
+            return false;
+        }
+        // Chunks must cover the objects in order without overlapping, otherwise two threads could restore the same object
+        std::size_t chunkOffset = reader.getPosition();
+        jutils::index_type nextObject = 0;
+        for (jutils::index_type chunkIndex = 0; chunkIndex < chunkCount; chunkIndex++)
+        {
+            const chunk_info& chunk = chunks.get(chunkIndex);
+            if ((chunk.firstObject != nextObject) || (chunk.objectCount < 0) || (chunk.objectCount > objectCount - nextObject)
+                || (chunk.size > size - chunkOffset))
+            {
+                return false;
+            }
+            chunkOffsets.get(chunkIndex) = chunkOffset;
+            chunkOffset += static_cast<std::size_t>(chunk.size);
+            nextObject += chunk.objectCount;
+        }
+        if (nextObject != objectCount)
+        {
+            return false;
+        }
+
+        const auto* bytes = static_cast<const jutils::uint8*>(data);
+        std::atomic<jutils::index_type> nextChunk = 0;
+        std::atomic<bool> failed = false;
+        RunWorkers(GetWorkerCount(GetThreadCount(threadCount), chunkCount), [&]()
+        {
+            for (jutils::index_type chunkIndex = nextChunk.fetch_add(1); (chunkIndex < chunkCount) && !failed.load(std::memory_order_relaxed);
+                chunkIndex = nextChunk.fetch_add(1))
+            {
+                const chunk_info& chunk = chunks.get(chunkIndex);
+                binary_reader chunkReader(bytes + chunkOffsets.get(chunkIndex), static_cast<std::size_t>(chunk.size));
+                chunkReader.setObjectTable(objects);
+                for (jutils::index_type index = chunk.firstObject; index < chunk.firstObject + chunk.objectCount; index++)
+                {
+                    if (!chunkReader.readObject(objects[static_cast<std::size_t>(index)]))
+                    {
+                        failed.store(true, std::memory_order_relaxed);
+                        break;
+                    }
+                }
+                if (!chunkReader.isEnd())
+                {
+                    failed.store(true, std::memory_order_relaxed);
+                }
+            }
+        });
+        return !failed.load();
+    }
+}
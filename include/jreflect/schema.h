@@ -0,0 +1,432 @@
+﻿// Copyright © 2024 Leonov Maksim. All Rights Reserved.
+
+#pragma once
+
+#include "serialization.h"
+
+namespace jreflect
+{
+    struct class_schema_field
+    {
+        jutils::jstringID name = jutils::jstringID_NONE;
+        std::size_t offset = 0;
+        value_type type = value_type::none;
+        value_type elementType = value_type::none;
+        // Schema hash of the nested class for object fields and arrays of objects
+        jutils::uint64 objectHash = 0;
+    };
+    struct class_schema
+    {
+        jutils::jstringID name = jutils::jstringID_NONE;
+        jutils::uint64 hash = 0;
+        jutils::jarray<class_schema_field> fields;
+    };
+
+    namespace schema_internal
+    {
+        // Name size, offset, type, element type and nested schema hash of a field with an empty name
+        constexpr std::size_t MinFieldRecordSize = sizeof(jutils::uint32) + sizeof(jutils::uint64) + sizeof(value_type) * 2 + sizeof(jutils::uint64);
+
+        [[nodiscard]] inline jutils::uint64 GetObjectSchemaHash(const value* fieldValue)
+        {
+            if (fieldValue->getType() == value_type::array)
+            {
+                fieldValue = fieldValue->cast<value_type::array>()->getElementValue();
+            }
+            if (fieldValue->getType() != value_type::object)
+            {
+                return 0;
+            }
+            class_type* objectType = fieldValue->cast<value_type::object>()->getObjectType();
+            objectType->initialize();
+            return objectType->getSchemaHash();
+        }
+    }
+
+    [[nodiscard]] inline class_schema make_class_schema(class_type* classType)
+    {
+        class_schema schema;
+        if (classType == nullptr)
+        {
+            return schema;
+        }
+        classType->initialize();
+
+        schema.name = classType->getName();
+        schema.hash = classType->getSchemaHash();
+        const auto& fields = classType->getFieldTable();
+        schema.fields.reserve(fields.getSize());
+        for (const auto& field : fields)
+        {
+            const value_type elementType = field.type == value_type::array
+                ? field.fieldValue->cast<value_type::array>()->getElementValue()->getType() : value_type::none;
+            schema.fields.add({
+                .name = field.name, .offset = field.offset, .type = field.type, .elementType = elementType,
+                .objectHash = schema_internal::GetObjectSchemaHash(field.fieldValue)
+            });
+        }
+        return schema;
+    }
+
+    inline void write_class_schema(binary_writer& writer, const class_schema& schema)
+    {
+        const auto writeName = [&writer](const jutils::jstringID& name) {
+            const jutils::jstring& str = name.toString();
+            writer.write(static_cast<jutils::uint32>(str.getSize()));
+            writer.writeBytes(str.getString(), static_cast<std::size_t>(str.getSize()));
+        };
+        writeName(schema.name);
+        writer.write(schema.hash);
+        writer.write(schema.fields.getSize());
+        for (const auto& field : schema.fields)
+        {
+            writeName(field.name);
+            writer.write(static_cast<jutils::uint64>(field.offset));
+            writer.write(field.type);
+            writer.write(field.elementType);
+            writer.write(field.objectHash);
+        }
+    }
+    inline bool read_class_schema(binary_reader& reader, class_schema& outSchema)
+    {
+        const auto readName = [&reader](jutils::jstringID& outName) {
+            jutils::uint32 size = 0;
+            if (!reader.read(size) || (size > reader.getRemainingSize()))
+            {
+                return false;
+            }
+            jutils::jarray<char> chars;
+            chars.resize(static_cast<jutils::index_type>(size));
+            if (!reader.readBytes(chars.getData(), size))
+            {
+                return false;
+            }
+            outName = jutils::jstring(chars.getData(), static_cast<jutils::index_type>(size));
+            return true;
+        };
+
+        jutils::index_type fieldCount = 0;
+        if (!readName(outSchema.name) || !reader.read(outSchema.hash) || !reader.read(fieldCount) || (fieldCount < 0)
+            || (static_cast<std::size_t>(fieldCount) > reader.getRemainingSize() / schema_internal::MinFieldRecordSize))
+        {
+            return false;
+        }
+        outSchema.fields.clear();
+        outSchema.fields.reserve(fieldCount);
+        for (jutils::index_type index = 0; index < fieldCount; index++)
+        {
+            class_schema_field& field = outSchema.fields.addDefault();
+            jutils::uint64 offset = 0;
+            if (!readName(field.name) || !reader.read(offset) || !reader.read(field.type) || !reader.read(field.elementType)
+                || !reader.read(field.objectHash))
+            {
+                return false;
+            }
+            field.offset = static_cast<std::size_t>(offset);
+        }
+        return true;
+    }
+
+    // Reads objects written by binary_writer with an older class layout. The plan is built once per class and then
+    // applied to every object without any field lookups
+    class schema_remap
+    {
+    public:
+        schema_remap() = default;
+
+        [[nodiscard]] bool isValid() const { return m_ClassType != nullptr; }
+        [[nodiscard]] bool isIdentity() const { return m_Identity; }
+
+        bool build(const class_schema& schema, class_type* classType)
+        {
+            m_ClassType = nullptr;
+            m_Identity = false;
+            m_Operations.clear();
+            if (classType == nullptr)
+            {
+                return false;
+            }
+            classType->initialize();
+
+            if ((schema.name == classType->getName()) && (schema.hash == classType->getSchemaHash()) && HasSameObjectSchemas(schema, classType))
+            {
+                m_ClassType = classType;
+                m_Identity = true;
+                return true;
+            }
+
+            // Same order as class_type::getFieldBlocks(), which is how binary_writer emitted the old fields
+            jutils::jarray<jutils::index_type> fieldsByOffset;
+            fieldsByOffset.reserve(schema.fields.getSize());
+            for (jutils::index_type index = 0; index < schema.fields.getSize(); index++)
+            {
+                fieldsByOffset.add(index);
+            }
+            std::stable_sort(fieldsByOffset.begin(), fieldsByOffset.end(), [&schema](const jutils::index_type index1, const jutils::index_type index2) {
+                return schema.fields.get(index1).offset < schema.fields.get(index2).offset;
+            });
+
+            for (const auto& fieldIndex : fieldsByOffset)
+            {
+                const class_schema_field& oldField = schema.fields.get(fieldIndex);
+                const class_field_entry* field = classType->findField(oldField.name);
+                if (!addOperation(oldField, field))
+                {
+                    m_Operations.clear();
+                    return false;
+                }
+            }
+            m_ClassType = classType;
+            return true;
+        }
+
+        bool readObject(binary_reader& reader, class_interface* object) const
+        {
+            if ((object == nullptr) || (object->getClassType() != m_ClassType) || (m_ClassType == nullptr))
+            {
+                return false;
+            }
+            if (m_Identity)
+            {
+                return reader.readObject(object);
+            }
+
+            auto* objectData = reinterpret_cast<jutils::uint8*>(object);
+            for (const auto& operation : m_Operations)
+            {
+                bool result = true;
+                switch (operation.type)
+                {
+                case operation_type::copy:
+                    result = reader.readBytes(objectData + operation.offset, operation.size);
+                    break;
+                case operation_type::convert:
+                    {
+                        jutils::uint8 data[sizeof(jutils::uint64)];
+                        result = reader.readBytes(data, operation.size)
+                            && ConvertNumber(operation.sourceType, data, operation.targetType, objectData + operation.offset);
+                    }
+                    break;
+                case operation_type::value:
+                    result = reader.readValue(operation.fieldValue, objectData + operation.offset);
+                    break;
+                case operation_type::skip:
+                    result = reader.skipBytes(operation.size);
+                    break;
+                case operation_type::skip_value:
+                    result = SkipValue(reader, operation.sourceType, operation.elementType);
+                    break;
+                }
+                if (!result)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+    private:
+
+        enum class operation_type : jutils::uint8 { copy, convert, value, skip, skip_value };
+        struct operation
+        {
+            operation_type type = operation_type::skip;
+            value_type sourceType = value_type::none;
+            value_type targetType = value_type::none;
+            value_type elementType = value_type::none;
+            std::size_t offset = 0;
+            std::size_t size = 0;
+            const value* fieldValue = nullptr;
+        };
+
+        class_type* m_ClassType = nullptr;
+        bool m_Identity = false;
+        jutils::jarray<operation> m_Operations;
+
+
+        bool addOperation(const class_schema_field& oldField, const class_field_entry* field)
+        {
+            const std::size_t oldSize = value_type_size(oldField.type);
+            if (oldSize > 0)
+            {
+                if ((field == nullptr) || !is_trivial_value_type(field->type))
+                {
+                    addSkip(oldSize);
+                }
+                else if (field->type == oldField.type)
+                {
+                    addCopy(field->offset, oldSize);
+                }
+                else
+                {
+                    m_Operations.add({
+                        .type = operation_type::convert, .sourceType = oldField.type, .targetType = field->type, .offset = field->offset, .size = oldSize
+                    });
+                }
+                return true;
+            }
+
+            const bool sameType = (field != nullptr) && (field->type == oldField.type) && ((oldField.type != value_type::array)
+                || (field->fieldValue->cast<value_type::array>()->getElementValue()->getType() == oldField.elementType));
+            if (sameType)
+            {
+                // Nested objects are read with the current layout, so their schemas must match exactly
+                if (oldField.objectHash != schema_internal::GetObjectSchemaHash(field->fieldValue))
+                {
+                    return false;
+                }
+                m_Operations.add({ .type = operation_type::value, .sourceType = oldField.type, .offset = field->offset, .fieldValue = field->fieldValue });
+                return true;
+            }
+            if (oldField.type == value_type::object_ptr)
+            {
+                addSkip(sizeof(jutils::index_type));
+                return true;
+            }
+            if (!CanSkipValue(oldField.type, oldField.elementType))
+            {
+                return false;
+            }
+            m_Operations.add({ .type = operation_type::skip_value, .sourceType = oldField.type, .elementType = oldField.elementType });
+            return true;
+        }
+        void addCopy(const std::size_t offset, const std::size_t size)
+        {
+            if (!m_Operations.isEmpty())
+            {
+                operation& lastOperation = m_Operations.get(m_Operations.getSize() - 1);
+                if ((lastOperation.type == operation_type::copy) && (lastOperation.offset + lastOperation.size == offset))
+                {
+                    lastOperation.size += size;
+                    return;
+                }
+            }
+            m_Operations.add({ .type = operation_type::copy, .offset = offset, .size = size });
+        }
+        void addSkip(const std::size_t size)
+        {
+            if (!m_Operations.isEmpty())
+            {
+                operation& lastOperation = m_Operations.get(m_Operations.getSize() - 1);
+                if (lastOperation.type == operation_type::skip)
+                {
+                    lastOperation.size += size;
+                    return;
+                }
+            }
+            m_Operations.add({ .type = operation_type::skip, .size = size });
+        }
+
+        // The class hash covers nested object fields but only the class name of array elements
+        [[nodiscard]] static bool HasSameObjectSchemas(const class_schema& schema, const class_type* classType)
+        {
+            const auto& fields = classType->getFieldTable();
+            if (schema.fields.getSize() != fields.getSize())
+            {
+                return false;
+            }
+            for (jutils::index_type index = 0; index < fields.getSize(); index++)
+            {
+                if (schema.fields.get(index).objectHash != schema_internal::GetObjectSchemaHash(fields.get(index).fieldValue))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+        [[nodiscard]] static bool IsSignedType(const value_type type)
+        {
+            return (type == value_type::int8) || (type == value_type::int16) || (type == value_type::int32) || (type == value_type::int64);
+        }
+        template<typename T>
+        static void StoreNumber(void* dst, const T value)
+        {
+            std::memcpy(dst, &value, sizeof(T));
+        }
+        static bool ConvertNumber(const value_type sourceType, const void* src, const value_type targetType, void* dst)
+        {
+            jutils::uint64 bits = 0;
+            std::memcpy(&bits, src, value_type_size(sourceType));
+            if (IsSignedType(sourceType))
+            {
+                const std::size_t shift = 64 - value_type_size(sourceType) * 8;
+                bits = static_cast<jutils::uint64>(static_cast<jutils::int64>(bits << shift) >> shift);
+            }
+            switch (targetType)
+            {
+            case value_type::boolean: StoreNumber(dst, bits != 0); return true;
+            case value_type::int8:    StoreNumber(dst, static_cast<jutils::int8>(bits)); return true;
+            case value_type::uint8:   StoreNumber(dst, static_cast<jutils::uint8>(bits)); return true;
+            case value_type::int16:   StoreNumber(dst, static_cast<jutils::int16>(bits)); return true;
+            case value_type::uint16:  StoreNumber(dst, static_cast<jutils::uint16>(bits)); return true;
+            case value_type::int32:   StoreNumber(dst, static_cast<jutils::int32>(bits)); return true;
+            case value_type::uint32:  StoreNumber(dst, static_cast<jutils::uint32>(bits)); return true;
+            case value_type::int64:   StoreNumber(dst, static_cast<jutils::int64>(bits)); return true;
+            case value_type::uint64:  StoreNumber(dst, bits); return true;
+            default: ;
+            }
+            return false;
+        }
+
+        [[nodiscard]] static bool CanSkipValue(const value_type type, const value_type elementType)
+        {
+            switch (type)
+            {
+            case value_type::string:
+            case value_type::object_ptr:
+            case value_type::array_bool:
+                return true;
+            case value_type::array:
+                return is_trivial_value_type(elementType) || (elementType == value_type::string) || (elementType == value_type::object_ptr)
+                    || (elementType == value_type::array_bool);
+            default: ;
+            }
+            return is_trivial_value_type(type);
+        }
+        static bool SkipValue(binary_reader& reader, const value_type type, const value_type elementType)
+        {
+            if (is_trivial_value_type(type))
+            {
+                return reader.skipBytes(value_type_size(type));
+            }
+            switch (type)
+            {
+            case value_type::string:
+                {
+                    jutils::uint32 size = 0;
+                    return reader.read(size) && reader.skipBytes(size);
+                }
+            case value_type::object_ptr:
+                return reader.skipBytes(sizeof(jutils::index_type));
+            case value_type::array_bool:
+                {
+                    jutils::index_type size = 0;
+                    return reader.read(size) && (size >= 0) && reader.skipBytes(static_cast<std::size_t>((size + 7) / 8));
+                }
+            case value_type::array:
+                {
+                    jutils::index_type size = 0;
+                    if (!reader.read(size) || (size < 0))
+                    {
+                        return false;
+                    }
+                    if (is_trivial_value_type(elementType) || (elementType == value_type::object_ptr))
+                    {
+                        const std::size_t elementSize = elementType == value_type::object_ptr ? sizeof(jutils::index_type) : value_type_size(elementType);
+                        return reader.skipBytes(static_cast<std::size_t>(size) * elementSize);
+                    }
+                    for (jutils::index_type index = 0; index < size; index++)
+                    {
+                        if (!SkipValue(reader, elementType, value_type::none))
+                        {
+                            return false;
+                        }
+                    }
+                }
+                return true;
+            default: ;
+            }
+            return false;
+        }
+    };
+}
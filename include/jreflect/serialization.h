@@ -0,0 +1,368 @@
+﻿// Copyright © 2024 Leonov Maksim. All Rights Reserved.
+
+#pragma once
+
+#include "class_type.h"
+
+#include <cstring>
+#include <span>
+
+namespace jreflect
+{
+    class binary_writer
+    {
+    public:
+        explicit binary_writer(jutils::jarray<jutils::uint8>& buffer) : m_Buffer(buffer) {}
+        binary_writer(const binary_writer&) = delete;
+
+        binary_writer& operator=(const binary_writer&) = delete;
+
+        [[nodiscard]] jutils::jarray<jutils::uint8>& getBuffer() const { return m_Buffer; }
+
+        void setObjectTable(const jutils::jarray<class_interface*>& objects)
+        {
+            m_ObjectIndexTable = &m_ObjectIndices;
+            m_ObjectIndices.clear();
+            for (jutils::index_type index = 0; index < objects.getSize(); index++)
+            {
+                if (objects.get(index) != nullptr)
+                {
+                    m_ObjectIndices.put(objects.get(index), index);
+                }
+            }
+        }
+        // Shares an index map between writers, the map must outlive writing
+        void setObjectIndexTable(const jutils::jmap<const class_interface*, jutils::index_type>& objectIndices)
+        {
+            m_ObjectIndices.clear();
+            m_ObjectIndexTable = &objectIndices;
+        }
+
+        void writeBytes(const void* data, const std::size_t size)
+        {
+            if (size == 0)
+            {
+                return;
+            }
+            const jutils::index_type offset = m_Buffer.getSize();
+            m_Buffer.resize(offset + static_cast<jutils::index_type>(size));
+            std::memcpy(m_Buffer.getData() + offset, data, size);
+        }
+        template<typename T>
+        void write(const T& value)
+        {
+            static_assert(std::is_trivially_copyable_v<T>);
+            writeBytes(&value, sizeof(T));
+        }
+
+        bool writeObject(const class_interface* object)
+        {
+            class_type* classType = object != nullptr ? object->getClassType() : nullptr;
+            if (classType == nullptr)
+            {
+                return false;
+            }
+            classType->initialize();
+
+            const auto* objectData = reinterpret_cast<const jutils::uint8*>(object);
+            const auto& fields = classType->getFieldTable();
+            for (const auto& block : classType->getFieldBlocks())
+            {
+                if (block.trivial)
+                {
+                    writeBytes(objectData + block.offset, block.size);
+                }
+                else
+                {
+                    const class_field_entry& field = fields.get(block.fieldIndex);
+                    if (!writeValue(field.fieldValue, objectData + block.offset))
+                    {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }
+        bool writeValue(const value* valueDesc, const void* valuePtr)
+        {
+            if ((valueDesc == nullptr) || (valuePtr == nullptr))
+            {
+                return false;
+            }
+
+            const value_type type = valueDesc->getType();
+            if (is_trivial_value_type(type))
+            {
+                writeBytes(valuePtr, value_type_size(type));
+                return true;
+            }
+            switch (type)
+            {
+            case value_type::string:
+                {
+                    const auto& str = *static_cast<const jutils::jstring*>(valuePtr);
+                    write(static_cast<jutils::uint32>(str.getSize()));
+                    writeBytes(str.getString(), static_cast<std::size_t>(str.getSize()));
+                }
+                return true;
+
+            case value_type::object:
+                {
+                    const class_interface* object = nullptr;
+                    return valueDesc->cast<value_type::object>()->get(valuePtr, object) && writeObject(object);
+                }
+
+            case value_type::object_ptr:
+                {
+                    class_interface* object = nullptr;
+                    valueDesc->cast<value_type::object_ptr>()->get(const_cast<void*>(valuePtr), object);
+                    const jutils::index_type* objectIndex = object != nullptr ? m_ObjectIndexTable->find(object) : nullptr;
+                    write(objectIndex != nullptr ? *objectIndex : jutils::index_invalid);
+                }
+                return true;
+
+            case value_type::array:
+                {
+                    const value_array* arrayValue = valueDesc->cast<value_type::array>();
+                    const jutils::index_type size = arrayValue->getSize(valuePtr);
+                    write(size);
+                    const std::size_t elementSize = value_type_size(arrayValue->getElementValue()->getType());
+                    const void* data = elementSize > 0 ? arrayValue->getData(valuePtr) : nullptr;
+                    if (data != nullptr)
+                    {
+                        writeBytes(data, static_cast<std::size_t>(size) * elementSize);
+                        return true;
+                    }
+                    for (jutils::index_type index = 0; index < size; index++)
+                    {
+                        if (!writeValue(arrayValue->getElementValue(), arrayValue->get(valuePtr, index)))
+                        {
+                            return false;
+                        }
+                    }
+                }
+                return true;
+
+            case value_type::array_bool:
+                {
+                    const value_array_bool* arrayValue = valueDesc->cast<value_type::array_bool>();
+                    const jutils::index_type size = arrayValue->getSize(valuePtr);
+                    write(size);
+                    jutils::jarray<jutils::uint64> words;
+                    words.resize(value_array_bool::GetWordCount(size));
+                    arrayValue->getWords(valuePtr, words.getData());
+                    writeBytes(words.getData(), static_cast<std::size_t>((size + 7) / 8));
+                }
+                return true;
+
+            default: ;
+            }
+            return false;
+        }
+
+    private:
+
+        jutils::jarray<jutils::uint8>& m_Buffer;
+        jutils::jmap<const class_interface*, jutils::index_type> m_ObjectIndices;
+        const jutils::jmap<const class_interface*, jutils::index_type>* m_ObjectIndexTable = &m_ObjectIndices;
+    };
+
+    class binary_reader
+    {
+    public:
+        binary_reader(const void* data, const std::size_t size)
+            : m_Data(static_cast<const jutils::uint8*>(data)), m_Size(size)
+        {}
+        binary_reader(const binary_reader&) = delete;
+
+        binary_reader& operator=(const binary_reader&) = delete;
+
+        [[nodiscard]] std::size_t getPosition() const { return m_Position; }
+        [[nodiscard]] std::size_t getRemainingSize() const { return m_Size - m_Position; }
+        [[nodiscard]] bool isEnd() const { return m_Position >= m_Size; }
+
+        void setObjectTable(const jutils::jarray<class_interface*>& objects)
+        {
+            m_Objects = objects;
+            m_ObjectTable = std::span<class_interface* const>(m_Objects.getData(), static_cast<std::size_t>(m_Objects.getSize()));
+        }
+        // Doesn't copy the table, it must outlive reading
+        void setObjectTable(const std::span<class_interface* const> objects)
+        {
+            m_Objects.clear();
+            m_ObjectTable = objects;
+        }
+
+        bool readBytes(void* data, const std::size_t size)
+        {
+            if (size > getRemainingSize())
+            {
+                return false;
+            }
+            if (size > 0)
+            {
+                std::memcpy(data, m_Data + m_Position, size);
+                m_Position += size;
+            }
+            return true;
+        }
+        bool skipBytes(const std::size_t size)
+        {
+            if (size > getRemainingSize())
+            {
+                return false;
+            }
+            m_Position += size;
+            return true;
+        }
+        template<typename T>
+        bool read(T& outValue)
+        {
+            static_assert(std::is_trivially_copyable_v<T>);
+            return readBytes(&outValue, sizeof(T));
+        }
+
+        bool readObject(class_interface* object)
+        {
+            class_type* classType = object != nullptr ? object->getClassType() : nullptr;
+            if (classType == nullptr)
+            {
+                return false;
+            }
+            classType->initialize();
+
+            auto* objectData = reinterpret_cast<jutils::uint8*>(object);
+            const auto& fields = classType->getFieldTable();
+            for (const auto& block : classType->getFieldBlocks())
+            {
+                if (block.trivial)
+                {
+                    if (!readBytes(objectData + block.offset, block.size))
+                    {
+                        return false;
+                    }
+                }
+                else
+                {
+                    const class_field_entry& field = fields.get(block.fieldIndex);
+                    if (!readValue(field.fieldValue, objectData + block.offset))
+                    {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }
+        bool readValue(const value* valueDesc, void* valuePtr)
+        {
+            if ((valueDesc == nullptr) || (valuePtr == nullptr))
+            {
+                return false;
+            }
+
+            const value_type type = valueDesc->getType();
+            if (is_trivial_value_type(type))
+            {
+                return readBytes(valuePtr, value_type_size(type));
+            }
+            switch (type)
+            {
+            case value_type::string:
+                {
+                    jutils::uint32 size = 0;
+                    if (!read(size) || (size > getRemainingSize()))
+                    {
+                        return false;
+                    }
+                    *static_cast<jutils::jstring*>(valuePtr) = jutils::jstring(
+                        reinterpret_cast<const char*>(m_Data + m_Position), static_cast<jutils::index_type>(size)
+                    );
+                    m_Position += size;
+                }
+                return true;
+
+            case value_type::object:
+                {
+                    class_interface* object = nullptr;
+                    return valueDesc->cast<value_type::object>()->get(valuePtr, object) && readObject(object);
+                }
+
+            case value_type::object_ptr:
+                {
+                    jutils::index_type objectIndex = jutils::index_invalid;
+                    if (!read(objectIndex))
+                    {
+                        return false;
+                    }
+                    class_interface* object = (objectIndex >= 0) && (static_cast<std::size_t>(objectIndex) < m_ObjectTable.size())
+                        ? m_ObjectTable[static_cast<std::size_t>(objectIndex)] : nullptr;
+                    return valueDesc->cast<value_type::object_ptr>()->set(valuePtr, object);
+                }
+
+            case value_type::array:
+                {
+                    const value_array* arrayValue = valueDesc->cast<value_type::array>();
+                    jutils::index_type size = 0;
+                    if (!read(size) || (size < 0))
+                    {
+                        return false;
+                    }
+                    const std::size_t elementSize = value_type_size(arrayValue->getElementValue()->getType());
+                    if (elementSize > 0)
+                    {
+                        if (static_cast<std::size_t>(size) > getRemainingSize() / elementSize)
+                        {
+                            return false;
+                        }
+                        arrayValue->resize(valuePtr, size);
+                        void* data = arrayValue->getData(valuePtr);
+                        if (data != nullptr)
+                        {
+                            return readBytes(data, static_cast<std::size_t>(size) * elementSize);
+                        }
+                    }
+                    arrayValue->clear(valuePtr);
+                    for (jutils::index_type index = 0; index < size; index++)
+                    {
+                        if (!readValue(arrayValue->getElementValue(), arrayValue->add(valuePtr)))
+                        {
+                            return false;
+                        }
+                    }
+                }
+                return true;
+
+            case value_type::array_bool:
+                {
+                    const value_array_bool* arrayValue = valueDesc->cast<value_type::array_bool>();
+                    jutils::index_type size = 0;
+                    if (!read(size) || (size < 0) || (static_cast<std::size_t>((size + 7) / 8) > getRemainingSize()))
+                    {
+                        return false;
+                    }
+                    jutils::jarray<jutils::uint64> words;
+                    words.resize(value_array_bool::GetWordCount(size));
+                    if (!words.isEmpty())
+                    {
+                        words.get(words.getSize() - 1) = 0;
+                    }
+                    readBytes(words.getData(), static_cast<std::size_t>((size + 7) / 8));
+                    arrayValue->setWords(valuePtr, words.getData(), size);
+                }
+                return true;
+
+            default: ;
+            }
+            return false;
+        }
+
+    private:
+
+        const jutils::uint8* m_Data = nullptr;
+        std::size_t m_Size = 0;
+        std::size_t m_Position = 0;
+
+        jutils::jarray<class_interface*> m_Objects;
+        std::span<class_interface* const> m_ObjectTable;
+    };
+}
@@ -0,0 +1,367 @@
+﻿// Copyright © 2024 Leonov Maksim. All Rights Reserved.
+
+#pragma once
+
+#include "database.h"
+#include "mapped_file.h"
+#include "serialization.h"
+
+namespace jreflect
+{
+    namespace snapshot_internal
+    {
+        constexpr jutils::uint32 Magic = 0x4E53524A;
+        constexpr jutils::uint32 Version = 1;
+
+        // Smallest possible records, counts read from a file are bounded by them before anything is allocated
+        constexpr std::size_t MinClassRecordSize = sizeof(jutils::uint32) + 3 * sizeof(jutils::uint64) + sizeof(jutils::index_type);
+        constexpr std::size_t MinFieldRecordSize = sizeof(jutils::uint32) + sizeof(jutils::uint64) + sizeof(jutils::uint8);
+        constexpr std::size_t ObjectRecordSize = sizeof(jutils::index_type) + sizeof(jutils::uint64);
+
+        struct pointer_slot
+        {
+            std::size_t offset = 0;
+            const value_object_ptr* pointerValue = nullptr;
+        };
+        struct object_layout
+        {
+            jutils::jarray<class_field_block> blocks;
+            jutils::jarray<pointer_slot> pointers;
+        };
+
+        // Only primitives, raw object pointers and nested objects built from them can be stored as memory images
+        inline bool BuildLayout(class_type* classType, const std::size_t baseOffset, object_layout& layout)
+        {
+            classType->initialize();
+            const auto& fields = classType->getFieldTable();
+            for (const auto& block : classType->getFieldBlocks())
+            {
+                if (block.trivial)
+                {
+                    layout.blocks.add({ .offset = baseOffset + block.offset, .size = block.size, .fieldIndex = block.fieldIndex,
+                        .fieldCount = block.fieldCount, .trivial = true });
+                    continue;
+                }
+
+                const class_field_entry& field = fields.get(block.fieldIndex);
+                switch (field.type)
+                {
+                case value_type::object:
+                    if (!BuildLayout(field.fieldValue->cast<value_type::object>()->getObjectType(), baseOffset + field.offset, layout))
+                    {
+                        return false;
+                    }
+                    break;
+
+                case value_type::object_ptr:
+                    {
+                        const value_object_ptr* pointerValue = field.fieldValue->cast<value_type::object_ptr>();
+                        if (!pointerValue->isRawPointer())
+                        {
+                            return false;
+                        }
+                        layout.pointers.add({ .offset = baseOffset + field.offset, .pointerValue = pointerValue });
+                    }
+                    break;
+
+                default:
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        inline void WriteName(binary_writer& writer, const jutils::jstringID& name)
+        {
+            const jutils::jstring& str = name.toString();
+            writer.write(static_cast<jutils::uint32>(str.getSize()));
+            writer.writeBytes(str.getString(), static_cast<std::size_t>(str.getSize()));
+        }
+        inline bool ReadName(binary_reader& reader, const jutils::uint8* data, jutils::jstringID& outName)
+        {
+            jutils::uint32 size = 0;
+            if (!reader.read(size) || (size > reader.getRemainingSize()))
+            {
+                return false;
+            }
+            outName = jutils::jstring(reinterpret_cast<const char*>(data + reader.getPosition()), static_cast<jutils::index_type>(size));
+            return reader.skipBytes(size);
+        }
+    }
+
+    // Layout: header, class schemas (name, schema hash, size, alignment, fields), object table, aligned object images.
+    // Pointer fields inside the images hold (object index + 1), zero for null
+    inline bool write_snapshot(const jutils::jarray<class_interface*>& objects, jutils::jarray<jutils::uint8>& outBuffer)
+    {
+        jutils::jarray<class_type*> classTypes;
+        jutils::jarray<snapshot_internal::object_layout> layouts;
+        jutils::jarray<jutils::index_type> objectClasses;
+        jutils::jmap<const class_interface*, jutils::index_type> objectIndices;
+        objectClasses.reserve(objects.getSize());
+        for (jutils::index_type index = 0; index < objects.getSize(); index++)
+        {
+            const class_interface* object = objects.get(index);
+            class_type* classType = object != nullptr ? object->getClassType() : nullptr;
+            if ((classType == nullptr) || (classType->getObjectSize() == 0))
+            {
+                return false;
+            }
+
+            auto classIter = std::find(classTypes.begin(), classTypes.end(), classType);
+            if (classIter == classTypes.end())
+            {
+                if (!snapshot_internal::BuildLayout(classType, 0, layouts.addDefault()))
+                {
+                    return false;
+                }
+                classTypes.add(classType);
+                classIter = classTypes.end() - 1;
+            }
+            objectClasses.add(static_cast<jutils::index_type>(classIter - classTypes.begin()));
+            objectIndices.put(object, index);
+        }
+
+        binary_writer writer(outBuffer);
+        writer.write(snapshot_internal::Magic);
+        writer.write(snapshot_internal::Version);
+        writer.write(classTypes.getSize());
+        writer.write(objects.getSize());
+        for (const auto& classType : classTypes)
+        {
+            snapshot_internal::WriteName(writer, classType->getName());
+            writer.write(classType->getSchemaHash());
+            writer.write(static_cast<jutils::uint64>(classType->getObjectSize()));
+            writer.write(static_cast<jutils::uint64>(classType->getObjectAlignment()));
+            const auto& fields = classType->getFieldTable();
+            writer.write(fields.getSize());
+            for (const auto& field : fields)
+            {
+                snapshot_internal::WriteName(writer, field.name);
+                writer.write(static_cast<jutils::uint64>(field.offset));
+                writer.write(static_cast<jutils::uint8>(field.type));
+            }
+        }
+
+        auto imageOffset = static_cast<jutils::uint64>(outBuffer.getSize())
+            + static_cast<jutils::uint64>(objects.getSize()) * snapshot_internal::ObjectRecordSize;
+        jutils::jarray<jutils::uint64> imageOffsets;
+        imageOffsets.reserve(objects.getSize());
+        for (jutils::index_type index = 0; index < objects.getSize(); index++)
+        {
+            const class_type* classType = classTypes.get(objectClasses.get(index));
+            const jutils::uint64 alignment = classType->getObjectAlignment();
+            imageOffset = (imageOffset + alignment - 1) / alignment * alignment;
+            imageOffsets.add(imageOffset);
+            writer.write(objectClasses.get(index));
+            writer.write(imageOffset);
+            imageOffset += classType->getObjectSize();
+        }
+
+        for (jutils::index_type index = 0; index < objects.getSize(); index++)
+        {
+            const class_interface* object = objects.get(index);
+            const std::size_t objectSize = object->getClassType()->getObjectSize();
+            outBuffer.resize(static_cast<jutils::index_type>(imageOffsets.get(index)));
+            writer.writeBytes(object, objectSize);
+
+            jutils::uint8* image = outBuffer.getData() + imageOffsets.get(index);
+            for (const auto& pointer : layouts.get(objectClasses.get(index)).pointers)
+            {
+                class_interface* target = nullptr;
+                pointer.pointerValue->get(const_cast<jutils::uint8*>(reinterpret_cast<const jutils::uint8*>(object)) + pointer.offset, target);
+                const jutils::index_type* targetIndex = target != nullptr ? objectIndices.find(target) : nullptr;
+                const std::uintptr_t slot = targetIndex != nullptr ? static_cast<std::uintptr_t>(*targetIndex) + 1 : 0;
+                std::memcpy(image + pointer.offset, &slot, sizeof(slot));
+            }
+        }
+        return true;
+    }
+
+    // Objects of a loaded snapshot live inside the copy-on-write file mapping and are valid until close()
+    class snapshot
+    {
+    public:
+        snapshot() = default;
+        snapshot(const snapshot&) = delete;
+        ~snapshot() { close(); }
+
+        snapshot& operator=(const snapshot&) = delete;
+
+        [[nodiscard]] bool isOpen() const { return m_File.isOpen(); }
+        [[nodiscard]] const jutils::jarray<class_interface*>& getObjects() const { return m_Objects; }
+
+        bool open(const char* path)
+        {
+            close();
+            if (!m_File.open(path, true) || !load())
+            {
+                close();
+                return false;
+            }
+            return true;
+        }
+        void close()
+        {
+            for (const auto& object : m_Objects)
+            {
+                object->getClassType()->destructObjectInternal(object);
+            }
+            m_Objects.clear();
+            m_File.close();
+        }
+
+    private:
+
+        struct class_entry
+        {
+            class_type* classType = nullptr;
+            snapshot_internal::object_layout layout;
+        };
+
+        mapped_file m_File;
+        jutils::jarray<class_interface*> m_Objects;
+
+
+        bool load()
+        {
+            jutils::uint8* data = m_File.getData();
+            binary_reader reader(data, m_File.getSize());
+            jutils::uint32 magic = 0;
+            jutils::uint32 version = 0;
+            jutils::index_type classCount = 0;
+            jutils::index_type objectCount = 0;
+            if (!reader.read(magic) || (magic != snapshot_internal::Magic) || !reader.read(version) || (version != snapshot_internal::Version)
+                || !reader.read(classCount) || (classCount < 0) || !reader.read(objectCount) || (objectCount < 0)
+                || (static_cast<std::size_t>(classCount) > reader.getRemainingSize() / snapshot_internal::MinClassRecordSize)
+                || (static_cast<std::size_t>(objectCount) > reader.getRemainingSize() / snapshot_internal::ObjectRecordSize))
+            {
+                return false;
+            }
+
+            database* classDatabase = database::GetInstanse();
+            jutils::jarray<class_entry> classes;
+            classes.reserve(classCount);
+            for (jutils::index_type index = 0; index < classCount; index++)
+            {
+                jutils::jstringID name;
+                jutils::uint64 schemaHash = 0;
+                jutils::uint64 objectSize = 0;
+                jutils::uint64 objectAlignment = 0;
+                jutils::index_type fieldCount = 0;
+                if (!snapshot_internal::ReadName(reader, data, name) || !reader.read(schemaHash) || !reader.read(objectSize)
+                    || !reader.read(objectAlignment) || !reader.read(fieldCount) || (fieldCount < 0)
+                    || (static_cast<std::size_t>(fieldCount) > reader.getRemainingSize() / snapshot_internal::MinFieldRecordSize))
+                {
+                    return false;
+                }
+                for (jutils::index_type fieldIndex = 0; fieldIndex < fieldCount; fieldIndex++)
+                {
+                    jutils::jstringID fieldName;
+                    if (!snapshot_internal::ReadName(reader, data, fieldName) || !reader.skipBytes(sizeof(jutils::uint64) + sizeof(jutils::uint8)))
+                    {
+                        return false;
+                    }
+                }
+
+                class_entry& entry = classes.addDefault();
+                entry.classType = classDatabase != nullptr ? classDatabase->findClassType(name) : nullptr;
+                if (entry.classType == nullptr)
+                {
+                    return false;
+                }
+                entry.classType->initialize();
+                if ((entry.classType->getSchemaHash() != schemaHash) || (entry.classType->getObjectSize() != objectSize)
+                    || (entry.classType->getObjectAlignment() != objectAlignment) || !snapshot_internal::BuildLayout(entry.classType, 0, entry.layout))
+                {
+                    return false;
+                }
+            }
+
+            jutils::jarray<jutils::index_type> objectClasses;
+            jutils::jarray<jutils::uint8*> images;
+            jutils::jarray<jutils::index_type> imageOrder;
+            objectClasses.reserve(objectCount);
+            images.reserve(objectCount);
+            imageOrder.reserve(objectCount);
+            for (jutils::index_type index = 0; index < objectCount; index++)
+            {
+                jutils::index_type classIndex = jutils::index_invalid;
+                jutils::uint64 imageOffset = 0;
+                if (!reader.read(classIndex) || !classes.isValidIndex(classIndex) || !reader.read(imageOffset))
+                {
+                    return false;
+                }
+                const class_type* classType = classes.get(classIndex).classType;
+                if ((imageOffset > m_File.getSize()) || (classType->getObjectSize() > m_File.getSize() - imageOffset)
+                    || (reinterpret_cast<std::uintptr_t>(data + imageOffset) % classType->getObjectAlignment() != 0))
+                {
+                    return false;
+                }
+                objectClasses.add(classIndex);
+                images.add(data + imageOffset);
+                imageOrder.add(index);
+            }
+
+            // Every image must lie after the object table and must not share memory with another one, objects are
+            // constructed in place
+            std::sort(imageOrder.begin(), imageOrder.end(), [&images](const jutils::index_type index1, const jutils::index_type index2) {
+                return images.get(index1) < images.get(index2);
+            });
+            const jutils::uint8* imagesEnd = data + reader.getPosition();
+            for (const auto& index : imageOrder)
+            {
+                if (images.get(index) < imagesEnd)
+                {
+                    return false;
+                }
+                imagesEnd = images.get(index) + classes.get(objectClasses.get(index)).classType->getObjectSize();
+            }
+
+            // Constructing restores the vtable and non-reflected members, reflected fields are copied back from the image
+            jutils::jarray<jutils::uint8> imageCopy;
+            jutils::jarray<std::uintptr_t> pointerSlots;
+            m_Objects.reserve(objectCount);
+            for (jutils::index_type index = 0; index < objectCount; index++)
+            {
+                const class_entry& entry = classes.get(objectClasses.get(index));
+                jutils::uint8* image = images.get(index);
+                imageCopy.resize(static_cast<jutils::index_type>(entry.classType->getObjectSize()));
+                std::memcpy(imageCopy.getData(), image, entry.classType->getObjectSize());
+
+                class_interface* object = entry.classType->constructObjectInternal(image);
+                if (object == nullptr)
+                {
+                    return false;
+                }
+                m_Objects.add(object);
+                for (const auto& block : entry.layout.blocks)
+                {
+                    std::memcpy(image + block.offset, imageCopy.getData() + block.offset, block.size);
+                }
+                for (const auto& pointer : entry.layout.pointers)
+                {
+                    std::uintptr_t slot = 0;
+                    std::memcpy(&slot, imageCopy.getData() + pointer.offset, sizeof(slot));
+                    pointerSlots.add(slot);
+                }
+            }
+
+            jutils::index_type slotIndex = 0;
+            for (jutils::index_type index = 0; index < objectCount; index++)
+            {
+                const class_entry& entry = classes.get(objectClasses.get(index));
+                for (const auto& pointer : entry.layout.pointers)
+                {
+                    const std::uintptr_t slot = pointerSlots.get(slotIndex++);
+                    class_interface* target = (slot > 0) && (slot <= static_cast<std::uintptr_t>(objectCount))
+                        ? m_Objects.get(static_cast<jutils::index_type>(slot - 1)) : nullptr;
+                    if (!pointer.pointerValue->set(images.get(index) + pointer.offset, target))
+                    {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }
+    };
+}
@@ -0,0 +1,166 @@
+﻿// Copyright © 2024 Leonov Maksim. All Rights Reserved.
+
+#include <jreflect/class_type_default.h>
+#include <jreflect/database.h>
+
+#include <thread>
+
+#include <gtest/gtest.h>
+
+namespace database_test
+{
+    class root : public jreflect::class_interface
+    {
+        JREFLECT_CLASS_TYPE(root, true)
+    public:
+        jutils::int32 value = 0;
+    };
+    // Fieldless and intentionally not registered with JREFLECT_INIT_CLASS_TYPE
+    class unregistered_middle : public root
+    {
+        JREFLECT_CLASS_TYPE(unregistered_middle)
+    };
+    class leaf : public unregistered_middle
+    {
+        JREFLECT_CLASS_TYPE(leaf, true)
+    public:
+        root* target = nullptr;
+    };
+    class other : public jreflect::class_interface
+    {
+        JREFLECT_CLASS_TYPE(other)
+    };
+    // Registered by a test after the database is built
+    class late : public root
+    {
+        JREFLECT_CLASS_TYPE(late)
+    };
+    class concurrent_late : public root
+    {
+        JREFLECT_CLASS_TYPE(concurrent_late)
+    };
+    class duplicate : public jreflect::class_interface
+    {
+        JREFLECT_CLASS_TYPE(duplicate)
+    };
+    namespace copy
+    {
+        class duplicate : public root
+        {
+            JREFLECT_CLASS_TYPE(duplicate)
+        };
+    }
+}
+
+JREFLECT_INIT_CLASS_TYPE(database_test, root, JREFLECT_CLASS_FIELD(value))
+JREFLECT_INIT_CLASS_TYPE(database_test, leaf, JREFLECT_CLASS_FIELD(target))
+JREFLECT_INIT_CLASS_TYPE(database_test, other)
+
+namespace
+{
+    using namespace database_test;
+}
+
+TEST(database, unregistered_parent_keeps_registered_ancestors)
+{
+    auto* database = jreflect::database::GetInstanse();
+    EXPECT_EQ(database->findClassType("root"), root::GetClassType());
+    EXPECT_EQ(database->findClassType("leaf"), leaf::GetClassType());
+    EXPECT_EQ(database->findClassType("unregistered_middle"), nullptr);
+
+    EXPECT_TRUE(leaf::GetClassType()->isDerivedFrom<root>());
+    EXPECT_TRUE(leaf::GetClassType()->isDerivedFrom<unregistered_middle>());
+    EXPECT_TRUE(unregistered_middle::GetClassType()->isDerivedFrom<root>());
+    EXPECT_FALSE(root::GetClassType()->isDerivedFrom<leaf>());
+    EXPECT_FALSE(root::GetClassType()->isDerivedFrom<unregistered_middle>());
+    EXPECT_FALSE(leaf::GetClassType()->isDerivedFrom<other>());
+}
+
+TEST(database, object_ptr_accepts_class_derived_through_unregistered_parent)
+{
+    ASSERT_NE(jreflect::database::GetInstanse(), nullptr);
+    auto* classType = leaf::GetClassType();
+    classType->initialize();
+    const jreflect::class_field_entry* field = classType->findField("target");
+    ASSERT_NE(field, nullptr);
+    const auto* fieldValue = field->fieldValue->cast<jreflect::value_type::object_ptr>();
+    ASSERT_NE(fieldValue, nullptr);
+
+    leaf object;
+    leaf target;
+    EXPECT_TRUE(fieldValue->set(field->getValuePtr(&object), &target));
+    EXPECT_EQ(object.target, &target);
+
+    other wrongType;
+    EXPECT_FALSE(fieldValue->set(field->getValuePtr(&object), &wrongType));
+}
+
+TEST(database, adds_classes_registered_after_creation)
+{
+    auto* database = jreflect::database::GetInstanse();
+    ASSERT_NE(database, nullptr);
+    EXPECT_EQ(database->findClassType("late"), nullptr);
+
+    static const jreflect::class_type_registrar registrar([]() -> jreflect::class_type* { return late::GetClassType(); });
+    EXPECT_EQ(jreflect::database::GetInstanse(), database);
+    EXPECT_EQ(database->findClassType("late"), late::GetClassType());
+    EXPECT_EQ(database->findClassType("root"), root::GetClassType());
+    EXPECT_EQ(database->findClassType("leaf"), leaf::GetClassType());
+
+    EXPECT_TRUE(late::GetClassType()->isDerivedFrom<root>());
+    EXPECT_FALSE(late::GetClassType()->isDerivedFrom<leaf>());
+    EXPECT_FALSE(root::GetClassType()->isDerivedFrom<late>());
+    EXPECT_TRUE(leaf::GetClassType()->isDerivedFrom<root>());
+}
+
+TEST(database, lookups_run_while_classes_are_added)
+{
+    auto* database = jreflect::database::GetInstanse();
+    ASSERT_NE(database, nullptr);
+
+    std::atomic<bool> done = false;
+    std::atomic<bool> failed = false;
+    std::thread reader([database, &done, &failed]() {
+        while (!done.load(std::memory_order_acquire))
+        {
+            if ((database->findClassType("root") != root::GetClassType()) || !leaf::GetClassType()->isDerivedFrom<root>())
+            {
+                failed.store(true, std::memory_order_relaxed);
+            }
+        }
+    });
+    static const jreflect::class_type_registrar registrar([]() -> jreflect::class_type* { return concurrent_late::GetClassType(); });
+    EXPECT_EQ(jreflect::database::GetInstanse(), database);
+    done.store(true, std::memory_order_release);
+    reader.join();
+
+    EXPECT_FALSE(failed.load());
+    EXPECT_EQ(database->findClassType("concurrent_late"), concurrent_late::GetClassType());
+    EXPECT_TRUE(concurrent_late::GetClassType()->isDerivedFrom<root>());
+}
+
+TEST(database, leaves_out_classes_with_the_same_name)
+{
+    auto* database = jreflect::database::GetInstanse();
+    ASSERT_NE(database, nullptr);
+
+    static const jreflect::class_type_registrar firstRegistrar([]() -> jreflect::class_type* { return duplicate::GetClassType(); });
+    EXPECT_EQ(jreflect::database::GetInstanse(), database);
+    EXPECT_EQ(database->findClassType("duplicate"), duplicate::GetClassType());
+    EXPECT_TRUE(database->getNameConflicts().isEmpty());
+
+    static const jreflect::class_type_registrar secondRegistrar([]() -> jreflect::class_type* { return copy::duplicate::GetClassType(); });
+    EXPECT_EQ(jreflect::database::GetInstanse(), database);
+    EXPECT_EQ(database->findClassType("duplicate"), nullptr);
+    EXPECT_EQ(database->getClassTypes().find("duplicate"), nullptr);
+
+    const auto& conflicts = database->getNameConflicts();
+    EXPECT_EQ(conflicts.getSize(), 2);
+    EXPECT_NE(std::find(conflicts.begin(), conflicts.end(), duplicate::GetClassType()), conflicts.end());
+    EXPECT_NE(std::find(conflicts.begin(), conflicts.end(), copy::duplicate::GetClassType()), conflicts.end());
+
+    // Left out classes still answer isDerivedFrom() through their parent chain
+    EXPECT_TRUE(copy::duplicate::GetClassType()->isDerivedFrom<root>());
+    EXPECT_FALSE(duplicate::GetClassType()->isDerivedFrom<root>());
+    EXPECT_EQ(database->findClassType("root"), root::GetClassType());
+}
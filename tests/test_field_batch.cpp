@@ -0,0 +1,193 @@
+﻿// Copyright © 2024 Leonov Maksim. All Rights Reserved.
+
+#include <jreflect/class_type_default.h>
+
+#include <gtest/gtest.h>
+
+namespace field_batch_test
+{
+    class particle : public jreflect::class_interface
+    {
+        JREFLECT_CLASS_TYPE(particle, true)
+    public:
+        jutils::int32 id = 0;
+        jutils::int64 mass = 0;
+    };
+    class tracked_particle : public jreflect::class_interface
+    {
+        JREFLECT_CLASS_TYPE(tracked_particle, true)
+        JREFLECT_CLASS_DIRTY_FIELDS()
+        jutils::int32 id = 0;
+        jutils::int64 mass = 0;
+    };
+}
+
+JREFLECT_INIT_CLASS_TYPE(field_batch_test, particle, JREFLECT_CLASS_FIELD(id), JREFLECT_CLASS_FIELD(mass))
+JREFLECT_INIT_CLASS_TYPE(field_batch_test, tracked_particle, JREFLECT_CLASS_FIELD(id), JREFLECT_CLASS_FIELD(mass))
+
+namespace
+{
+    using namespace field_batch_test;
+
+    constexpr jutils::index_type ObjectCount = 4;
+
+    template<typename T>
+    const jreflect::class_field_entry* FindField(const char* name)
+    {
+        jreflect::class_type* classType = T::GetClassType();
+        classType->initialize();
+        return classType->findField(name);
+    }
+    template<typename T>
+    const jreflect::class_field* FindClassField(const char* name)
+    {
+        jreflect::class_type* classType = T::GetClassType();
+        classType->initialize();
+        return classType->getFields().find(name);
+    }
+}
+
+TEST(field_batch, gathers_and_scatters_through_object_lists)
+{
+    const jreflect::class_field_entry* mass = FindField<particle>("mass");
+    const jreflect::class_field* id = FindClassField<particle>("id");
+    ASSERT_NE(mass, nullptr);
+    ASSERT_NE(id, nullptr);
+
+    particle particles[ObjectCount];
+    jreflect::class_interface* objects[ObjectCount];
+    for (jutils::index_type index = 0; index < ObjectCount; index++)
+    {
+        objects[index] = &particles[index];
+    }
+
+    const jutils::int64 masses[ObjectCount] = { 100, 200, 300, 400 };
+    const jutils::int32 ids[ObjectCount] = { 10, 20, 30, 40 };
+    EXPECT_TRUE(mass->scatterValues<jutils::int64>(objects, masses));
+    EXPECT_TRUE(id->scatterValues<jutils::int32>(objects, ids));
+    for (jutils::index_type index = 0; index < ObjectCount; index++)
+    {
+        EXPECT_EQ(particles[index].mass, masses[index]);
+        EXPECT_EQ(particles[index].id, ids[index]);
+    }
+
+    const jreflect::class_interface* constObjects[ObjectCount] = { objects[0], objects[1], objects[2], objects[3] };
+    jutils::int64 outMasses[ObjectCount] = {};
+    jutils::int32 outIds[ObjectCount] = {};
+    EXPECT_TRUE(mass->gatherValues<jutils::int64>(constObjects, outMasses));
+    EXPECT_TRUE(id->gatherValues<jutils::int32>(constObjects, outIds));
+    for (jutils::index_type index = 0; index < ObjectCount; index++)
+    {
+        EXPECT_EQ(outMasses[index], masses[index]);
+        EXPECT_EQ(outIds[index], ids[index]);
+    }
+
+    jutils::int32 wrongType[ObjectCount] = {};
+    EXPECT_FALSE(mass->gatherValues<jutils::int32>(constObjects, wrongType));
+    EXPECT_FALSE(id->scatterValues<jutils::int64>(objects, masses));
+    EXPECT_EQ(particles[0].id, 10);
+}
+
+TEST(field_batch, gathers_and_scatters_strided_arrays)
+{
+    const jreflect::class_field_entry* id = FindField<particle>("id");
+    const jreflect::class_field* mass = FindClassField<particle>("mass");
+    ASSERT_NE(id, nullptr);
+    ASSERT_NE(mass, nullptr);
+
+    particle particles[ObjectCount];
+    const jutils::int32 ids[ObjectCount] = { 5, 6, 7, 8 };
+    const jutils::int64 masses[ObjectCount] = { 50, 150, 250, 350 };
+    EXPECT_TRUE(id->scatterValues<jutils::int32>(particles, sizeof(particle), ObjectCount, ids));
+    EXPECT_TRUE(mass->scatterValues<jutils::int64>(particles, sizeof(particle), ObjectCount, masses));
+    for (jutils::index_type index = 0; index < ObjectCount; index++)
+    {
+        EXPECT_EQ(particles[index].id, ids[index]);
+        EXPECT_EQ(particles[index].mass, masses[index]);
+    }
+
+    jutils::int32 outIds[ObjectCount] = {};
+    jutils::int64 outMasses[ObjectCount] = {};
+    EXPECT_TRUE(id->gatherValues<jutils::int32>(particles, sizeof(particle), ObjectCount, outIds));
+    EXPECT_TRUE(mass->gatherValues<jutils::int64>(particles, sizeof(particle), ObjectCount, outMasses));
+    for (jutils::index_type index = 0; index < ObjectCount; index++)
+    {
+        EXPECT_EQ(outIds[index], ids[index]);
+        EXPECT_EQ(outMasses[index], masses[index]);
+    }
+
+    // Odd count, the last value is left as it was
+    jutils::int64 oddMasses[ObjectCount] = {};
+    EXPECT_TRUE(mass->gatherValues<jutils::int64>(particles, sizeof(particle), ObjectCount - 1, oddMasses));
+    EXPECT_EQ(oddMasses[0], masses[0]);
+    EXPECT_EQ(oddMasses[ObjectCount - 2], masses[ObjectCount - 2]);
+    EXPECT_EQ(oddMasses[ObjectCount - 1], 0);
+
+    EXPECT_FALSE(id->gatherValues<jutils::int64>(particles, sizeof(particle), ObjectCount, outMasses));
+    EXPECT_FALSE(mass->scatterValues<jutils::int64>(nullptr, sizeof(particle), ObjectCount, masses));
+    EXPECT_TRUE(mass->scatterValues<jutils::int64>(nullptr, sizeof(particle), 0, masses));
+}
+
+TEST(field_batch, skips_null_objects)
+{
+    const jreflect::class_field_entry* id = FindField<particle>("id");
+    ASSERT_NE(id, nullptr);
+
+    particle particles[2];
+    jreflect::class_interface* objects[] = { nullptr, &particles[0], nullptr, &particles[1] };
+    const jutils::int32 ids[] = { 1, 2, 3, 4 };
+    EXPECT_TRUE(id->scatterValues<jutils::int32>(objects, ids));
+    EXPECT_EQ(particles[0].id, 2);
+    EXPECT_EQ(particles[1].id, 4);
+
+    const jreflect::class_interface* constObjects[] = { nullptr, &particles[0], nullptr, &particles[1] };
+    jutils::int32 outIds[] = { -1, -1, -1, -1 };
+    EXPECT_TRUE(id->gatherValues<jutils::int32>(constObjects, outIds));
+    EXPECT_EQ(outIds[0], -1);
+    EXPECT_EQ(outIds[1], 2);
+    EXPECT_EQ(outIds[2], -1);
+    EXPECT_EQ(outIds[3], 4);
+
+    jreflect::class_interface* nullObjects[] = { nullptr, nullptr };
+    EXPECT_TRUE(id->scatterValues<jutils::int32>(nullObjects, ids));
+}
+
+TEST(field_batch, scatter_marks_dirty_fields)
+{
+    const jreflect::class_field_entry* id = FindField<tracked_particle>("id");
+    const jreflect::class_field* mass = FindClassField<tracked_particle>("mass");
+    ASSERT_NE(id, nullptr);
+    ASSERT_NE(mass, nullptr);
+
+    tracked_particle particles[ObjectCount];
+    jreflect::class_interface* objects[ObjectCount];
+    for (jutils::index_type index = 0; index < ObjectCount; index++)
+    {
+        objects[index] = &particles[index];
+    }
+
+    // Gathering doesn't mark anything
+    jutils::int32 outIds[ObjectCount] = {};
+    const jreflect::class_interface* constObjects[ObjectCount] = { objects[0], objects[1], objects[2], objects[3] };
+    EXPECT_TRUE(id->gatherValues<jutils::int32>(constObjects, outIds));
+    EXPECT_TRUE(id->gatherValues<jutils::int32>(particles, sizeof(tracked_particle), ObjectCount, outIds));
+    for (const auto& particle : particles)
+    {
+        EXPECT_TRUE(particle.getDirtyFields()->isEmpty());
+    }
+
+    const jutils::int32 ids[ObjectCount] = { 1, 2, 3, 4 };
+    EXPECT_TRUE(id->scatterValues<jutils::int32>(objects, ids));
+    for (const auto& particle : particles)
+    {
+        EXPECT_TRUE(particle.getDirtyFields()->isDirty(id->index));
+        EXPECT_FALSE(particle.getDirtyFields()->isDirty(mass->getIndex()));
+    }
+
+    const jutils::int64 masses[ObjectCount] = { 100, 200, 300, 400 };
+    EXPECT_TRUE(mass->scatterValues<jutils::int64>(particles, sizeof(tracked_particle), ObjectCount - 1, masses));
+    for (jutils::index_type index = 0; index < ObjectCount; index++)
+    {
+        EXPECT_EQ(particles[index].getDirtyFields()->isDirty(mass->getIndex()), index < ObjectCount - 1);
+    }
+}
@@ -0,0 +1,142 @@
+﻿// Copyright © 2024 Leonov Maksim. All Rights Reserved.
+
+#include <jreflect/class_type_default.h>
+
+#include <memory>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+namespace field_lookup_test
+{
+    class lookup_base : public jreflect::class_interface
+    {
+        JREFLECT_CLASS_TYPE(lookup_base, true)
+    public:
+        jutils::int32 first = 0;
+        jutils::int32 second = 0;
+    };
+    class lookup_derived : public lookup_base
+    {
+        JREFLECT_CLASS_TYPE(lookup_derived, true)
+    public:
+        jutils::int64 first = 0;
+        jutils::int64 third = 0;
+    };
+
+    // Unregistered class types built by hand, each gives its fields a different offset
+    class lookup_class_type final : public jreflect::class_type
+    {
+    public:
+        void setOffsetBase(const std::size_t offsetBase) { m_OffsetBase = offsetBase; }
+
+        [[nodiscard]] virtual jutils::jstringID getName() const override { return "lookup_class_type"; }
+        [[nodiscard]] virtual jreflect::class_type* getParent() const override { return nullptr; }
+
+    protected:
+
+        virtual void initializeClassType() override
+        {
+            createField<jutils::int32>("alpha", m_OffsetBase);
+            createField<jutils::int32>("beta", m_OffsetBase + 4);
+        }
+
+    private:
+
+        std::size_t m_OffsetBase = 0;
+    };
+}
+
+JREFLECT_INIT_CLASS_TYPE(field_lookup_test, lookup_base, JREFLECT_CLASS_FIELD(first), JREFLECT_CLASS_FIELD(second))
+JREFLECT_INIT_CLASS_TYPE(field_lookup_test, lookup_derived, JREFLECT_CLASS_FIELD_NAMED(first, "derivedFirst"), JREFLECT_CLASS_FIELD(third))
+
+namespace
+{
+    using namespace field_lookup_test;
+
+    template<typename T>
+    const jreflect::class_type* GetInitializedClassType()
+    {
+        jreflect::class_type* classType = T::GetClassType();
+        classType->initialize();
+        return classType;
+    }
+}
+
+TEST(field_lookup, repeated_lookups_hit_the_same_entry)
+{
+    const jreflect::class_type* classType = GetInitializedClassType<lookup_derived>();
+    const jreflect::class_field_entry* second = classType->findField("second");
+    ASSERT_NE(second, nullptr);
+    EXPECT_EQ(second->offset, offsetof(lookup_base, second));
+    EXPECT_EQ(second->classType, classType);
+    for (jutils::int32 index = 0; index < 3; index++)
+    {
+        EXPECT_EQ(classType->findField("second"), second);
+    }
+
+    const jreflect::class_field_entry* third = classType->findField("third");
+    ASSERT_NE(third, nullptr);
+    EXPECT_EQ(third->offset, offsetof(lookup_derived, third));
+    EXPECT_EQ(classType->findField("second"), second);
+    EXPECT_EQ(classType->findField("third"), third);
+}
+
+TEST(field_lookup, misses_are_not_cached_as_hits)
+{
+    const jreflect::class_type* baseType = GetInitializedClassType<lookup_base>();
+    const jreflect::class_type* derivedType = GetInitializedClassType<lookup_derived>();
+    for (jutils::int32 index = 0; index < 2; index++)
+    {
+        EXPECT_EQ(baseType->findField("missing"), nullptr);
+        EXPECT_EQ(baseType->findField(jutils::jstringID_NONE), nullptr);
+        // Fields of a derived class aren't visible from the parent, even right after the derived lookup
+        EXPECT_NE(derivedType->findField("third"), nullptr);
+        EXPECT_EQ(baseType->findField("third"), nullptr);
+        EXPECT_NE(derivedType->findField("derivedFirst"), nullptr);
+        EXPECT_EQ(baseType->findField("derivedFirst"), nullptr);
+    }
+
+    const jreflect::class_field_entry* baseFirst = baseType->findField("first");
+    ASSERT_NE(baseFirst, nullptr);
+    EXPECT_EQ(baseFirst->classType, baseType);
+    const jreflect::class_field_entry* derivedBaseFirst = derivedType->findField("first");
+    ASSERT_NE(derivedBaseFirst, nullptr);
+    EXPECT_EQ(derivedBaseFirst->classType, derivedType);
+    EXPECT_EQ(derivedBaseFirst->offset, baseFirst->offset);
+    EXPECT_EQ(baseType->findField("first"), baseFirst);
+}
+
+TEST(field_lookup, classes_sharing_a_cache_slot)
+{
+    // The cache has fewer slots than there are classes here, so at least two of them share the slot of "alpha"
+    constexpr jutils::int32 classCount = 65;
+    const auto classTypes = std::make_unique<lookup_class_type[]>(classCount);
+    for (jutils::int32 index = 0; index < classCount; index++)
+    {
+        classTypes[index].setOffsetBase(static_cast<std::size_t>(index) * 8);
+        classTypes[index].initialize();
+    }
+
+    const auto checkLookups = [&classTypes]() {
+        for (jutils::int32 round = 0; round < 2; round++)
+        {
+            for (jutils::int32 index = 0; index < classCount; index++)
+            {
+                const jreflect::class_field_entry* alpha = classTypes[index].findField("alpha");
+                ASSERT_NE(alpha, nullptr);
+                EXPECT_EQ(alpha->classType, &classTypes[index]);
+                EXPECT_EQ(alpha->offset, static_cast<std::size_t>(index) * 8);
+                const jreflect::class_field_entry* beta = classTypes[index].findField("beta");
+                ASSERT_NE(beta, nullptr);
+                EXPECT_EQ(beta->offset, static_cast<std::size_t>(index) * 8 + 4);
+                EXPECT_EQ(classTypes[index].findField("gamma"), nullptr);
+            }
+        }
+    };
+    checkLookups();
+
+    // Every thread starts with its own cold cache
+    std::thread thread(checkLookups);
+    thread.join();
+}
@@ -0,0 +1,160 @@
+﻿// Copyright © 2024 Leonov Maksim. All Rights Reserved.
+
+#include <jreflect/class_type_default.h>
+#include <jreflect/field_ref.h>
+#include <jreflect/json.h>
+
+#include <gtest/gtest.h>
+
+namespace field_ref_test
+{
+    class plain : public jreflect::class_interface
+    {
+        JREFLECT_CLASS_TYPE(plain, true)
+    public:
+        jutils::int32 health = 0;
+    };
+    class tracked : public jreflect::class_interface
+    {
+        JREFLECT_CLASS_TYPE(tracked, true)
+        JREFLECT_CLASS_DIRTY_FIELDS()
+        // Declared right after the macro without an access specifier
+        jutils::int32 health = 0;
+        jutils::jarray<jutils::int32> values;
+    };
+    class tracked_child : public tracked
+    {
+        JREFLECT_CLASS_TYPE(tracked_child, true)
+    public:
+        jutils::int64 extra = 0;
+    };
+    // Tracking added below a class that doesn't have it
+    class untracked_base : public jreflect::class_interface
+    {
+        JREFLECT_CLASS_TYPE(untracked_base, true)
+    public:
+        jutils::int32 armor = 0;
+    };
+    class tracked_leaf final : public untracked_base
+    {
+        JREFLECT_CLASS_TYPE(tracked_leaf, true)
+        JREFLECT_CLASS_DIRTY_FIELDS()
+        jutils::int32 level = 0;
+    };
+}
+
+JREFLECT_INIT_CLASS_TYPE(field_ref_test, plain, JREFLECT_CLASS_FIELD(health))
+JREFLECT_INIT_CLASS_TYPE(field_ref_test, tracked, JREFLECT_CLASS_FIELD(health), JREFLECT_CLASS_FIELD(values))
+JREFLECT_INIT_CLASS_TYPE(field_ref_test, tracked_child, JREFLECT_CLASS_FIELD(extra))
+JREFLECT_INIT_CLASS_TYPE(field_ref_test, untracked_base, JREFLECT_CLASS_FIELD(armor))
+JREFLECT_INIT_CLASS_TYPE(field_ref_test, tracked_leaf, JREFLECT_CLASS_FIELD(level))
+
+namespace
+{
+    using namespace field_ref_test;
+
+    static_assert(!jreflect::has_dirty_fields_v<plain>);
+    static_assert(jreflect::has_dirty_fields_v<tracked>);
+    static_assert(jreflect::has_dirty_fields_v<tracked_child>);
+    static_assert(!jreflect::has_dirty_fields_v<untracked_base>);
+}
+
+TEST(field_ref, binds_by_name_and_type)
+{
+    const jreflect::field_ref<plain, jutils::int32> health("health");
+    const jreflect::field_ref<plain, jutils::int16> wrongType("health");
+    const jreflect::field_ref<plain, jutils::int32> missing("missing");
+    EXPECT_TRUE(health.isValid());
+    EXPECT_FALSE(wrongType.isValid());
+    EXPECT_FALSE(missing.isValid());
+
+    plain object;
+    health.set(object, 42);
+    EXPECT_EQ(object.health, 42);
+    EXPECT_EQ(health.get(object), 42);
+    EXPECT_EQ(object.getDirtyFields(), nullptr);
+}
+
+TEST(field_ref, marks_dirty_fields)
+{
+    const jreflect::field_ref<tracked, jutils::int32> health("health");
+    const jreflect::field_ref<tracked, jutils::jarray<jutils::int32>> values("values");
+    ASSERT_TRUE(health.isValid());
+    ASSERT_TRUE(values.isValid());
+
+    tracked object;
+    const jreflect::dirty_fields* dirtyFields = object.getDirtyFields();
+    ASSERT_NE(dirtyFields, nullptr);
+    EXPECT_TRUE(dirtyFields->isEmpty());
+
+    EXPECT_TRUE(values.get(object).isEmpty());
+    EXPECT_TRUE(dirtyFields->isEmpty());
+
+    health.set(object, 5);
+    EXPECT_TRUE(dirtyFields->isDirty(health.getFieldIndex()));
+    EXPECT_FALSE(dirtyFields->isDirty(values.getFieldIndex()));
+
+    values.modify(object).add(1);
+    EXPECT_TRUE(dirtyFields->isDirty(values.getFieldIndex()));
+
+    object.getDirtyFields()->clear();
+    EXPECT_TRUE(dirtyFields->isEmpty());
+}
+
+TEST(field_ref, derived_classes_inherit_tracking)
+{
+    const jreflect::field_ref<tracked_child, jutils::int64> extra("extra");
+    ASSERT_TRUE(extra.isValid());
+
+    tracked_child object;
+    extra.set(object, 7);
+    EXPECT_EQ(object.extra, 7);
+    EXPECT_TRUE(object.getDirtyFields()->isDirty(extra.getFieldIndex()));
+}
+
+TEST(field_ref, base_class_ref_marks_derived_tracking)
+{
+    const jreflect::field_ref<untracked_base, jutils::int32> armor("armor");
+    const jreflect::field_ref<tracked_leaf, jutils::int32> level("level");
+    ASSERT_TRUE(armor.isValid());
+    ASSERT_TRUE(level.isValid());
+
+    tracked_leaf object;
+    untracked_base& base = object;
+    armor.set(base, 3);
+    EXPECT_EQ(object.armor, 3);
+    EXPECT_TRUE(object.getDirtyFields()->isDirty(armor.getFieldIndex()));
+    EXPECT_FALSE(object.getDirtyFields()->isDirty(level.getFieldIndex()));
+
+    untracked_base plainBase;
+    armor.set(plainBase, 4);
+    EXPECT_EQ(plainBase.armor, 4);
+}
+
+TEST(field_ref, reflection_writes_through_value_pointers)
+{
+    jreflect::class_type* classType = tracked::GetClassType();
+    classType->initialize();
+    const jreflect::class_field_entry* field = classType->findField("health");
+    ASSERT_NE(field, nullptr);
+    const auto* fieldValue = field->fieldValue->cast<jreflect::value_type::int32>();
+    ASSERT_NE(fieldValue, nullptr);
+
+    // getValuePtr() isn't tracked, see JREFLECT_CLASS_DIRTY_FIELDS()
+    tracked object;
+    EXPECT_TRUE(fieldValue->set(field->getValuePtr(&object), 8));
+    EXPECT_EQ(object.health, 8);
+    EXPECT_TRUE(object.getDirtyFields()->isEmpty());
+
+    EXPECT_TRUE(fieldValue->set(field->modifyValuePtr(&object), 9));
+    EXPECT_EQ(object.health, 9);
+    EXPECT_TRUE(object.getDirtyFields()->isDirty(field->index));
+
+    object.getDirtyFields()->clear();
+    const std::string json = "{\"health\":10}";
+    jreflect::json_reader reader(json.data(), json.size());
+    ASSERT_TRUE(reader.readObject(&object));
+    EXPECT_EQ(object.health, 10);
+    EXPECT_TRUE(object.getDirtyFields()->isDirty(field->index));
+    EXPECT_FALSE(object.getDirtyFields()->isDirty(classType->findField("values")->index));
+}
@@ -0,0 +1,132 @@
+﻿// Copyright © 2024 Leonov Maksim. All Rights Reserved.
+
+#include <jreflect/class_type_default.h>
+#include <jreflect/graph.h>
+
+#include <gtest/gtest.h>
+
+namespace graph_test
+{
+    class vertex : public jreflect::class_interface
+    {
+        JREFLECT_CLASS_TYPE(vertex, true)
+    public:
+        jutils::int32 id = 0;
+        vertex* next = nullptr;
+        jutils::jarray<vertex*> edges;
+        std::atomic<jutils::int32> visitCount = 0;
+    };
+}
+
+JREFLECT_INIT_CLASS_TYPE(graph_test, vertex, JREFLECT_CLASS_FIELD(id), JREFLECT_CLASS_FIELD(next), JREFLECT_CLASS_FIELD(edges))
+
+namespace
+{
+    using namespace graph_test;
+
+    // Chain through next, every vertex also points to a few others. The last vertex is left unreachable
+    std::unique_ptr<vertex[]> MakeGraph(const jutils::int32 count)
+    {
+        auto vertices = std::make_unique<vertex[]>(count);
+        for (jutils::int32 index = 0; index < count - 1; index++)
+        {
+            vertex& current = vertices[index];
+            current.id = index;
+            current.next = index + 2 < count ? &vertices[index + 1] : nullptr;
+            for (jutils::int32 edge = 1; edge <= 3; edge++)
+            {
+                current.edges.add(&vertices[(index * 7 + edge * 13) % (count - 1)]);
+            }
+        }
+        return vertices;
+    }
+}
+
+TEST(graph, visited_set_grows_without_losing_objects)
+{
+    constexpr jutils::int32 count = 5000;
+    const auto vertices = std::make_unique<vertex[]>(count);
+
+    jreflect::object_visited_set visited;
+    for (jutils::int32 index = 0; index < count; index++)
+    {
+        EXPECT_TRUE(visited.insert(&vertices[index]));
+    }
+    for (jutils::int32 index = 0; index < count; index++)
+    {
+        EXPECT_FALSE(visited.insert(&vertices[index]));
+        EXPECT_TRUE(visited.contains(&vertices[index]));
+    }
+    vertex other;
+    EXPECT_FALSE(visited.contains(&other));
+    EXPECT_FALSE(visited.insert(nullptr));
+    EXPECT_EQ(visited.getSize(), static_cast<std::size_t>(count));
+
+    visited.reset(count);
+    EXPECT_EQ(visited.getSize(), 0u);
+    EXPECT_FALSE(visited.contains(&vertices[0]));
+}
+
+TEST(graph, visited_set_inserts_each_object_once_across_threads)
+{
+    constexpr jutils::int32 count = 20000;
+    constexpr jutils::int32 threadCount = 8;
+    const auto vertices = std::make_unique<vertex[]>(count);
+
+    jreflect::object_visited_set visited;
+    std::atomic<jutils::int32> insertedCount = 0;
+    jutils::jarray<std::thread> threads;
+    for (jutils::int32 threadIndex = 0; threadIndex < threadCount; threadIndex++)
+    {
+        threads.addDefault() = std::thread([&vertices, &visited, &insertedCount, threadIndex]() {
+            for (jutils::int32 index = 0; index < count; index++)
+            {
+                if (visited.insert(&vertices[(index + threadIndex * 997) % count]))
+                {
+                    insertedCount.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    EXPECT_EQ(insertedCount.load(), count);
+    EXPECT_EQ(visited.getSize(), static_cast<std::size_t>(count));
+}
+
+TEST(graph, walk_visits_reachable_objects_once)
+{
+    constexpr jutils::int32 count = 3000;
+    const auto vertices = MakeGraph(count);
+    jreflect::class_interface* const roots[] = { &vertices[0], &vertices[0] };
+
+    jutils::int32 visitedCount = 0;
+    EXPECT_EQ(jreflect::walk_object_graph(roots, [&visitedCount](jreflect::class_interface* object) {
+        static_cast<vertex*>(object)->visitCount.fetch_add(1, std::memory_order_relaxed);
+        visitedCount++;
+    }), static_cast<std::size_t>(count - 1));
+    EXPECT_EQ(visitedCount, count - 1);
+    for (jutils::int32 index = 0; index < count - 1; index++)
+    {
+        EXPECT_EQ(vertices[index].visitCount.load(), 1);
+    }
+    EXPECT_EQ(vertices[count - 1].visitCount.load(), 0);
+}
+
+TEST(graph, parallel_walk_visits_reachable_objects_once)
+{
+    constexpr jutils::int32 count = 20000;
+    const auto vertices = MakeGraph(count);
+    jreflect::class_interface* const roots[] = { &vertices[0], &vertices[count / 2] };
+
+    EXPECT_EQ(jreflect::walk_object_graph_parallel(roots, [](jreflect::class_interface* object) {
+        static_cast<vertex*>(object)->visitCount.fetch_add(1, std::memory_order_relaxed);
+    }, 4), static_cast<std::size_t>(count - 1));
+    for (jutils::int32 index = 0; index < count - 1; index++)
+    {
+        EXPECT_EQ(vertices[index].visitCount.load(), 1);
+    }
+    EXPECT_EQ(vertices[count - 1].visitCount.load(), 0);
+}
@@ -0,0 +1,159 @@
+﻿// Copyright © 2024 Leonov Maksim. All Rights Reserved.
+
+// Built as a separate executable with JREFLECT_ENABLE_INSTRUMENTATION defined
+#include <jreflect/class_type_default.h>
+#include <jreflect/database.h>
+#include <jreflect/instrumentation_report.h>
+
+#include <thread>
+
+#include <gtest/gtest.h>
+
+namespace instrumentation_test
+{
+    class sensor : public jreflect::class_interface
+    {
+        JREFLECT_CLASS_TYPE(sensor, true)
+    public:
+        jutils::int32 value = 0;
+        jutils::int32 limit = 0;
+    };
+    // Same field name as sensor, counted separately
+    class gauge : public jreflect::class_interface
+    {
+        JREFLECT_CLASS_TYPE(gauge, true)
+    public:
+        jutils::int64 value = 0;
+    };
+}
+
+JREFLECT_INIT_CLASS_TYPE(instrumentation_test, sensor, JREFLECT_CLASS_FIELD(value), JREFLECT_CLASS_FIELD(limit))
+JREFLECT_INIT_CLASS_TYPE(instrumentation_test, gauge, JREFLECT_CLASS_FIELD(value))
+
+namespace
+{
+    using namespace instrumentation_test;
+
+    template<typename T>
+    const jreflect::class_field_entry* FindField(const char* name)
+    {
+        auto* classType = T::GetClassType();
+        classType->initialize();
+        return classType->findField(name);
+    }
+
+    jutils::uint64 GetFieldAccessCount(const jreflect::instrumentation_data& data, const jreflect::class_type* classType,
+        const jreflect::class_field_entry* field)
+    {
+        const auto* counters = data.fieldAccesses.find(classType);
+        return (counters != nullptr) && (field->index < counters->getSize()) ? counters->get(field->index).count : 0;
+    }
+}
+
+TEST(instrumentation, counts_field_accesses_per_class_field)
+{
+    const jreflect::class_field_entry* sensorValue = FindField<sensor>("value");
+    const jreflect::class_field_entry* sensorLimit = FindField<sensor>("limit");
+    const jreflect::class_field_entry* gaugeValue = FindField<gauge>("value");
+    ASSERT_NE(sensorValue, nullptr);
+    ASSERT_NE(sensorLimit, nullptr);
+    ASSERT_NE(gaugeValue, nullptr);
+    jreflect::reset_instrumentation();
+
+    sensor sensorObject;
+    gauge gaugeObject;
+    const auto& sensorField = sensor::GetClassType()->getFields().find("value");
+    ASSERT_NE(sensorField, nullptr);
+    for (jutils::int32 index = 0; index < 3; index++)
+    {
+        EXPECT_NE(sensorValue->getValuePtr(&sensorObject), nullptr);
+    }
+    EXPECT_NE(sensorField->getValuePtr(&sensorObject), nullptr);
+    EXPECT_NE(gaugeValue->getValuePtr(&gaugeObject), nullptr);
+
+    std::thread thread([sensorLimit, &sensorObject]() {
+        EXPECT_NE(sensorLimit->getValuePtr(static_cast<const jreflect::class_interface*>(&sensorObject)), nullptr);
+    });
+    thread.join();
+
+    const jreflect::instrumentation_data data = jreflect::collect_instrumentation();
+    EXPECT_EQ(GetFieldAccessCount(data, sensor::GetClassType(), sensorValue), 4u);
+    EXPECT_EQ(GetFieldAccessCount(data, sensor::GetClassType(), sensorLimit), 1u);
+    EXPECT_EQ(GetFieldAccessCount(data, gauge::GetClassType(), gaugeValue), 1u);
+
+    std::string text;
+    jreflect::write_instrumentation_text(data, text);
+    EXPECT_NE(text.find("sensor.value: 4"), std::string::npos);
+    EXPECT_NE(text.find("gauge.value: 1"), std::string::npos);
+    std::string json;
+    jreflect::write_instrumentation_json(data, json);
+    EXPECT_NE(json.find("\"sensor.limit\":{\"count\":1"), std::string::npos);
+
+    jreflect::reset_instrumentation();
+    EXPECT_TRUE(jreflect::collect_instrumentation().fieldAccesses.isEmpty());
+}
+
+TEST(instrumentation, counts_lookups_and_value_access)
+{
+    auto* database = jreflect::database::GetInstanse();
+    ASSERT_NE(database, nullptr);
+    const jreflect::class_field_entry* field = FindField<sensor>("value");
+    ASSERT_NE(field, nullptr);
+    const auto* fieldValue = field->fieldValue->cast<jreflect::value_type::int32>();
+    ASSERT_NE(fieldValue, nullptr);
+    jreflect::reset_instrumentation();
+
+    EXPECT_EQ(database->findClassType("sensor"), sensor::GetClassType());
+    EXPECT_EQ(database->findClassType("missing"), nullptr);
+    EXPECT_NE(sensor::GetClassType()->findField("limit"), nullptr);
+    sensor object;
+    EXPECT_TRUE(fieldValue->set(&object.value, 5));
+    jutils::int32 value = 0;
+    EXPECT_TRUE(fieldValue->get(&object.value, value));
+
+    const jreflect::instrumentation_data data = jreflect::collect_instrumentation();
+    const auto* classLookups = data.classLookups.find(sensor::GetClassType());
+    ASSERT_NE(classLookups, nullptr);
+    EXPECT_EQ(classLookups->count, 1u);
+    EXPECT_EQ(data.classLookupMisses.count, 1u);
+    const auto* fieldLookups = data.fieldLookups.find(sensor::GetClassType());
+    ASSERT_NE(fieldLookups, nullptr);
+    EXPECT_EQ(fieldLookups->count, 1u);
+    EXPECT_EQ(data.valueSets[static_cast<std::size_t>(jreflect::value_type::int32)].count, 1u);
+    EXPECT_EQ(data.valueGets[static_cast<std::size_t>(jreflect::value_type::int32)].count, 1u);
+}
+
+TEST(instrumentation, counts_derived_checks_and_value_access_from_many_threads)
+{
+    const jreflect::class_field_entry* field = FindField<gauge>("value");
+    ASSERT_NE(field, nullptr);
+    const auto* fieldValue = field->fieldValue->cast<jreflect::value_type::int64>();
+    ASSERT_NE(fieldValue, nullptr);
+    jreflect::reset_instrumentation();
+
+    constexpr jutils::int32 threadCount = 4;
+    constexpr jutils::int32 iterationCount = 1000;
+    jutils::jarray<std::thread> threads;
+    for (jutils::int32 threadIndex = 0; threadIndex < threadCount; threadIndex++)
+    {
+        threads.addDefault() = std::thread([fieldValue]() {
+            gauge object;
+            for (jutils::int32 index = 0; index < iterationCount; index++)
+            {
+                EXPECT_FALSE(gauge::GetClassType()->isDerivedFrom<sensor>());
+                EXPECT_TRUE(fieldValue->set(&object.value, index));
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    const jreflect::instrumentation_data data = jreflect::collect_instrumentation();
+    const auto* derivedChecks = data.derivedChecks.find(gauge::GetClassType());
+    ASSERT_NE(derivedChecks, nullptr);
+    EXPECT_EQ(derivedChecks->count, static_cast<jutils::uint64>(threadCount * iterationCount));
+    EXPECT_EQ(data.valueSets[static_cast<std::size_t>(jreflect::value_type::int64)].count, static_cast<jutils::uint64>(threadCount * iterationCount));
+    EXPECT_EQ(data.derivedChecks.find(sensor::GetClassType()), nullptr);
+}
@@ -0,0 +1,219 @@
+﻿// Copyright © 2024 Leonov Maksim. All Rights Reserved.
+
+#include <jreflect/class_type_default.h>
+#include <jreflect/json.h>
+
+#include <filesystem>
+#include <fstream>
+
+#include <gtest/gtest.h>
+
+namespace json_test
+{
+    class json_point : public jreflect::class_interface
+    {
+        JREFLECT_CLASS_TYPE(json_point, true)
+    public:
+        jutils::int32 x = 0;
+        jutils::int32 y = 0;
+    };
+    class json_document : public jreflect::class_interface
+    {
+        JREFLECT_CLASS_TYPE(json_document, true)
+    public:
+        bool enabled = false;
+        jutils::int8 level = 0;
+        jutils::uint16 port = 0;
+        jutils::int32 offset = 0;
+        jutils::uint64 size = 0;
+        jutils::jstring title;
+        json_point origin;
+        json_document* next = nullptr;
+        jutils::jarray<jutils::int32> values;
+        jutils::jarray<json_point> points;
+        std::vector<bool> flags;
+    };
+}
+
+JREFLECT_INIT_CLASS_TYPE(json_test, json_point, JREFLECT_CLASS_FIELD(x), JREFLECT_CLASS_FIELD(y))
+JREFLECT_INIT_CLASS_TYPE(json_test, json_document,
+    JREFLECT_CLASS_FIELD(enabled), JREFLECT_CLASS_FIELD(level), JREFLECT_CLASS_FIELD(port), JREFLECT_CLASS_FIELD(offset),
+    JREFLECT_CLASS_FIELD(size), JREFLECT_CLASS_FIELD(title), JREFLECT_CLASS_FIELD(origin), JREFLECT_CLASS_FIELD(next),
+    JREFLECT_CLASS_FIELD(values), JREFLECT_CLASS_FIELD(points), JREFLECT_CLASS_FIELD(flags)
+)
+
+namespace
+{
+    using namespace json_test;
+
+    void FillDocument(json_document& document, json_document* next)
+    {
+        document.enabled = true;
+        document.level = -5;
+        document.port = 8080;
+        document.offset = -123456;
+        document.size = 0xFFFFFFFFFFFFFFFFull;
+        document.title = "line \"one\"\n\ttab \\ \x01 end";
+        document.origin.x = 3;
+        document.origin.y = -4;
+        document.next = next;
+        document.values.add(1);
+        document.values.add(-2);
+        document.values.add(3);
+        document.points.addDefault().x = 7;
+        document.points.addDefault().y = 8;
+        document.flags = { true, false, true };
+    }
+    void ExpectSameDocument(const json_document& document, const json_document& expected)
+    {
+        EXPECT_EQ(document.enabled, expected.enabled);
+        EXPECT_EQ(document.level, expected.level);
+        EXPECT_EQ(document.port, expected.port);
+        EXPECT_EQ(document.offset, expected.offset);
+        EXPECT_EQ(document.size, expected.size);
+        EXPECT_EQ(document.title, expected.title);
+        EXPECT_EQ(document.origin.x, expected.origin.x);
+        EXPECT_EQ(document.origin.y, expected.origin.y);
+        ASSERT_EQ(document.values.getSize(), expected.values.getSize());
+        for (jutils::index_type index = 0; index < document.values.getSize(); index++)
+        {
+            EXPECT_EQ(document.values.get(index), expected.values.get(index));
+        }
+        ASSERT_EQ(document.points.getSize(), expected.points.getSize());
+        for (jutils::index_type index = 0; index < document.points.getSize(); index++)
+        {
+            EXPECT_EQ(document.points.get(index).x, expected.points.get(index).x);
+            EXPECT_EQ(document.points.get(index).y, expected.points.get(index).y);
+        }
+        EXPECT_EQ(document.flags, expected.flags);
+    }
+
+    // Documents are written one after another, object pointers are indices into the same table
+    std::string WriteDocuments(const jutils::jarray<jreflect::class_interface*>& objects)
+    {
+        std::string output;
+        jreflect::json_writer writer(output);
+        writer.setObjectTable(objects);
+        for (const auto& object : objects)
+        {
+            EXPECT_TRUE(writer.writeObject(object));
+            output.push_back('\n');
+        }
+        return output;
+    }
+    bool ReadDocuments(jreflect::json_reader& reader, json_document (&documents)[2])
+    {
+        jutils::jarray<jreflect::class_interface*> objects;
+        objects.add(&documents[0]);
+        objects.add(&documents[1]);
+        reader.setObjectTable(objects);
+        return reader.readObject(&documents[0]) && reader.readObject(&documents[1]) && reader.isEnd();
+    }
+    bool ReadDocument(const std::string& json, json_document& document)
+    {
+        jreflect::json_reader reader(json.data(), json.size());
+        return reader.readObject(&document) && reader.isEnd();
+    }
+}
+
+TEST(json, round_trip)
+{
+    json_document source[2];
+    FillDocument(source[0], &source[1]);
+    source[1].title = "second";
+    jutils::jarray<jreflect::class_interface*> objects;
+    objects.add(&source[0]);
+    objects.add(&source[1]);
+    const std::string json = WriteDocuments(objects);
+    EXPECT_NE(json.find("\"title\":\"line \\\"one\\\"\\n\\ttab \\\\ \\u0001 end\""), std::string::npos);
+    EXPECT_NE(json.find("\"next\":1"), std::string::npos);
+    EXPECT_NE(json.find("\"next\":null"), std::string::npos);
+
+    json_document loaded[2];
+    loaded[0].values.add(99);
+    jreflect::json_reader reader(json.data(), json.size());
+    ASSERT_TRUE(ReadDocuments(reader, loaded));
+    ExpectSameDocument(loaded[0], source[0]);
+    ExpectSameDocument(loaded[1], source[1]);
+    EXPECT_EQ(loaded[0].next, &loaded[1]);
+    EXPECT_EQ(loaded[1].next, nullptr);
+}
+
+TEST(json, reads_whitespace_unknown_fields_and_escapes)
+{
+    const std::string json = " {\n\t\"unknown\" : { \"nested\": [1, \"two\", {\"three\": null}] },\n"
+        "  \"title\" : \"a\\u00e9\\ud83d\\ude00\\/b\",\r\n  \"values\" : [ ],  \"enabled\" : true , \"skipped\": -1.5e3 } ";
+    json_document document;
+    document.values.add(5);
+    ASSERT_TRUE(ReadDocument(json, document));
+    EXPECT_EQ(document.title, "a\xC3\xA9\xF0\x9F\x98\x80/b");
+    EXPECT_TRUE(document.values.isEmpty());
+    EXPECT_TRUE(document.enabled);
+}
+
+TEST(json, rejects_malformed_input)
+{
+    json_document document;
+    EXPECT_FALSE(ReadDocument("", document));
+    EXPECT_FALSE(ReadDocument("{", document));
+    EXPECT_FALSE(ReadDocument("{\"port\":}", document));
+    EXPECT_FALSE(ReadDocument("{\"port\":70000}", document));
+    EXPECT_FALSE(ReadDocument("{\"port\":\"80\"}", document));
+    EXPECT_FALSE(ReadDocument("{\"enabled\":1}", document));
+    EXPECT_FALSE(ReadDocument("{\"title\":\"unterminated}", document));
+    EXPECT_FALSE(ReadDocument("{\"values\":[1,2}", document));
+    EXPECT_FALSE(ReadDocument("{\"origin\":{\"x\":1,}}", document));
+    EXPECT_FALSE(ReadDocument("{\"port\":1} trailing", document));
+}
+
+TEST(json, reads_mapped_files)
+{
+    json_document source;
+    FillDocument(source, nullptr);
+    jutils::jarray<jreflect::class_interface*> objects;
+    objects.add(&source);
+    const std::string json = WriteDocuments(objects);
+
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "jreflect_test_json.json";
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(json.data(), static_cast<std::streamsize>(json.size()));
+    }
+
+    jreflect::mapped_file file;
+    ASSERT_TRUE(file.open(path.string().c_str()));
+    EXPECT_TRUE(file.isOpen());
+    EXPECT_EQ(file.getSize(), json.size());
+    EXPECT_EQ(std::memcmp(file.getData(), json.data(), json.size()), 0);
+
+    json_document loaded;
+    jreflect::json_reader reader(file);
+    ASSERT_TRUE(reader.readObject(&loaded));
+    EXPECT_TRUE(reader.isEnd());
+    ExpectSameDocument(loaded, source);
+
+    // Moving hands over the mapping, copy-on-write changes stay in memory
+    jreflect::mapped_file movedFile = std::move(file);
+    EXPECT_FALSE(file.isOpen());
+    ASSERT_TRUE(movedFile.isOpen());
+    ASSERT_TRUE(movedFile.open(path.string().c_str(), true));
+    movedFile.getData()[0] = ' ';
+    jreflect::mapped_file otherFile;
+    ASSERT_TRUE(otherFile.open(path.string().c_str()));
+    EXPECT_EQ(otherFile.getData()[0], '{');
+    otherFile.close();
+    EXPECT_FALSE(otherFile.isOpen());
+    EXPECT_EQ(otherFile.getSize(), 0u);
+    movedFile.close();
+
+    std::filesystem::remove(path);
+    EXPECT_FALSE(movedFile.open(path.string().c_str()));
+    EXPECT_FALSE(movedFile.open(nullptr));
+
+    // Empty files can't be mapped
+    {
+        std::ofstream emptyFile(path, std::ios::binary | std::ios::trunc);
+    }
+    EXPECT_FALSE(movedFile.open(path.string().c_str()));
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,134 @@
+﻿// Copyright © 2024 Leonov Maksim. All Rights Reserved.
+
+#include <jreflect/class_type_default.h>
+#include <jreflect/database.h>
+
+#include <gtest/gtest.h>
+
+namespace object_allocator_test
+{
+    class allocated_node : public jreflect::class_interface
+    {
+        JREFLECT_CLASS_TYPE(allocated_node, true)
+    public:
+        allocated_node() = default;
+        virtual ~allocated_node() override { DestroyedCount++; }
+
+        static inline jutils::int32 DestroyedCount = 0;
+
+        jutils::int32 id = 0;
+        jutils::jstring name;
+    };
+}
+
+JREFLECT_INIT_CLASS_TYPE(object_allocator_test, allocated_node, JREFLECT_CLASS_FIELD(id), JREFLECT_CLASS_FIELD(name))
+
+namespace
+{
+    using namespace object_allocator_test;
+
+    allocated_node* CreateNode(jreflect::object_allocator* allocator, const jutils::int32 id)
+    {
+        auto* node = static_cast<allocated_node*>(allocated_node::GetClassType()->createObject(allocator));
+        if (node != nullptr)
+        {
+            node->id = id;
+            node->name = "node";
+        }
+        return node;
+    }
+}
+
+TEST(object_allocator, pool_reuses_destroyed_objects)
+{
+    jreflect::object_pool pool;
+    allocated_node* node1 = CreateNode(&pool, 1);
+    allocated_node* node2 = CreateNode(&pool, 2);
+    ASSERT_NE(node1, nullptr);
+    ASSERT_NE(node2, nullptr);
+    EXPECT_NE(node1, node2);
+    EXPECT_EQ(node1->getClassType(), allocated_node::GetClassType());
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(node1) % alignof(allocated_node), 0u);
+    EXPECT_TRUE(pool.owns(node1));
+
+    const jutils::int32 destroyedCount = allocated_node::DestroyedCount;
+    EXPECT_TRUE(jreflect::class_type::DestroyObject(node1, &pool));
+    EXPECT_EQ(allocated_node::DestroyedCount, destroyedCount + 1);
+    allocated_node* node3 = CreateNode(&pool, 3);
+    EXPECT_EQ(node3, node1);
+    EXPECT_EQ(node3->id, 3);
+    EXPECT_EQ(node2->id, 2);
+
+    EXPECT_TRUE(jreflect::class_type::DestroyObject(node2, &pool));
+    EXPECT_TRUE(jreflect::class_type::DestroyObject(node3, &pool));
+}
+
+TEST(object_allocator, pool_grows_past_one_chunk)
+{
+    jreflect::object_pool pool;
+    jutils::jarray<allocated_node*> nodes;
+    for (jutils::int32 index = 0; index < 100; index++)
+    {
+        nodes.add(CreateNode(&pool, index));
+        ASSERT_NE(nodes.get(index), nullptr);
+    }
+    for (jutils::int32 index = 0; index < nodes.getSize(); index++)
+    {
+        EXPECT_EQ(nodes.get(index)->id, index);
+        EXPECT_TRUE(jreflect::class_type::DestroyObject(nodes.get(index), &pool));
+    }
+}
+
+TEST(object_allocator, arena_creates_and_destroys_objects)
+{
+    jreflect::object_arena arena(256);
+    allocated_node* node1 = CreateNode(&arena, 1);
+    allocated_node* node2 = CreateNode(&arena, 2);
+    ASSERT_NE(node1, nullptr);
+    ASSERT_NE(node2, nullptr);
+    EXPECT_NE(node1, node2);
+    EXPECT_TRUE(arena.owns(node2));
+
+    const jutils::int32 destroyedCount = allocated_node::DestroyedCount;
+    EXPECT_TRUE(jreflect::database::DestroyObject(node1, &arena));
+    EXPECT_TRUE(jreflect::database::DestroyObject(node2, &arena));
+    EXPECT_EQ(allocated_node::DestroyedCount, destroyedCount + 2);
+    arena.reset();
+    EXPECT_FALSE(arena.owns(node1));
+
+    allocated_node* node3 = CreateNode(&arena, 3);
+    ASSERT_NE(node3, nullptr);
+    EXPECT_EQ(node3->id, 3);
+    EXPECT_TRUE(jreflect::database::DestroyObject(node3, &arena));
+}
+
+TEST(object_allocator, rejects_objects_from_elsewhere)
+{
+    jreflect::object_pool pool;
+    jreflect::object_pool otherPool;
+    jreflect::object_arena arena;
+    allocated_node* pooledNode = CreateNode(&pool, 1);
+    ASSERT_NE(pooledNode, nullptr);
+
+    allocated_node stackNode;
+    stackNode.id = 2;
+    const jutils::int32 destroyedCount = allocated_node::DestroyedCount;
+    EXPECT_FALSE(jreflect::class_type::DestroyObject(&stackNode, &pool));
+    EXPECT_FALSE(jreflect::class_type::DestroyObject(&stackNode));
+    EXPECT_FALSE(jreflect::class_type::DestroyObject(pooledNode, &otherPool));
+    EXPECT_FALSE(jreflect::class_type::DestroyObject(pooledNode, &arena));
+    EXPECT_FALSE(jreflect::class_type::DestroyObject(nullptr, &pool));
+    EXPECT_EQ(allocated_node::DestroyedCount, destroyedCount);
+    EXPECT_EQ(stackNode.id, 2);
+
+    // The pool's free list is untouched, so the next objects don't land on the stack
+    allocated_node* node1 = CreateNode(&pool, 3);
+    allocated_node* node2 = CreateNode(&pool, 4);
+    EXPECT_NE(node1, &stackNode);
+    EXPECT_NE(node2, &stackNode);
+    EXPECT_EQ(pooledNode->id, 1);
+
+    EXPECT_TRUE(jreflect::class_type::DestroyObject(pooledNode, &pool));
+    EXPECT_TRUE(jreflect::class_type::DestroyObject(node1, &pool));
+    EXPECT_TRUE(jreflect::class_type::DestroyObject(node2, &pool));
+}
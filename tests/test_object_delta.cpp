@@ -0,0 +1,131 @@
+﻿// Copyright © 2024 Leonov Maksim. All Rights Reserved.
+
+#include <jreflect/class_type_default.h>
+#include <jreflect/object_delta.h>
+
+#include <gtest/gtest.h>
+
+namespace delta_test
+{
+    class inner : public jreflect::class_interface
+    {
+        JREFLECT_CLASS_TYPE(inner, true)
+    public:
+        jutils::int32 value = 0;
+    };
+    class state : public jreflect::class_interface
+    {
+        JREFLECT_CLASS_TYPE(state, true)
+    public:
+        jutils::int32 health = 0;
+        jutils::jstring name;
+        jutils::jarray<jutils::int32> values;
+        inner child;
+    };
+}
+
+JREFLECT_INIT_CLASS_TYPE(delta_test, inner, JREFLECT_CLASS_FIELD(value))
+JREFLECT_INIT_CLASS_TYPE(delta_test, state,
+    JREFLECT_CLASS_FIELD(health), JREFLECT_CLASS_FIELD(name), JREFLECT_CLASS_FIELD(values), JREFLECT_CLASS_FIELD(child)
+)
+
+namespace
+{
+    using namespace delta_test;
+
+    bool ApplyDelta(const state& base, const state& current, state& target, jutils::index_type* outSize = nullptr)
+    {
+        jutils::jarray<jutils::uint8> buffer;
+        jreflect::binary_writer writer(buffer);
+        if (!jreflect::write_object_delta(writer, base, current))
+        {
+            return false;
+        }
+        if (outSize != nullptr)
+        {
+            *outSize = buffer.getSize();
+        }
+        jreflect::binary_reader reader(buffer.getData(), static_cast<std::size_t>(buffer.getSize()));
+        return jreflect::read_object_delta(reader, target) && reader.isEnd();
+    }
+
+    // Field count, field mask with only the array field set, then the array size
+    jutils::jarray<jutils::uint8> MakeArrayDelta(const jutils::index_type arraySize)
+    {
+        auto* classType = state::GetClassType();
+        classType->initialize();
+        const jreflect::class_field_entry* field = classType->findField("values");
+
+        jutils::jarray<jutils::uint8> buffer;
+        jreflect::binary_writer writer(buffer);
+        writer.write(classType->getFieldTable().getSize());
+        writer.write(static_cast<jutils::uint64>(1) << field->index);
+        writer.write(arraySize);
+        return buffer;
+    }
+}
+
+TEST(object_delta, round_trip)
+{
+    state base;
+    base.values = { 1, 2, 3, 4 };
+    base.name = "base";
+    state current = base;
+    current.health = 100;
+    current.values.get(2) = 30;
+    current.values.add(5);
+    current.child.value = 9;
+
+    state client = base;
+    jutils::index_type deltaSize = 0;
+    ASSERT_TRUE(ApplyDelta(base, current, client, &deltaSize));
+    EXPECT_TRUE(jreflect::equals_object(client, current));
+
+    state unchanged = base;
+    jutils::index_type emptyDeltaSize = 0;
+    ASSERT_TRUE(ApplyDelta(base, base, unchanged, &emptyDeltaSize));
+    EXPECT_LT(emptyDeltaSize, deltaSize);
+    EXPECT_TRUE(jreflect::equals_object(unchanged, base));
+}
+
+TEST(object_delta, shrinking_array)
+{
+    state base;
+    base.values = { 1, 2, 3, 4 };
+    state current = base;
+    current.values = { 7 };
+
+    state client = base;
+    ASSERT_TRUE(ApplyDelta(base, current, client));
+    EXPECT_EQ(client.values, current.values);
+}
+
+TEST(object_delta, rejects_corrupted_array_size)
+{
+    for (const jutils::index_type arraySize : { jutils::index_type(0x7FFFFFFF), jutils::index_type(0x40000000), jutils::index_type(-1) })
+    {
+        const jutils::jarray<jutils::uint8> buffer = MakeArrayDelta(arraySize);
+        jreflect::binary_reader reader(buffer.getData(), static_cast<std::size_t>(buffer.getSize()));
+        state object;
+        EXPECT_FALSE(jreflect::read_object_delta(reader, object));
+        EXPECT_TRUE(object.values.isEmpty());
+    }
+}
+
+TEST(object_delta, rejects_truncated_data)
+{
+    state base;
+    state current;
+    current.values = { 1, 2, 3 };
+    current.name = "name";
+
+    jutils::jarray<jutils::uint8> buffer;
+    jreflect::binary_writer writer(buffer);
+    ASSERT_TRUE(jreflect::write_object_delta(writer, base, current));
+    for (jutils::index_type size = 0; size < buffer.getSize(); size++)
+    {
+        jreflect::binary_reader reader(buffer.getData(), static_cast<std::size_t>(size));
+        state object;
+        EXPECT_FALSE(jreflect::read_object_delta(reader, object));
+    }
+}
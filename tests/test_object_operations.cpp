@@ -0,0 +1,128 @@
+﻿// Copyright © 2024 Leonov Maksim. All Rights Reserved.
+
+#include <jreflect/class_type_default.h>
+#include <jreflect/object_operations.h>
+
+#include <gtest/gtest.h>
+
+namespace object_operations_test
+{
+    class component : public jreflect::class_interface
+    {
+        JREFLECT_CLASS_TYPE(component, true)
+    public:
+        jutils::int32 weight = 0;
+        jutils::jstring label;
+    };
+    class assembly : public jreflect::class_interface
+    {
+        JREFLECT_CLASS_TYPE(assembly, true)
+    public:
+        jutils::int64 id = 0;
+        jutils::jstring name;
+        component main;
+        jutils::jarray<jutils::int32> samples;
+        jutils::jarray<component> parts;
+        std::vector<bool> flags;
+        assembly* parent = nullptr;
+        // Not reflected, copies and comparisons ignore it
+        jutils::int32 cache = 0;
+    };
+}
+
+JREFLECT_INIT_CLASS_TYPE(object_operations_test, component, JREFLECT_CLASS_FIELD(weight), JREFLECT_CLASS_FIELD(label))
+JREFLECT_INIT_CLASS_TYPE(object_operations_test, assembly, JREFLECT_CLASS_FIELD(id), JREFLECT_CLASS_FIELD(name), JREFLECT_CLASS_FIELD(main),
+    JREFLECT_CLASS_FIELD(samples), JREFLECT_CLASS_FIELD(parts), JREFLECT_CLASS_FIELD(flags), JREFLECT_CLASS_FIELD(parent))
+
+namespace
+{
+    using namespace object_operations_test;
+
+    void FillAssembly(assembly& object, assembly* parent)
+    {
+        object.id = 42;
+        object.name = "frame";
+        object.main.weight = 7;
+        object.main.label = "main";
+        for (jutils::int32 index = 0; index < 100; index++)
+        {
+            object.samples.add(index * 3);
+        }
+        component& extraPart = object.parts.addDefault();
+        extraPart.weight = 2;
+        extraPart.label = "extra";
+        object.flags = { true, false, true };
+        object.parent = parent;
+        object.cache = 5;
+    }
+}
+
+TEST(object_operations, copy_and_clone)
+{
+    assembly parent;
+    assembly object;
+    FillAssembly(object, &parent);
+
+    assembly copy;
+    ASSERT_TRUE(jreflect::copy_object(copy, object));
+    EXPECT_EQ(copy.id, 42);
+    EXPECT_EQ(copy.name, "frame");
+    EXPECT_EQ(copy.main.label, "main");
+    ASSERT_EQ(copy.samples.getSize(), 100);
+    EXPECT_EQ(copy.samples.get(99), 297);
+    ASSERT_EQ(copy.parts.getSize(), 1);
+    EXPECT_EQ(copy.parts.get(0).label, "extra");
+    EXPECT_EQ(copy.flags, object.flags);
+    EXPECT_EQ(copy.parent, &parent);
+    EXPECT_EQ(copy.cache, 0);
+
+    jreflect::class_interface* clone = jreflect::clone_object(object);
+    ASSERT_NE(clone, nullptr);
+    EXPECT_EQ(clone->getClassType(), assembly::GetClassType());
+    EXPECT_TRUE(jreflect::equals_object(*clone, object));
+    EXPECT_EQ(static_cast<assembly*>(clone)->samples.get(50), 150);
+    EXPECT_TRUE(jreflect::class_type::DestroyObject(clone));
+
+    component otherType;
+    EXPECT_FALSE(jreflect::copy_object(otherType, object));
+}
+
+TEST(object_operations, equals_and_hash)
+{
+    assembly parent;
+    assembly object1;
+    assembly object2;
+    FillAssembly(object1, &parent);
+    FillAssembly(object2, &parent);
+    object2.cache = 9;
+
+    EXPECT_TRUE(jreflect::equals_object(object1, object2));
+    EXPECT_EQ(jreflect::hash_object(object1), jreflect::hash_object(object2));
+    EXPECT_NE(jreflect::hash_object(object1, 1), jreflect::hash_object(object1, 2));
+
+    // Primitive arrays are compared and hashed as one block of storage
+    object2.samples.get(77) = -1;
+    EXPECT_FALSE(jreflect::equals_object(object1, object2));
+    EXPECT_NE(jreflect::hash_object(object1), jreflect::hash_object(object2));
+    object2.samples.get(77) = object1.samples.get(77);
+    object2.samples.add(0);
+    EXPECT_FALSE(jreflect::equals_object(object1, object2));
+    EXPECT_NE(jreflect::hash_object(object1), jreflect::hash_object(object2));
+    object2.samples.removeAt(object2.samples.getSize() - 1);
+    EXPECT_TRUE(jreflect::equals_object(object1, object2));
+
+    object2.parts.get(0).label = "other";
+    EXPECT_FALSE(jreflect::equals_object(object1, object2));
+    object2.parts.get(0).label = "extra";
+    object2.flags[1] = true;
+    EXPECT_FALSE(jreflect::equals_object(object1, object2));
+    object2.flags[1] = false;
+    object2.parent = nullptr;
+    EXPECT_FALSE(jreflect::equals_object(object1, object2));
+    EXPECT_NE(jreflect::hash_object(object1), jreflect::hash_object(object2));
+
+    assembly empty1;
+    assembly empty2;
+    EXPECT_TRUE(jreflect::equals_object(empty1, empty2));
+    EXPECT_EQ(jreflect::hash_object(empty1), jreflect::hash_object(empty2));
+}
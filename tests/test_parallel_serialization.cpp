@@ -0,0 +1,182 @@
+﻿// Copyright © 2024 Leonov Maksim. All Rights Reserved.
+
+#include <jreflect/class_type_default.h>
+#include <jreflect/parallel_serialization.h>
+
+#include <gtest/gtest.h>
+
+namespace parallel_serialization_test
+{
+    class chunk_item : public jreflect::class_interface
+    {
+        JREFLECT_CLASS_TYPE(chunk_item, true)
+    public:
+        jutils::int32 id = 0;
+        jutils::int64 value = 0;
+        chunk_item* next = nullptr;
+    };
+    class chunk_value : public jreflect::class_interface
+    {
+        JREFLECT_CLASS_TYPE(chunk_value, true)
+    public:
+        jutils::int32 id = 0;
+    };
+}
+
+JREFLECT_INIT_CLASS_TYPE(parallel_serialization_test, chunk_item, JREFLECT_CLASS_FIELD(id), JREFLECT_CLASS_FIELD(value), JREFLECT_CLASS_FIELD(next))
+JREFLECT_INIT_CLASS_TYPE(parallel_serialization_test, chunk_value, JREFLECT_CLASS_FIELD(id))
+
+namespace
+{
+    using namespace parallel_serialization_test;
+    using jreflect::parallel_serialization_internal::chunk_info;
+
+    constexpr jutils::index_type ObjectCount = 8;
+
+    // Two threads give one object per chunk, so every chunk has the same size
+    jutils::jarray<jutils::uint8> WriteItems()
+    {
+        chunk_item items[ObjectCount];
+        jreflect::class_interface* objects[ObjectCount];
+        for (jutils::index_type index = 0; index < ObjectCount; index++)
+        {
+            items[index].id = index;
+            items[index].value = index * 100;
+            items[index].next = &items[(index + 1) % ObjectCount];
+            objects[index] = &items[index];
+        }
+        jutils::jarray<jutils::uint8> buffer;
+        EXPECT_TRUE(jreflect::write_objects_parallel(objects, buffer, 2));
+        return buffer;
+    }
+
+    chunk_info* GetChunks(jutils::jarray<jutils::uint8>& buffer, jutils::index_type& outChunkCount)
+    {
+        std::memcpy(&outChunkCount, buffer.getData() + sizeof(jutils::index_type), sizeof(jutils::index_type));
+        return reinterpret_cast<chunk_info*>(buffer.getData() + sizeof(jutils::index_type) * 2);
+    }
+
+    bool ReadItems(const jutils::jarray<jutils::uint8>& buffer, chunk_item (&items)[ObjectCount])
+    {
+        jreflect::class_interface* objects[ObjectCount];
+        for (jutils::index_type index = 0; index < ObjectCount; index++)
+        {
+            objects[index] = &items[index];
+        }
+        return jreflect::read_objects_parallel(buffer.getData(), static_cast<std::size_t>(buffer.getSize()), objects, 2);
+    }
+}
+
+TEST(parallel_serialization, round_trip)
+{
+    jutils::jarray<jutils::uint8> buffer = WriteItems();
+    jutils::index_type chunkCount = 0;
+    GetChunks(buffer, chunkCount);
+    EXPECT_EQ(chunkCount, ObjectCount);
+
+    chunk_item items[ObjectCount];
+    ASSERT_TRUE(ReadItems(buffer, items));
+    for (jutils::index_type index = 0; index < ObjectCount; index++)
+    {
+        EXPECT_EQ(items[index].id, index);
+        EXPECT_EQ(items[index].value, index * 100);
+        EXPECT_EQ(items[index].next, &items[(index + 1) % ObjectCount]);
+    }
+}
+
+TEST(parallel_serialization, pointers_after_classes_without_them)
+{
+    chunk_value values[2];
+    chunk_item items[2];
+    values[0].id = 1;
+    values[1].id = 2;
+    items[0].next = &items[1];
+    items[1].next = &items[0];
+    jreflect::class_interface* const objects[] = { &values[0], &values[1], &items[0], &items[1] };
+    jutils::jarray<jutils::uint8> buffer;
+    ASSERT_TRUE(jreflect::write_objects_parallel(objects, buffer, 2));
+
+    chunk_value readValues[2];
+    chunk_item readItems[2];
+    jreflect::class_interface* const readObjects[] = { &readValues[0], &readValues[1], &readItems[0], &readItems[1] };
+    ASSERT_TRUE(jreflect::read_objects_parallel(buffer.getData(), static_cast<std::size_t>(buffer.getSize()), readObjects, 2));
+    EXPECT_EQ(readValues[0].id, 1);
+    EXPECT_EQ(readValues[1].id, 2);
+    EXPECT_EQ(readItems[0].next, &readItems[1]);
+    EXPECT_EQ(readItems[1].next, &readItems[0]);
+
+    // Without pointer fields there is no index table to build
+    jreflect::class_interface* const valueObjects[] = { &values[0], &values[1] };
+    buffer.clear();
+    ASSERT_TRUE(jreflect::write_objects_parallel(valueObjects, buffer, 2));
+    chunk_value readValuesOnly[2];
+    jreflect::class_interface* const readValueObjects[] = { &readValuesOnly[0], &readValuesOnly[1] };
+    ASSERT_TRUE(jreflect::read_objects_parallel(buffer.getData(), static_cast<std::size_t>(buffer.getSize()), readValueObjects, 2));
+    EXPECT_EQ(readValuesOnly[0].id, 1);
+    EXPECT_EQ(readValuesOnly[1].id, 2);
+}
+
+TEST(parallel_serialization, rejects_overlapping_chunks)
+{
+    jutils::jarray<jutils::uint8> buffer = WriteItems();
+    jutils::index_type chunkCount = 0;
+    chunk_info* chunks = GetChunks(buffer, chunkCount);
+    ASSERT_GE(chunkCount, 2);
+    chunks[1] = chunks[0];
+
+    chunk_item items[ObjectCount];
+    EXPECT_FALSE(ReadItems(buffer, items));
+    for (const auto& object : items)
+    {
+        EXPECT_EQ(object.id, 0);
+        EXPECT_EQ(object.next, nullptr);
+    }
+}
+
+TEST(parallel_serialization, rejects_unsorted_chunks)
+{
+    jutils::jarray<jutils::uint8> buffer = WriteItems();
+    jutils::index_type chunkCount = 0;
+    chunk_info* chunks = GetChunks(buffer, chunkCount);
+    ASSERT_GE(chunkCount, 2);
+    std::swap(chunks[0], chunks[1]);
+
+    chunk_item items[ObjectCount];
+    EXPECT_FALSE(ReadItems(buffer, items));
+}
+
+TEST(parallel_serialization, rejects_chunks_missing_objects)
+{
+    jutils::jarray<jutils::uint8> buffer = WriteItems();
+    jutils::index_type chunkCount = 0;
+    chunk_info* chunks = GetChunks(buffer, chunkCount);
+    ASSERT_GE(chunkCount, 1);
+    chunks[chunkCount - 1].objectCount = 0;
+    chunks[chunkCount - 1].size = 0;
+
+    chunk_item items[ObjectCount];
+    EXPECT_FALSE(ReadItems(buffer, items));
+}
+
+TEST(parallel_serialization, small_inputs_use_one_worker_per_chunk)
+{
+    using jreflect::parallel_serialization_internal::GetWorkerCount;
+    EXPECT_EQ(GetWorkerCount(16, 0), 1u);
+    EXPECT_EQ(GetWorkerCount(16, 1), 1u);
+    EXPECT_EQ(GetWorkerCount(16, 3), 3u);
+    EXPECT_EQ(GetWorkerCount(2, 8), 2u);
+
+    jutils::jarray<jutils::uint8> buffer;
+    ASSERT_TRUE(jreflect::write_objects_parallel({}, buffer, 64));
+    EXPECT_TRUE(jreflect::read_objects_parallel(buffer.getData(), static_cast<std::size_t>(buffer.getSize()), {}, 64));
+
+    chunk_item item;
+    item.id = 7;
+    jreflect::class_interface* objects[] = { &item };
+    buffer.clear();
+    ASSERT_TRUE(jreflect::write_objects_parallel(objects, buffer, 64));
+    chunk_item loadedItem;
+    jreflect::class_interface* loadedObjects[] = { &loadedItem };
+    ASSERT_TRUE(jreflect::read_objects_parallel(buffer.getData(), static_cast<std::size_t>(buffer.getSize()), loadedObjects, 64));
+    EXPECT_EQ(loadedItem.id, 7);
+}
@@ -0,0 +1,170 @@
+﻿// Copyright © 2024 Leonov Maksim. All Rights Reserved.
+
+#include <jreflect/class_type_default.h>
+#include <jreflect/schema.h>
+
+#include <gtest/gtest.h>
+
+namespace schema_test
+{
+    class player_v1 : public jreflect::class_interface
+    {
+        JREFLECT_CLASS_TYPE(player_v1, true)
+    public:
+        jutils::int16 health = 0;
+        jutils::int32 removed = 0;
+        jutils::jstring name;
+    };
+    class player : public jreflect::class_interface
+    {
+        JREFLECT_CLASS_TYPE(player, true)
+    public:
+        jutils::jstring name;
+        jutils::int64 added = 0;
+        jutils::int32 health = 0;
+    };
+
+    class part_v1 : public jreflect::class_interface
+    {
+        JREFLECT_CLASS_TYPE(part_v1, true)
+    public:
+        jutils::int32 value = 0;
+    };
+    class part : public jreflect::class_interface
+    {
+        JREFLECT_CLASS_TYPE(part, true)
+    public:
+        jutils::int64 value = 0;
+        jutils::int32 extra = 0;
+    };
+    class holder_v1 : public jreflect::class_interface
+    {
+        JREFLECT_CLASS_TYPE(holder_v1, true)
+    public:
+        jutils::int32 id = 0;
+        part_v1 child;
+        jutils::jarray<part_v1> children;
+    };
+    class holder : public jreflect::class_interface
+    {
+        JREFLECT_CLASS_TYPE(holder, true)
+    public:
+        jutils::int32 id = 0;
+        part child;
+        jutils::jarray<part> children;
+    };
+}
+
+JREFLECT_INIT_CLASS_TYPE(schema_test, player_v1, JREFLECT_CLASS_FIELD(health), JREFLECT_CLASS_FIELD(removed), JREFLECT_CLASS_FIELD(name))
+JREFLECT_INIT_CLASS_TYPE(schema_test, player, JREFLECT_CLASS_FIELD(name), JREFLECT_CLASS_FIELD(added), JREFLECT_CLASS_FIELD(health))
+JREFLECT_INIT_CLASS_TYPE(schema_test, part_v1, JREFLECT_CLASS_FIELD(value))
+JREFLECT_INIT_CLASS_TYPE(schema_test, part, JREFLECT_CLASS_FIELD(value), JREFLECT_CLASS_FIELD(extra))
+JREFLECT_INIT_CLASS_TYPE(schema_test, holder_v1, JREFLECT_CLASS_FIELD(id), JREFLECT_CLASS_FIELD(child), JREFLECT_CLASS_FIELD(children))
+JREFLECT_INIT_CLASS_TYPE(schema_test, holder, JREFLECT_CLASS_FIELD(id), JREFLECT_CLASS_FIELD(child), JREFLECT_CLASS_FIELD(children))
+
+namespace
+{
+    using namespace schema_test;
+
+    // Schema of an older class layout, stored under the name of the current class
+    jreflect::class_schema MakeOldSchema(jreflect::class_type* oldClassType, const jutils::jstringID& name)
+    {
+        jreflect::class_schema schema = jreflect::make_class_schema(oldClassType);
+        schema.name = name;
+
+        jutils::jarray<jutils::uint8> buffer;
+        jreflect::binary_writer writer(buffer);
+        jreflect::write_class_schema(writer, schema);
+        jreflect::binary_reader reader(buffer.getData(), static_cast<std::size_t>(buffer.getSize()));
+        jreflect::class_schema readSchema;
+        EXPECT_TRUE(jreflect::read_class_schema(reader, readSchema) && reader.isEnd());
+        return readSchema;
+    }
+    jreflect::class_schema SetObjectHash(jreflect::class_schema schema, const jutils::jstringID& name, const jutils::uint64 hash)
+    {
+        for (auto& field : schema.fields)
+        {
+            if (field.name == name)
+            {
+                field.objectHash = hash;
+            }
+        }
+        return schema;
+    }
+}
+
+TEST(schema, identity_for_current_layout)
+{
+    const jreflect::class_schema schema = jreflect::make_class_schema(holder::GetClassType());
+    for (const auto& field : schema.fields)
+    {
+        EXPECT_EQ(field.objectHash != 0, field.name != jutils::jstringID("id"));
+    }
+
+    jreflect::schema_remap remap;
+    ASSERT_TRUE(remap.build(schema, holder::GetClassType()));
+    EXPECT_TRUE(remap.isIdentity());
+}
+
+TEST(schema, remaps_changed_fields)
+{
+    player_v1 oldObject;
+    oldObject.health = -25;
+    oldObject.removed = 7;
+    oldObject.name = "old";
+    jutils::jarray<jutils::uint8> buffer;
+    jreflect::binary_writer writer(buffer);
+    ASSERT_TRUE(writer.writeObject(&oldObject));
+
+    jreflect::schema_remap remap;
+    ASSERT_TRUE(remap.build(MakeOldSchema(player_v1::GetClassType(), player::GetClassType()->getName()), player::GetClassType()));
+    EXPECT_FALSE(remap.isIdentity());
+
+    player object;
+    object.added = 3;
+    jreflect::binary_reader reader(buffer.getData(), static_cast<std::size_t>(buffer.getSize()));
+    ASSERT_TRUE(remap.readObject(reader, &object));
+    EXPECT_TRUE(reader.isEnd());
+    EXPECT_EQ(object.health, -25);
+    EXPECT_EQ(object.name, "old");
+    EXPECT_EQ(object.added, 3);
+}
+
+TEST(schema, rejects_changed_nested_classes)
+{
+    const jreflect::class_schema oldSchema = MakeOldSchema(holder_v1::GetClassType(), holder::GetClassType()->getName());
+    jreflect::schema_remap remap;
+    EXPECT_FALSE(remap.build(oldSchema, holder::GetClassType()));
+    EXPECT_FALSE(remap.isValid());
+
+    // Same class hash, but an array element class changed its layout
+    const jreflect::class_schema currentSchema = jreflect::make_class_schema(holder::GetClassType());
+    const jutils::uint64 oldPartHash = jreflect::make_class_schema(part_v1::GetClassType()).hash;
+    EXPECT_FALSE(remap.build(SetObjectHash(currentSchema, "children", oldPartHash), holder::GetClassType()));
+    EXPECT_FALSE(remap.build(SetObjectHash(currentSchema, "child", oldPartHash), holder::GetClassType()));
+}
+
+TEST(schema, rejects_malformed_input)
+{
+    jutils::jarray<jutils::uint8> buffer;
+    jreflect::binary_writer writer(buffer);
+    jreflect::write_class_schema(writer, jreflect::make_class_schema(player::GetClassType()));
+
+    jreflect::class_schema schema;
+    jreflect::binary_reader reader(buffer.getData(), static_cast<std::size_t>(buffer.getSize()));
+    ASSERT_TRUE(jreflect::read_class_schema(reader, schema));
+    EXPECT_EQ(schema.fields.getSize(), 3);
+
+    // Truncated field table
+    jreflect::binary_reader truncatedReader(buffer.getData(), static_cast<std::size_t>(buffer.getSize() - 1));
+    EXPECT_FALSE(jreflect::read_class_schema(truncatedReader, schema));
+
+    // Field count far beyond the input size
+    jutils::jarray<jutils::uint8> oversized;
+    jreflect::binary_writer oversizedWriter(oversized);
+    oversizedWriter.write(static_cast<jutils::uint32>(0));
+    oversizedWriter.write(static_cast<jutils::uint64>(0));
+    oversizedWriter.write(std::numeric_limits<jutils::index_type>::max());
+    jreflect::binary_reader oversizedReader(oversized.getData(), static_cast<std::size_t>(oversized.getSize()));
+    EXPECT_FALSE(jreflect::read_class_schema(oversizedReader, schema));
+}
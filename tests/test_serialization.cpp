@@ -0,0 +1,88 @@
+﻿// Copyright © 2024 Leonov Maksim. All Rights Reserved.
+
+#include <jreflect/class_type_default.h>
+#include <jreflect/serialization.h>
+
+#include <gtest/gtest.h>
+
+namespace serialization_test
+{
+    class record : public jreflect::class_interface
+    {
+        JREFLECT_CLASS_TYPE(record, true)
+    public:
+        jutils::int32 id = 0;
+        jutils::jstring name;
+        jutils::jarray<jutils::int16> values;
+        record* link = nullptr;
+    };
+    class unrelated_record : public jreflect::class_interface
+    {
+        JREFLECT_CLASS_TYPE(unrelated_record, true)
+    public:
+        jutils::int32 id = 0;
+    };
+}
+
+JREFLECT_INIT_CLASS_TYPE(serialization_test, record, JREFLECT_CLASS_FIELD(id), JREFLECT_CLASS_FIELD(name), JREFLECT_CLASS_FIELD(values),
+    JREFLECT_CLASS_FIELD(link))
+JREFLECT_INIT_CLASS_TYPE(serialization_test, unrelated_record, JREFLECT_CLASS_FIELD(id))
+
+namespace
+{
+    using namespace serialization_test;
+
+    jutils::jarray<jutils::uint8> WriteRecords(record& first, record& second)
+    {
+        first.id = 1;
+        first.name = "first";
+        first.values.add(3);
+        first.values.add(-4);
+        first.link = &second;
+        second.id = 2;
+        second.link = &first;
+
+        jutils::jarray<jutils::uint8> buffer;
+        jreflect::binary_writer writer(buffer);
+        writer.setObjectTable({ &first, &second });
+        EXPECT_TRUE(writer.writeObject(&first));
+        EXPECT_TRUE(writer.writeObject(&second));
+        return buffer;
+    }
+}
+
+TEST(serialization, round_trip)
+{
+    record first;
+    record second;
+    const jutils::jarray<jutils::uint8> buffer = WriteRecords(first, second);
+
+    record loadedFirst;
+    record loadedSecond;
+    jreflect::binary_reader reader(buffer.getData(), static_cast<std::size_t>(buffer.getSize()));
+    reader.setObjectTable({ &loadedFirst, &loadedSecond });
+    ASSERT_TRUE(reader.readObject(&loadedFirst));
+    ASSERT_TRUE(reader.readObject(&loadedSecond));
+    EXPECT_TRUE(reader.isEnd());
+    EXPECT_EQ(loadedFirst.id, 1);
+    EXPECT_EQ(loadedFirst.name, "first");
+    ASSERT_EQ(loadedFirst.values.getSize(), 2);
+    EXPECT_EQ(loadedFirst.values.get(1), -4);
+    EXPECT_EQ(loadedFirst.link, &loadedSecond);
+    EXPECT_EQ(loadedSecond.id, 2);
+    EXPECT_EQ(loadedSecond.link, &loadedFirst);
+}
+
+TEST(serialization, rejects_object_ptr_of_wrong_type)
+{
+    record first;
+    record second;
+    const jutils::jarray<jutils::uint8> buffer = WriteRecords(first, second);
+
+    record loadedFirst;
+    unrelated_record wrongType;
+    jreflect::binary_reader reader(buffer.getData(), static_cast<std::size_t>(buffer.getSize()));
+    reader.setObjectTable({ &loadedFirst, &wrongType });
+    EXPECT_FALSE(reader.readObject(&loadedFirst));
+    EXPECT_EQ(loadedFirst.link, nullptr);
+}
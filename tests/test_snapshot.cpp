@@ -0,0 +1,195 @@
+﻿// Copyright © 2024 Leonov Maksim. All Rights Reserved.
+
+#include <jreflect/class_type_default.h>
+#include <jreflect/snapshot.h>
+
+#include <filesystem>
+#include <fstream>
+
+#include <gtest/gtest.h>
+
+namespace snapshot_test
+{
+    class position : public jreflect::class_interface
+    {
+        JREFLECT_CLASS_TYPE(position, true)
+    public:
+        jutils::int32 x = 0;
+        jutils::int32 y = 0;
+    };
+    class node : public jreflect::class_interface
+    {
+        JREFLECT_CLASS_TYPE(node, true)
+    public:
+        jutils::int64 id = 0;
+        position location;
+        node* next = nullptr;
+        std::string scratch = "default";
+    };
+}
+
+JREFLECT_INIT_CLASS_TYPE(snapshot_test, position, JREFLECT_CLASS_FIELD(x), JREFLECT_CLASS_FIELD(y))
+JREFLECT_INIT_CLASS_TYPE(snapshot_test, node, JREFLECT_CLASS_FIELD(id), JREFLECT_CLASS_FIELD(location), JREFLECT_CLASS_FIELD(next))
+
+namespace
+{
+    using namespace snapshot_test;
+
+    class snapshot_file
+    {
+    public:
+        // Named after the running test, so tests can run in parallel
+        snapshot_file()
+            : m_Path(std::filesystem::temp_directory_path()
+                / (std::string("jreflect_snapshot_") + ::testing::UnitTest::GetInstance()->current_test_info()->name() + ".bin"))
+        {}
+        ~snapshot_file() { std::filesystem::remove(m_Path); }
+
+        [[nodiscard]] std::string getPath() const { return m_Path.string(); }
+
+        void write(const jutils::jarray<jutils::uint8>& buffer) const
+        {
+            std::ofstream file(m_Path, std::ios::binary | std::ios::trunc);
+            file.write(reinterpret_cast<const char*>(buffer.getData()), buffer.getSize());
+        }
+
+    private:
+
+        std::filesystem::path m_Path;
+    };
+
+    // Returns the offset of the object table in a snapshot written by write_snapshot()
+    std::size_t FindObjectTable(const jutils::jarray<jutils::uint8>& buffer)
+    {
+        jreflect::binary_reader reader(buffer.getData(), static_cast<std::size_t>(buffer.getSize()));
+        const auto skipName = [&reader]() {
+            jutils::uint32 size = 0;
+            return reader.read(size) && reader.skipBytes(size);
+        };
+
+        jutils::index_type classCount = 0;
+        jutils::index_type objectCount = 0;
+        EXPECT_TRUE(reader.skipBytes(sizeof(jutils::uint32) * 2) && reader.read(classCount) && reader.read(objectCount));
+        for (jutils::index_type classIndex = 0; classIndex < classCount; classIndex++)
+        {
+            jutils::index_type fieldCount = 0;
+            EXPECT_TRUE(skipName() && reader.skipBytes(sizeof(jutils::uint64) * 3) && reader.read(fieldCount));
+            for (jutils::index_type fieldIndex = 0; fieldIndex < fieldCount; fieldIndex++)
+            {
+                EXPECT_TRUE(skipName() && reader.skipBytes(sizeof(jutils::uint64) + sizeof(jutils::uint8)));
+            }
+        }
+        return reader.getPosition();
+    }
+    constexpr std::size_t ObjectTableEntrySize = sizeof(jutils::index_type) + sizeof(jutils::uint64);
+
+    jutils::uint64 GetImageOffset(const jutils::jarray<jutils::uint8>& buffer, const std::size_t tableOffset, const jutils::index_type objectIndex)
+    {
+        jutils::uint64 offset = 0;
+        std::memcpy(&offset, buffer.getData() + tableOffset + objectIndex * ObjectTableEntrySize + sizeof(jutils::index_type), sizeof(offset));
+        return offset;
+    }
+    void SetImageOffset(jutils::jarray<jutils::uint8>& buffer, const std::size_t tableOffset, const jutils::index_type objectIndex,
+        const jutils::uint64 offset)
+    {
+        std::memcpy(buffer.getData() + tableOffset + objectIndex * ObjectTableEntrySize + sizeof(jutils::index_type), &offset, sizeof(offset));
+    }
+
+    jutils::jarray<jutils::uint8> WriteNodes(node& first, node& second)
+    {
+        first.id = 1;
+        first.location.x = 10;
+        first.next = &second;
+        second.id = 2;
+        second.location.y = 20;
+        second.next = &first;
+
+        jutils::jarray<jutils::uint8> buffer;
+        EXPECT_TRUE(jreflect::write_snapshot({ &first, &second }, buffer));
+        return buffer;
+    }
+}
+
+TEST(snapshot, round_trip)
+{
+    node first;
+    node second;
+    first.scratch = "changed";
+    const snapshot_file file;
+    file.write(WriteNodes(first, second));
+
+    jreflect::snapshot snapshot;
+    ASSERT_TRUE(snapshot.open(file.getPath().c_str()));
+    ASSERT_EQ(snapshot.getObjects().getSize(), 2);
+
+    const auto* loadedFirst = static_cast<const node*>(snapshot.getObjects().get(0));
+    const auto* loadedSecond = static_cast<const node*>(snapshot.getObjects().get(1));
+    EXPECT_EQ(loadedFirst->getClassType(), node::GetClassType());
+    EXPECT_EQ(loadedFirst->id, 1);
+    EXPECT_EQ(loadedFirst->location.x, 10);
+    EXPECT_EQ(loadedFirst->next, loadedSecond);
+    EXPECT_EQ(loadedFirst->scratch, "default");
+    EXPECT_EQ(loadedSecond->id, 2);
+    EXPECT_EQ(loadedSecond->location.y, 20);
+    EXPECT_EQ(loadedSecond->next, loadedFirst);
+    snapshot.close();
+    EXPECT_FALSE(snapshot.isOpen());
+}
+
+TEST(snapshot, rejects_overlapping_images)
+{
+    node first;
+    node second;
+    jutils::jarray<jutils::uint8> buffer = WriteNodes(first, second);
+    const std::size_t tableOffset = FindObjectTable(buffer);
+    SetImageOffset(buffer, tableOffset, 1, GetImageOffset(buffer, tableOffset, 0));
+
+    const snapshot_file file;
+    file.write(buffer);
+    jreflect::snapshot snapshot;
+    EXPECT_FALSE(snapshot.open(file.getPath().c_str()));
+    EXPECT_TRUE(snapshot.getObjects().isEmpty());
+}
+
+TEST(snapshot, rejects_images_over_the_header)
+{
+    node first;
+    node second;
+    jutils::jarray<jutils::uint8> buffer = WriteNodes(first, second);
+    const std::size_t tableOffset = FindObjectTable(buffer);
+    SetImageOffset(buffer, tableOffset, 0, (tableOffset + alignof(node) - 1) / alignof(node) * alignof(node));
+
+    const snapshot_file file;
+    file.write(buffer);
+    jreflect::snapshot snapshot;
+    EXPECT_FALSE(snapshot.open(file.getPath().c_str()));
+}
+
+TEST(snapshot, rejects_out_of_bounds_images)
+{
+    node first;
+    node second;
+    jutils::jarray<jutils::uint8> buffer = WriteNodes(first, second);
+    const std::size_t tableOffset = FindObjectTable(buffer);
+    SetImageOffset(buffer, tableOffset, 1, static_cast<jutils::uint64>(buffer.getSize()));
+
+    const snapshot_file file;
+    file.write(buffer);
+    jreflect::snapshot snapshot;
+    EXPECT_FALSE(snapshot.open(file.getPath().c_str()));
+}
+
+TEST(snapshot, rejects_oversized_counts)
+{
+    jutils::jarray<jutils::uint8> buffer;
+    jreflect::binary_writer writer(buffer);
+    writer.write(jreflect::snapshot_internal::Magic);
+    writer.write(jreflect::snapshot_internal::Version);
+    writer.write(std::numeric_limits<jutils::index_type>::max());
+    writer.write(static_cast<jutils::index_type>(0));
+
+    const snapshot_file file;
+    file.write(buffer);
+    jreflect::snapshot snapshot;
+    EXPECT_FALSE(snapshot.open(file.getPath().c_str()));
+}
@@ -0,0 +1,152 @@
+﻿// Copyright © 2024 Leonov Maksim. All Rights Reserved.
+
+#include <jreflect/class_type_default.h>
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+namespace static_class_type_test
+{
+    class static_base : public jreflect::class_interface
+    {
+        JREFLECT_CLASS_TYPE(static_base, true)
+    public:
+        jutils::int32 id = 0;
+        jutils::jstring name;
+
+        [[nodiscard]] jutils::int16 getSecret() const { return secret; }
+
+    private:
+        jutils::int16 secret = 0;
+    };
+    class static_child : public static_base
+    {
+        JREFLECT_CLASS_TYPE(static_child, true)
+    public:
+        jutils::int64 weight = 0;
+    };
+    // The parent only has the runtime table
+    class dynamic_parent : public jreflect::class_interface
+    {
+        JREFLECT_CLASS_TYPE(dynamic_parent, true)
+    public:
+        jutils::uint8 kind = 0;
+    };
+    class static_over_dynamic : public dynamic_parent
+    {
+        JREFLECT_CLASS_TYPE(static_over_dynamic, true)
+    public:
+        jutils::uint32 count = 0;
+        bool active = false;
+    };
+}
+
+JREFLECT_STATIC_CLASS_TYPE(static_class_type_test, static_base,
+    JREFLECT_CLASS_FIELD(id), JREFLECT_CLASS_FIELD(name), JREFLECT_CLASS_FIELD(secret)
+)
+JREFLECT_STATIC_CLASS_TYPE(static_class_type_test, static_child, JREFLECT_CLASS_FIELD_NAMED(weight, "mass"))
+JREFLECT_STATIC_CLASS_TYPE(static_class_type_test, static_over_dynamic, JREFLECT_CLASS_FIELD(count), JREFLECT_CLASS_FIELD(active))
+
+JREFLECT_INIT_STATIC_CLASS_TYPE(static_class_type_test, static_base)
+JREFLECT_INIT_STATIC_CLASS_TYPE(static_class_type_test, static_child)
+JREFLECT_INIT_CLASS_TYPE(static_class_type_test, dynamic_parent, JREFLECT_CLASS_FIELD(kind))
+JREFLECT_INIT_STATIC_CLASS_TYPE(static_class_type_test, static_over_dynamic)
+
+namespace
+{
+    using namespace static_class_type_test;
+
+    // The tables are usable in constant expressions
+    static_assert(jreflect::has_static_class_info_v<static_base>);
+    static_assert(!jreflect::has_static_class_info_v<dynamic_parent>);
+    static_assert(std::tuple_size_v<std::remove_const_t<decltype(jreflect::static_class_info<static_base>::fields)>> == 3);
+    static_assert(std::get<2>(jreflect::static_class_info<static_base>::fields).name[0] == 's');
+    static_assert(std::is_same_v<std::remove_cvref_t<decltype(std::get<0>(jreflect::static_class_info<static_child>::fields))>::type, jutils::int64>);
+
+    template<typename T>
+    std::string ListFields(T& object)
+    {
+        std::string result;
+        jreflect::for_each_field(object, [&result](const auto& fieldInfo, auto& value) {
+            result += fieldInfo.name;
+            using value_t = std::remove_cvref_t<decltype(value)>;
+            if constexpr (std::is_same_v<value_t, jutils::jstring>)
+            {
+                result += std::string("=") + value.getString();
+            }
+            else
+            {
+                result += "=" + std::to_string(value);
+            }
+            result += ";";
+        });
+        return result;
+    }
+    template<typename T>
+    jreflect::class_type* GetInitializedClassType()
+    {
+        jreflect::class_type* classType = T::GetClassType();
+        classType->initialize();
+        return classType;
+    }
+}
+
+TEST(static_class_type, for_each_field_visits_the_class_and_its_parents)
+{
+    static_child object;
+    object.id = 4;
+    object.name = "box";
+    object.weight = 12;
+    EXPECT_EQ(ListFields(object), "id=4;name=box;secret=0;mass=12;");
+
+    const static_child& constObject = object;
+    EXPECT_EQ(ListFields(constObject), "id=4;name=box;secret=0;mass=12;");
+
+    jreflect::for_each_field(object, [](const auto&, auto& value) {
+        if constexpr (std::is_integral_v<std::remove_cvref_t<decltype(value)>>)
+        {
+            value += 1;
+        }
+    });
+    EXPECT_EQ(object.id, 5);
+    EXPECT_EQ(object.getSecret(), 1);
+    EXPECT_EQ(object.weight, 13);
+}
+
+TEST(static_class_type, for_each_field_skips_parents_without_a_static_table)
+{
+    static_over_dynamic object;
+    object.kind = 9;
+    object.count = 3;
+    object.active = true;
+    EXPECT_EQ(ListFields(object), "count=3;active=1;");
+
+    // The runtime table still has the parent's fields first
+    const jreflect::class_type* classType = GetInitializedClassType<static_over_dynamic>();
+    ASSERT_EQ(classType->getFieldTable().getSize(), 3);
+    EXPECT_EQ(classType->getFieldTable().get(0).name, jutils::jstringID("kind"));
+    EXPECT_EQ(classType->getFieldTable().get(1).name, jutils::jstringID("count"));
+    EXPECT_EQ(classType->getFieldTable().get(2).name, jutils::jstringID("active"));
+}
+
+TEST(static_class_type, runtime_fields_match_the_static_table)
+{
+    const jreflect::class_type* classType = GetInitializedClassType<static_child>();
+    ASSERT_EQ(classType->getFieldTable().getSize(), 4);
+
+    std::size_t fieldCount = 0;
+    static_child object;
+    jreflect::for_each_field(object, [&](const auto& fieldInfo, auto& value) {
+        const jreflect::class_field_entry* field = classType->findField(fieldInfo.name);
+        ASSERT_NE(field, nullptr);
+        EXPECT_EQ(field->offset, fieldInfo.offset);
+        EXPECT_EQ(field->typeID, jreflect::type_id<std::remove_cvref_t<decltype(value)>>());
+        EXPECT_EQ(field->getValuePtr(&object), &value);
+        EXPECT_EQ(field->index, static_cast<jutils::index_type>(fieldCount));
+        fieldCount++;
+    });
+    EXPECT_EQ(fieldCount, 4u);
+    EXPECT_EQ(classType->findField("weight"), nullptr);
+    EXPECT_TRUE(classType->isDerivedFrom<static_base>());
+}
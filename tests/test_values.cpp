@@ -0,0 +1,380 @@
+﻿// Copyright © 2024 Leonov Maksim. All Rights Reserved.
+
+#include <jreflect/class_type_default.h>
+#include <jreflect/database.h>
+
+#include <gtest/gtest.h>
+
+namespace values_test
+{
+    class item : public jreflect::class_interface
+    {
+        JREFLECT_CLASS_TYPE(item, true)
+    public:
+        jutils::int32 count = 0;
+    };
+    class special_item : public item
+    {
+        JREFLECT_CLASS_TYPE(special_item)
+    };
+    class all_values : public jreflect::class_interface
+    {
+        JREFLECT_CLASS_TYPE(all_values, true)
+    public:
+        bool boolean = false;
+        jutils::int8 int8 = 0;
+        jutils::uint8 uint8 = 0;
+        jutils::int16 int16 = 0;
+        jutils::uint16 uint16 = 0;
+        jutils::int32 int32 = 0;
+        jutils::uint32 uint32 = 0;
+        jutils::int64 int64 = 0;
+        jutils::uint64 uint64 = 0;
+        jutils::jstring string;
+        item object;
+        item* objectPtr = nullptr;
+        jutils::jarray<jutils::int32> array;
+        jutils::jarray<item> objectArray;
+        std::vector<bool> arrayBool;
+    };
+    // Move-only, arrays of it must not need copies
+    class resource : public jreflect::class_interface
+    {
+        JREFLECT_CLASS_TYPE(resource, true)
+    public:
+        jutils::int32 id = 0;
+        std::unique_ptr<jutils::int32> payload;
+    };
+    class resource_list : public jreflect::class_interface
+    {
+        JREFLECT_CLASS_TYPE(resource_list, true)
+    public:
+        jutils::jarray<resource> resources;
+    };
+}
+
+JREFLECT_INIT_CLASS_TYPE(values_test, item, JREFLECT_CLASS_FIELD(count))
+JREFLECT_INIT_CLASS_TYPE(values_test, special_item)
+JREFLECT_INIT_CLASS_TYPE(values_test, all_values,
+    JREFLECT_CLASS_FIELD(boolean), JREFLECT_CLASS_FIELD(int8), JREFLECT_CLASS_FIELD(uint8), JREFLECT_CLASS_FIELD(int16),
+    JREFLECT_CLASS_FIELD(uint16), JREFLECT_CLASS_FIELD(int32), JREFLECT_CLASS_FIELD(uint32), JREFLECT_CLASS_FIELD(int64),
+    JREFLECT_CLASS_FIELD(uint64), JREFLECT_CLASS_FIELD(string), JREFLECT_CLASS_FIELD(object), JREFLECT_CLASS_FIELD(objectPtr),
+    JREFLECT_CLASS_FIELD(array), JREFLECT_CLASS_FIELD(objectArray), JREFLECT_CLASS_FIELD(arrayBool)
+)
+JREFLECT_INIT_CLASS_TYPE(values_test, resource, JREFLECT_CLASS_FIELD(id))
+JREFLECT_INIT_CLASS_TYPE(values_test, resource_list, JREFLECT_CLASS_FIELD(resources))
+
+namespace
+{
+    using namespace values_test;
+
+    const jreflect::class_field_entry* FindField(const char* name)
+    {
+        auto* classType = all_values::GetClassType();
+        classType->initialize();
+        return classType->findField(name);
+    }
+
+    template<jreflect::value_type Type, typename T>
+    void ExpectPrimitive(const char* name, const T& value)
+    {
+        all_values object;
+        const jreflect::class_field_entry* field = FindField(name);
+        ASSERT_NE(field, nullptr);
+        ASSERT_EQ(field->type, Type);
+        const auto* fieldValue = field->fieldValue->cast<Type>();
+        ASSERT_NE(fieldValue, nullptr);
+
+        EXPECT_TRUE(fieldValue->set(field->getValuePtr(&object), value));
+        T result{};
+        EXPECT_TRUE(fieldValue->get(field->getValuePtr(&object), result));
+        EXPECT_EQ(result, value);
+        EXPECT_FALSE(fieldValue->get(nullptr, result));
+    }
+}
+
+TEST(values, field_table_covers_every_value_type)
+{
+    auto* classType = all_values::GetClassType();
+    classType->initialize();
+    EXPECT_EQ(classType->getFieldTable().getSize(), 15);
+    EXPECT_EQ(classType->getName(), jutils::jstringID("all_values"));
+    EXPECT_EQ(FindField("missing"), nullptr);
+}
+
+TEST(values, primitives)
+{
+    ExpectPrimitive<jreflect::value_type::boolean>("boolean", true);
+    ExpectPrimitive<jreflect::value_type::int8>("int8", static_cast<jutils::int8>(-8));
+    ExpectPrimitive<jreflect::value_type::uint8>("uint8", static_cast<jutils::uint8>(200));
+    ExpectPrimitive<jreflect::value_type::int16>("int16", static_cast<jutils::int16>(-1600));
+    ExpectPrimitive<jreflect::value_type::uint16>("uint16", static_cast<jutils::uint16>(60000));
+    ExpectPrimitive<jreflect::value_type::int32>("int32", static_cast<jutils::int32>(-320000));
+    ExpectPrimitive<jreflect::value_type::uint32>("uint32", static_cast<jutils::uint32>(4000000000u));
+    ExpectPrimitive<jreflect::value_type::int64>("int64", static_cast<jutils::int64>(-6400000000ll));
+    ExpectPrimitive<jreflect::value_type::uint64>("uint64", static_cast<jutils::uint64>(18000000000000000000ull));
+    ExpectPrimitive<jreflect::value_type::string>("string", jutils::jstring("text"));
+}
+
+TEST(values, object)
+{
+    all_values object;
+    const jreflect::class_field_entry* field = FindField("object");
+    ASSERT_NE(field, nullptr);
+    const auto* fieldValue = field->fieldValue->cast<jreflect::value_type::object>();
+    ASSERT_NE(fieldValue, nullptr);
+    EXPECT_EQ(fieldValue->getObjectType(), item::GetClassType());
+
+    item source;
+    source.count = 11;
+    EXPECT_TRUE(fieldValue->set(field->getValuePtr(&object), source));
+    EXPECT_EQ(object.object.count, 11);
+
+    item copy;
+    EXPECT_TRUE(fieldValue->get(field->getValuePtr(&object), copy));
+    EXPECT_EQ(copy.count, 11);
+
+    all_values wrongType;
+    EXPECT_FALSE(fieldValue->set(field->getValuePtr(&object), wrongType));
+}
+
+TEST(values, object_ptr)
+{
+    all_values object;
+    const jreflect::class_field_entry* field = FindField("objectPtr");
+    ASSERT_NE(field, nullptr);
+    const auto* fieldValue = field->fieldValue->cast<jreflect::value_type::object_ptr>();
+    ASSERT_NE(fieldValue, nullptr);
+    EXPECT_TRUE(fieldValue->isRawPointer());
+
+    special_item target;
+    EXPECT_TRUE(fieldValue->set(field->getValuePtr(&object), &target));
+    EXPECT_EQ(object.objectPtr, &target);
+
+    jreflect::class_interface* result = nullptr;
+    EXPECT_TRUE(fieldValue->get(field->getValuePtr(&object), result));
+    EXPECT_EQ(result, &target);
+
+    all_values wrongType;
+    EXPECT_FALSE(fieldValue->set(field->getValuePtr(&object), &wrongType));
+    EXPECT_TRUE(fieldValue->set(field->getValuePtr(&object), nullptr));
+    EXPECT_EQ(object.objectPtr, nullptr);
+}
+
+TEST(values, array)
+{
+    all_values object;
+    const jreflect::class_field_entry* field = FindField("array");
+    ASSERT_NE(field, nullptr);
+    const auto* fieldValue = field->fieldValue->cast<jreflect::value_type::array>();
+    ASSERT_NE(fieldValue, nullptr);
+    EXPECT_EQ(fieldValue->getElementValue()->getType(), jreflect::value_type::int32);
+
+    void* arrayPtr = field->getValuePtr(&object);
+    *static_cast<jutils::int32*>(fieldValue->add(arrayPtr)) = 1;
+    *static_cast<jutils::int32*>(fieldValue->add(arrayPtr)) = 4;
+    *static_cast<jutils::int32*>(fieldValue->insert(arrayPtr, 1, 2)) = 2;
+    *static_cast<jutils::int32*>(fieldValue->get(arrayPtr, 2)) = 3;
+    EXPECT_EQ(fieldValue->getSize(arrayPtr), 4);
+    EXPECT_EQ(object.array, (jutils::jarray<jutils::int32>{ 1, 2, 3, 4 }));
+    EXPECT_EQ(fieldValue->getData(arrayPtr), object.array.getData());
+    EXPECT_EQ(fieldValue->getElementStride(), sizeof(jutils::int32));
+
+    fieldValue->remove(arrayPtr, 1, 2);
+    EXPECT_EQ(object.array, (jutils::jarray<jutils::int32>{ 1, 4 }));
+    EXPECT_EQ(fieldValue->get(arrayPtr, 2), nullptr);
+    fieldValue->clear(arrayPtr);
+    EXPECT_EQ(fieldValue->getSize(arrayPtr), 0);
+}
+
+TEST(values, array_of_move_only_objects)
+{
+    auto* classType = resource_list::GetClassType();
+    classType->initialize();
+    const jreflect::class_field_entry* field = classType->findField("resources");
+    ASSERT_NE(field, nullptr);
+    const auto* fieldValue = field->fieldValue->cast<jreflect::value_type::array>();
+    ASSERT_NE(fieldValue, nullptr);
+
+    resource_list object;
+    void* arrayPtr = field->getValuePtr(&object);
+    for (jutils::int32 id = 0; id < 3; id++)
+    {
+        auto* element = static_cast<resource*>(fieldValue->add(arrayPtr));
+        element->id = id;
+        element->payload = std::make_unique<jutils::int32>(id * 10);
+    }
+    auto* inserted = static_cast<resource*>(fieldValue->insert(arrayPtr, 1, 2));
+    ASSERT_NE(inserted, nullptr);
+    EXPECT_EQ(inserted[0].payload, nullptr);
+    EXPECT_EQ(inserted[1].payload, nullptr);
+    inserted[0].id = 10;
+    inserted[1].id = 11;
+
+    ASSERT_EQ(object.resources.getSize(), 5);
+    const jutils::int32 expectedIds[] = { 0, 10, 11, 1, 2 };
+    for (jutils::index_type index = 0; index < 5; index++)
+    {
+        EXPECT_EQ(object.resources.get(index).id, expectedIds[index]);
+    }
+    EXPECT_EQ(*object.resources.get(3).payload, 10);
+    EXPECT_EQ(*object.resources.get(4).payload, 20);
+
+    fieldValue->remove(arrayPtr, 1, 2);
+    ASSERT_EQ(object.resources.getSize(), 3);
+    EXPECT_EQ(*object.resources.get(1).payload, 10);
+}
+
+TEST(values, array_of_objects)
+{
+    all_values object;
+    const jreflect::class_field_entry* field = FindField("objectArray");
+    ASSERT_NE(field, nullptr);
+    const auto* fieldValue = field->fieldValue->cast<jreflect::value_type::array>();
+    ASSERT_NE(fieldValue, nullptr);
+    ASSERT_EQ(fieldValue->getElementValue()->getType(), jreflect::value_type::object);
+
+    void* arrayPtr = field->getValuePtr(&object);
+    static_cast<item*>(fieldValue->add(arrayPtr))->count = 5;
+    EXPECT_EQ(object.objectArray.getSize(), 1);
+    EXPECT_EQ(object.objectArray.get(0).count, 5);
+    EXPECT_EQ(fieldValue->getData(arrayPtr), nullptr);
+}
+
+TEST(values, array_bool)
+{
+    all_values object;
+    const jreflect::class_field_entry* field = FindField("arrayBool");
+    ASSERT_NE(field, nullptr);
+    const auto* fieldValue = field->fieldValue->cast<jreflect::value_type::array_bool>();
+    ASSERT_NE(fieldValue, nullptr);
+
+    void* arrayPtr = field->getValuePtr(&object);
+    EXPECT_TRUE(fieldValue->add(arrayPtr, jutils::index_invalid, true));
+    EXPECT_TRUE(fieldValue->add(arrayPtr, jutils::index_invalid, false));
+    EXPECT_TRUE(fieldValue->set(arrayPtr, 1, true));
+    EXPECT_FALSE(fieldValue->set(arrayPtr, 2, true));
+    EXPECT_EQ(fieldValue->getSize(arrayPtr), 2);
+
+    bool bit = false;
+    EXPECT_TRUE(fieldValue->get(arrayPtr, 1, bit));
+    EXPECT_TRUE(bit);
+    EXPECT_FALSE(fieldValue->get(arrayPtr, 2, bit));
+}
+
+TEST(values, array_bool_word_ops)
+{
+    const jreflect::class_field_entry* field = FindField("arrayBool");
+    ASSERT_NE(field, nullptr);
+    const auto* fieldValue = field->fieldValue->cast<jreflect::value_type::array_bool>();
+    ASSERT_NE(fieldValue, nullptr);
+
+    for (const jutils::index_type size : { 0, 1, 63, 64, 70, 128, 200 })
+    {
+        all_values object;
+        void* arrayPtr = field->getValuePtr(&object);
+        for (jutils::index_type index = 0; index < size; index++)
+        {
+            object.arrayBool.push_back(index % 3 == 0);
+        }
+        const std::vector<bool> initial = object.arrayBool;
+        const jutils::index_type wordCount = jreflect::value_array_bool::GetWordCount(size);
+        EXPECT_EQ(fieldValue->count(arrayPtr), (size + 2) / 3);
+
+        jutils::jarray<jutils::uint64> words;
+        words.resize(wordCount);
+        ASSERT_TRUE(fieldValue->getWords(arrayPtr, words.getData()));
+        for (jutils::index_type index = 0; index < size; index++)
+        {
+            EXPECT_EQ(((words.get(index / 64) >> (index % 64)) & 1) != 0, initial[index]);
+        }
+
+        // Every mask bit is set, including the ones past the end of the array
+        jutils::jarray<jutils::uint64> mask;
+        mask.resize(wordCount);
+        for (auto& word : mask)
+        {
+            word = ~static_cast<jutils::uint64>(0);
+        }
+        ASSERT_TRUE(fieldValue->applyXor(arrayPtr, mask.getData(), wordCount));
+        for (jutils::index_type index = 0; index < size; index++)
+        {
+            EXPECT_EQ(object.arrayBool[index], !initial[index]);
+        }
+        EXPECT_EQ(fieldValue->count(arrayPtr), size - (size + 2) / 3);
+        EXPECT_EQ(fieldValue->findFirstClear(arrayPtr), size > 0 ? 0 : jutils::index_invalid);
+        EXPECT_EQ(fieldValue->findFirstSet(arrayPtr), size > 1 ? 1 : jutils::index_invalid);
+
+        ASSERT_TRUE(fieldValue->applyOr(arrayPtr, mask.getData(), wordCount));
+        EXPECT_EQ(fieldValue->count(arrayPtr), size);
+        EXPECT_EQ(fieldValue->findFirstClear(arrayPtr), jutils::index_invalid);
+#if defined(__GLIBCXX__) && !defined(JREFLECT_DISABLE_VECTOR_BOOL_WORDS)
+        if ((size % 64) != 0)
+        {
+            EXPECT_EQ(object.arrayBool.begin()._M_p[size / 64] & ~((static_cast<jutils::uint64>(1) << (size % 64)) - 1), 0u);
+        }
+#endif
+        object.arrayBool.resize(static_cast<std::size_t>(size) + 10);
+        EXPECT_EQ(fieldValue->count(arrayPtr), size);
+
+        ASSERT_TRUE(fieldValue->setWords(arrayPtr, words.getData(), size));
+        EXPECT_EQ(object.arrayBool, initial);
+        ASSERT_TRUE(fieldValue->applyAnd(arrayPtr, mask.getData(), 0));
+        EXPECT_EQ(object.arrayBool, initial);
+        for (auto& word : mask)
+        {
+            word = 0;
+        }
+        ASSERT_TRUE(fieldValue->applyAnd(arrayPtr, mask.getData(), wordCount));
+        EXPECT_EQ(fieldValue->count(arrayPtr), 0);
+    }
+}
+
+TEST(values, derivation)
+{
+    EXPECT_TRUE(special_item::GetClassType()->isDerivedFrom<item>());
+    EXPECT_FALSE(item::GetClassType()->isDerivedFrom<special_item>());
+    EXPECT_FALSE(all_values::GetClassType()->isDerivedFrom<item>());
+}
+
+TEST(values, database_lookup)
+{
+    auto* database = jreflect::database::GetInstanse();
+    EXPECT_EQ(database->findClassType("item"), item::GetClassType());
+    EXPECT_EQ(database->findClassType("special_item"), special_item::GetClassType());
+    EXPECT_EQ(database->findClassType("all_values"), all_values::GetClassType());
+    EXPECT_EQ(database->findClassType("missing"), nullptr);
+
+    jreflect::class_interface* object = database->createObject("special_item");
+    ASSERT_NE(object, nullptr);
+    EXPECT_EQ(object->getClassType(), special_item::GetClassType());
+    EXPECT_TRUE(jreflect::database::DestroyObject(object));
+}
+
+#if defined(_MSC_VER)
+    #pragma warning(push)
+    #pragma warning(disable: 4996)
+#else
+    #pragma GCC diagnostic push
+    #pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+#endif
+TEST(values, deprecated_create_returns_owned_descriptors)
+{
+    const std::unique_ptr<jreflect::value> int32Value(jreflect::create_value<jutils::int32>());
+    ASSERT_NE(int32Value, nullptr);
+    EXPECT_EQ(int32Value->getType(), jreflect::value_type::int32);
+    EXPECT_NE(int32Value.get(), jreflect::get_value<jutils::int32>());
+
+    const std::unique_ptr<jreflect::value> arrayValue(jreflect::value_info<jutils::jarray<item>>::create());
+    ASSERT_NE(arrayValue, nullptr);
+    EXPECT_EQ(arrayValue->getType(), jreflect::value_type::array);
+    const std::unique_ptr<jreflect::value> objectPtrValue(jreflect::create_value<all_values*>());
+    ASSERT_NE(objectPtrValue, nullptr);
+    EXPECT_EQ(objectPtrValue->getType(), jreflect::value_type::object_ptr);
+    EXPECT_EQ(jreflect::create_value<float>(), nullptr);
+}
+#if defined(_MSC_VER)
+    #pragma warning(pop)
+#else
+    #pragma GCC diagnostic pop
+#endif